@@ -0,0 +1,230 @@
+#include "admin_controller.h"
+#include "../services/change_feed.h"
+#include "../services/db_executor.h"
+#include "../services/doctor_directory.h"
+#include "../services/etag.h"
+#include "../services/logger.h"
+#include "../services/metrics.h"
+#include "../services/notifications.h"
+#include "../services/profiled_mutex.h"
+#include "../services/public_session.h"
+#include "../services/rate_limiter.h"
+#include "../services/single_flight.h"
+#include "../services/slot_push.h"
+#include "../services/slot_catalogue.h"
+#include "../services/stage_timing.h"
+#include "../services/stmt_stats.h"
+#include "../services/traffic_capture.h"
+
+#include <cstdlib>
+#include <string>
+
+namespace {
+
+bool adminAuthorized(const crow::request& req) {
+    static const char* token = std::getenv("ADMIN_TOKEN");
+    if (!token || !*token) {
+        return true;
+    }
+    return req.get_header_value("Authorization") == std::string("Bearer ") + token;
+}
+
+void registerServiceMetrics() {
+    static const char* const kClasses[] = {"static", "read_api", "write_api"};
+    for (int i = 0; i < 3; ++i) {
+        const std::string label = std::string("class=\"") + kClasses[i] + "\"";
+        registerMetricGauge("http_requests_in_flight", label, "Requests currently being handled, by route class.",
+                            [i] { return admissionStats().in_flight[i]; });
+        registerMetricCounter("http_requests_shed_total", label, "Requests rejected with 503 by admission control.",
+                              [i] { return static_cast<double>(admissionStats().shed[i]); });
+    }
+
+    static const char* const kBuckets[] = {"public_session", "dashboard_verify", "slot_status", "api"};
+    for (int i = 0; i < static_cast<int>(RateBucket::Count); ++i) {
+        registerMetricCounter("http_requests_rate_limited_total", std::string("bucket=\"") + kBuckets[i] + "\"",
+                              "Requests rejected with 429 by the per-client rate limiter.",
+                              [i] { return static_cast<double>(rateLimitRejected(static_cast<RateBucket>(i))); });
+    }
+
+    registerMetricGauge("db_requests_waiting", "", "Admitted DB requests not yet answered.",
+                        [] { return admissionStats().waiting_on_db; });
+    registerMetricGauge("db_executor_queue_depth", "", "DB tasks queued but not yet picked up by a worker.",
+                        [] { return static_cast<double>(dbExecutorPending()); });
+    registerMetricGauge("db_executor_workers", "", "DB executor threads (one SQLite connection each).",
+                        [] { return static_cast<double>(dbExecutorWorkers()); });
+    registerMetricGauge("sqlite_busy_ratio", "", "Share of recent DB requests that hit a locked database.",
+                        [] { return admissionStats().busy_rate; });
+    registerMetricCounter("sqlite_busy_total", "", "Statements that had to wait on SQLITE_BUSY.",
+                          [] { return static_cast<double>(admissionStats().busy_total); });
+    registerMetricCounter("db_requests_timed_out_total", "", "DB requests answered 504 after their deadline.",
+                          [] { return static_cast<double>(dbDeadlineStats().timed_out); });
+    registerMetricCounter("db_requests_cancelled_total", "", "DB requests abandoned because the client went away.",
+                          [] { return static_cast<double>(dbDeadlineStats().cancelled); });
+    registerMetricCounter("db_requests_coalesced_total", "", "Reads answered from another request's result.",
+                          [] { return static_cast<double>(coalescedRequests()); });
+
+    registerSessionMapGauge("public_sessions", [] { return publicSessionCount(); });
+
+    registerMetricGauge("doctor_directory_entries", "", "Doctors in the loaded directory snapshot.",
+                        [] { return static_cast<double>(doctorDirectoryStats().doctors); });
+    registerMetricCounter("doctor_directory_loads_total", "", "Times the doctor directory was read from SQLite.",
+                          [] { return static_cast<double>(doctorDirectoryStats().loads); });
+    registerMetricCounter("doctor_directory_invalidations_total", "", "Doctor / category writes that dropped it.",
+                          [] { return static_cast<double>(doctorDirectoryStats().invalidations); });
+    registerMetricCounter("change_feed_transactions_total", "", "Committed transactions published on the change feed.",
+                          [] { return static_cast<double>(changeFeedStats().transactions); });
+    registerMetricCounter("change_feed_rows_total", "", "Row changes published on the change feed.",
+                          [] { return static_cast<double>(changeFeedStats().rows); });
+    registerMetricCounter("change_feed_rollbacks_total", "", "Transactions whose row changes were rolled back.",
+                          [] { return static_cast<double>(changeFeedStats().rollbacks); });
+    registerMetricCounter("http_not_modified_total", "", "Conditional GETs answered 304 from a version check.",
+                          [] { return static_cast<double>(notModifiedResponses()); });
+    registerMetricGauge("slot_push_connections", "", "WebSockets subscribed to live slot status.",
+                        [] { return static_cast<double>(slotPushStats().connections); });
+    registerMetricGauge("slot_push_watched_sets", "", "Distinct doctor/date pairs being watched.",
+                        [] { return static_cast<double>(slotPushStats().watched_sets); });
+    registerMetricCounter("slot_push_messages_total", "", "Slot snapshots and deltas sent to WebSockets.",
+                          [] { return static_cast<double>(slotPushStats().messages); });
+    registerMetricGauge("slot_catalogue_entries", "", "Time slots in the loaded slot catalogue.", [] {
+        const auto catalogue = currentSlotCatalogue();
+        return catalogue ? static_cast<double>(catalogue->slots().size()) : 0.0;
+    });
+
+    for (const ProfiledMutex* m : profiledMutexes()) {
+        const std::string label = std::string("lock=\"") + m->name() + "\"";
+        registerMetricCounter("lock_acquisitions_total", label, "Acquisitions of an instrumented mutex.",
+                              [m] { return static_cast<double>(m->acquisitions()); });
+        registerMetricCounter("lock_contended_total", label, "Acquisitions that had to wait for another holder.",
+                              [m] { return static_cast<double>(m->contended()); });
+        registerMetricCounter("lock_wait_seconds_total", label, "Time spent waiting to acquire the mutex.",
+                              [m] { return m->waitNanos() / 1e9; });
+        registerMetricCounter("lock_hold_seconds_total", label, "Time the mutex was held.",
+                              [m] { return m->holdNanos() / 1e9; });
+    }
+
+    registerMetricGauge("n8n_notification_threads", "", "Detached threads still delivering N8N notifications.",
+                        [] { return static_cast<double>(notificationStats().running); });
+    registerMetricCounter("n8n_notifications_total", "", "N8N notifications started.",
+                          [] { return static_cast<double>(notificationStats().started); });
+
+    registerMetricCounter("log_lines_dropped_total", "", "Log lines dropped because a thread's buffer was full.",
+                          [] { return static_cast<double>(loggerDropped()); });
+    registerMetricCounter("traffic_captured_requests_total", "", "Requests written to the TRAFFIC_CAPTURE file.",
+                          [] { return static_cast<double>(capturedRequests()); });
+}
+
+} // namespace
+
+void registerAdminRoutes(crow::SimpleApp& app)
+{
+    registerServiceMetrics();
+
+    // --------------------------------------------------
+    // GET: Prometheus scrape endpoint
+    // --------------------------------------------------
+    const RouteTag metrics = routeTag("GET /metrics", RouteClass::Static, RoutePriority::Critical);
+    CROW_ROUTE(app, "/metrics").methods("GET"_method)
+    ([metrics](const crow::request& req)
+    {
+        return respondInline(metrics, [&]() {
+            if (!adminAuthorized(req)) {
+                return crow::response(401, "Unauthorized.");
+            }
+            crow::response res(200, renderMetrics());
+            res.set_header("Content-Type", "text/plain; version=0.0.4; charset=utf-8");
+            return res;
+        });
+    });
+
+    // --------------------------------------------------
+    // GET: Per-statement SQLite statistics
+    // --------------------------------------------------
+    const RouteTag admin_statements = routeTag("GET /admin/statements", RouteClass::Static, RoutePriority::Critical);
+    CROW_ROUTE(app, "/admin/statements").methods("GET"_method)
+    ([admin_statements](const crow::request& req)
+    {
+        return respondInline(admin_statements, [&]() {
+            if (!adminAuthorized(req)) {
+                return crow::response(401, "Unauthorized.");
+            }
+
+            crow::json::wvalue result;
+            int i = 0;
+            for (const StatementStats& s : statementStats()) {
+                result[i]["sql"] = s.sql;
+                result[i]["count"] = s.count;
+                result[i]["total_ms"] = s.total_us / 1000.0;
+                result[i]["avg_ms"] = s.count ? s.total_us / 1000.0 / s.count : 0.0;
+                result[i]["p99_ms"] = s.p99_us / 1000.0;
+                result[i]["max_ms"] = s.max_us / 1000.0;
+                result[i]["fullscan_steps"] = s.fullscan_steps;
+                result[i]["sorts"] = s.sorts;
+                result[i]["autoindexes"] = s.autoindexes;
+                result[i]["vm_steps"] = s.vm_steps;
+                i++;
+            }
+            return jsonResponse(200, result);
+        });
+    });
+
+    // --------------------------------------------------
+    // GET: Mean time per request stage, by route
+    // --------------------------------------------------
+    const RouteTag admin_timing = routeTag("GET /admin/timing", RouteClass::Static, RoutePriority::Critical);
+    CROW_ROUTE(app, "/admin/timing").methods("GET"_method)
+    ([admin_timing](const crow::request& req)
+    {
+        return respondInline(admin_timing, [&]() {
+            if (!adminAuthorized(req)) {
+                return crow::response(401, "Unauthorized.");
+            }
+
+            crow::json::wvalue result;
+            int i = 0;
+            for (const RouteTimingStats& s : routeTimingStats()) {
+                result[i]["route"] = routeName(s.route_id);
+                result[i]["requests"] = s.requests;
+                double total = 0.0;
+                for (int stage = 0; stage < static_cast<int>(Stage::Count); ++stage) {
+                    result[i]["avg_ms"][stageName(static_cast<Stage>(stage))] = s.avg_ms[stage];
+                    total += s.avg_ms[stage];
+                }
+                result[i]["avg_ms"]["total"] = total;
+                i++;
+            }
+            return jsonResponse(200, result);
+        });
+    });
+
+    // --------------------------------------------------
+    // GET: Wait and hold times of the session / context mutexes
+    // --------------------------------------------------
+    const RouteTag admin_locks = routeTag("GET /admin/locks", RouteClass::Static, RoutePriority::Critical);
+    CROW_ROUTE(app, "/admin/locks").methods("GET"_method)
+    ([admin_locks](const crow::request& req)
+    {
+        return respondInline(admin_locks, [&]() {
+            if (!adminAuthorized(req)) {
+                return crow::response(401, "Unauthorized.");
+            }
+
+            crow::json::wvalue result;
+            int i = 0;
+            for (const LockStats& s : lockStats()) {
+                result[i]["lock"] = s.name;
+                result[i]["acquisitions"] = s.acquisitions;
+                result[i]["contended"] = s.contended;
+                result[i]["wait_total_ms"] = s.wait_ns / 1e6;
+                result[i]["wait_p50_us"] = s.wait_p50_ns / 1000.0;
+                result[i]["wait_p99_us"] = s.wait_p99_ns / 1000.0;
+                result[i]["wait_max_us"] = s.wait_max_ns / 1000.0;
+                result[i]["hold_total_ms"] = s.hold_ns / 1e6;
+                result[i]["hold_p50_us"] = s.hold_p50_ns / 1000.0;
+                result[i]["hold_p99_us"] = s.hold_p99_ns / 1000.0;
+                result[i]["hold_max_us"] = s.hold_max_ns / 1000.0;
+                i++;
+            }
+            return jsonResponse(200, result);
+        });
+    });
+}
@@ -0,0 +1,8 @@
+#pragma once
+
+#include <crow.h>
+
+// Operational endpoints (/metrics, /admin/statements, /admin/timing,
+// /admin/locks). When ADMIN_TOKEN is set they require
+// "Authorization: Bearer <ADMIN_TOKEN>".
+void registerAdminRoutes(crow::SimpleApp& app);
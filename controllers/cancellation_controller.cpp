@@ -1,67 +1,88 @@
 #include "cancellation_controller.h"
 #include "../models/cancellation.h"
 #include "../services/public_session.h"
+#include "../services/db_executor.h"
+#include "../services/stage_timing.h"
+#include "../services/notifications.h"
+#include "../services/request_body.h"
 #include <crow.h>
 #include <sqlite3.h>
-#include "../config/n8n_config.h"
-#include <thread>
 #include <iostream>
 #include <string>
 
+namespace {
+
+struct CancelAppointmentRequest {
+    int appointment_id = 0;
+    int patient_id = 0;
+    std::string_view name;
+    std::string_view email;
+    int age = 0;
+
+    static constexpr auto fields() {
+        return std::make_tuple(requiredField("appointment_id", &CancelAppointmentRequest::appointment_id),
+                               requiredField("patient_id", &CancelAppointmentRequest::patient_id),
+                               requiredField("name", &CancelAppointmentRequest::name),
+                               requiredField("email", &CancelAppointmentRequest::email),
+                               requiredField("age", &CancelAppointmentRequest::age));
+    }
+};
+
+} // namespace
+
 void registerCancellationRoutes(crow::SimpleApp& app, sqlite3* db) {
+    const RouteTag cancel_appointment = routeTag("POST /cancel_appointment", RouteClass::WriteApi, RoutePriority::Critical);
     CROW_ROUTE(app, "/cancel_appointment").methods("POST"_method)
-    ([db](const crow::request& req) {
-        if (!publicSessionValid(req)) {
-            return crow::response(401, "Please refresh and try again.");
-        }
+    ([cancel_appointment](const crow::request& req, crow::response& res)
+    {
+        respondFromDb(req, res, cancel_appointment, [](const crow::request& req, sqlite3* db)
+        {
+            if (!publicSessionValid(req)) {
+                return crow::response(401, "Please refresh and try again.");
+            }
 
-        auto body = crow::json::load(req.body);
-        if (!body) return crow::response(400, "Please send a valid request.");
+            const auto body = parseBody<CancelAppointmentRequest>(req);
+            if (!body) return crow::response(400, body.error());
 
-        // Fixed r_string incompatibility by explicitly creating std::string
-        int appointment_id = body.has("appointment_id") ? body["appointment_id"].i() : -1;
-        int patient_id     = body.has("patient_id")     ? body["patient_id"].i()     : -1;
-        std::string name   = body.has("name")           ? std::string(body["name"].s())   : "";
-        std::string email  = body.has("email")          ? std::string(body["email"].s())  : "";
-        int age            = body.has("age")            ? body["age"].i()            : -1;
+            int appointment_id = body->appointment_id;
+            int patient_id     = body->patient_id;
+            std::string name   = std::string(body->name);
+            std::string email  = std::string(body->email);
+            int age            = body->age;
 
-        if (appointment_id <= 0 || patient_id <= 0 || name.empty() || email.empty())
-            return crow::response(400, "Please provide all required details.");
+            if (appointment_id <= 0 || patient_id <= 0 || name.empty() || email.empty())
+                return crow::response(400, "Please provide all required details.");
 
-        // --- Fetch patient info & VERIFY identity ---
-        PatientInfo info;
-        bool verified = Cancellation::getPatientInfoForCancellation(db, patient_id, name, email, age, info);
+            // --- Fetch patient info & VERIFY identity ---
+            PatientInfo info;
+            bool verified = Cancellation::getPatientInfoForCancellation(db, patient_id, name, email, age, info);
 
-        if (!verified) {
-            return crow::response(403, "Sorry, we could not verify those details. Please check and try again.");
-        }
+            if (!verified) {
+                return crow::response(403, "Sorry, we could not verify those details. Please check and try again.");
+            }
 
-        // --- Update status in DB (No deletion) ---
-        bool ok = Cancellation::cancelAppointment(db, appointment_id, patient_id);
+            // --- Update status in DB (No deletion) ---
+            bool ok = Cancellation::cancelAppointment(db, appointment_id, patient_id);
 
-        // --- Respond to client ---
-        crow::json::wvalue res;
-        res["success"] = ok;
-        res["message"] = ok ? "Your appointment has been cancelled successfully." 
-                            : "Sorry, we could not cancel the appointment right now. Please try again.";
-        auto response = crow::response(ok ? 200 : 500, res);
+            // --- Respond to client ---
+            crow::json::wvalue res;
+            res["success"] = ok;
+            res["message"] = ok ? "Your appointment has been cancelled successfully." 
+                                : "Sorry, we could not cancel the appointment right now. Please try again.";
+            auto response = jsonResponse(ok ? 200 : 500, res);
 
-        // --- Send to N8N ---
-        if (ok) {
-            crow::json::wvalue payload;
-            payload["patient_id"] = patient_id;
-            payload["appointment_id"] = appointment_id;
-            payload["status"] = "cancelled";
-            payload["name"] = info.name;
-            payload["age"] = info.age;
-            payload["email"] = info.email;
-            payload["request"] = "Cancelled the booking";
+            // --- Send to N8N ---
+            if (ok) {
+                crow::json::wvalue payload;
+                assignFields(payload, info);
+                payload["appointment_id"] = appointment_id;
+                payload["status"] = "cancelled";
+                payload["request"] = "Cancelled the booking";
 
-            std::thread([payload]() {
-                sendToN8N(payload);
-            }).detach();
-        }
+                notifyN8NAsync(std::move(payload));
+            }
 
-        return response;
+            return response;
+        });
     });
 }
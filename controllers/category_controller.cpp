@@ -6,9 +6,20 @@
 #include <unordered_map>
 #include <mutex>
 #include <chrono>
-#include <random>
 #include "../models/category.h"
 #include "../services/public_session.h"
+#include "../services/rate_limiter.h"
+#include "../services/change_feed.h"
+#include "../services/response_cache.h"
+#include "../services/session_tokens.h"
+#include "../services/sql_statements.h"
+#include "../services/db_executor.h"
+#include "../services/json_writer.h"
+#include "../services/request_body.h"
+#include "../services/stage_timing.h"
+#include "../services/logger.h"
+#include "../services/metrics.h"
+#include "../services/profiled_mutex.h"
 #include "category_controller.h"
 
 namespace {
@@ -19,22 +30,35 @@ struct CategoryContext {
     std::chrono::system_clock::time_point expires_at;
 };
 
-std::unordered_map<std::string, CategoryContext> g_category_contexts;
-std::mutex g_category_mutex;
+struct CategoryContextRequest {
+    int category_id = 0;
 
-std::string generateCategoryToken() {
-    static std::random_device rd;
-    static std::mt19937_64 gen(rd());
-    std::uniform_int_distribution<unsigned long long> dis;
+    static constexpr auto fields() {
+        return std::make_tuple(requiredField("category_id", &CategoryContextRequest::category_id));
+    }
+};
 
-    std::ostringstream out;
-    out << std::hex << dis(gen) << dis(gen);
-    return out.str();
-}
+struct AddCategoryRequest {
+    std::string_view category_name;
+    std::string_view description;
+
+    static constexpr auto fields() {
+        return std::make_tuple(requiredField("category_name", &AddCategoryRequest::category_name),
+                               requiredField("description", &AddCategoryRequest::description));
+    }
+};
+
+std::unordered_map<std::string, CategoryContext> g_category_contexts;
+ProfiledMutex g_category_mutex("category_contexts");
+
+// The /get_categories body, dropped by the change feed whenever a Category
+// row changes.
+ResponseCache g_categories_cache("categories", std::chrono::seconds(60));
 
 void pruneCategoryContexts() {
+    StageTimer timer(Stage::Context);
     const auto now = std::chrono::system_clock::now();
-    std::lock_guard<std::mutex> lock(g_category_mutex);
+    std::lock_guard<ProfiledMutex> lock(g_category_mutex);
     for (auto it = g_category_contexts.begin(); it != g_category_contexts.end();) {
         if (it->second.expires_at <= now) {
             it = g_category_contexts.erase(it);
@@ -45,44 +69,13 @@ void pruneCategoryContexts() {
 }
 
 std::string getCategoryTokenFromRequest(const crow::request& req) {
-    const std::string auth_header = req.get_header_value("Authorization");
-    const std::string prefix = "Bearer ";
-    if (auth_header.rfind(prefix, 0) == 0) {
-        return auth_header.substr(prefix.size());
-    }
-
-    const std::string cookie = req.get_header_value("Cookie");
-    if (cookie.empty()) {
-        return "";
-    }
-
-    size_t start = 0;
-    while (start < cookie.size()) {
-        size_t end = cookie.find(';', start);
-        if (end == std::string::npos) {
-            end = cookie.size();
-        }
-
-        size_t eq = cookie.find('=', start);
-        if (eq != std::string::npos && eq < end) {
-            std::string k = cookie.substr(start, eq - start);
-            while (!k.empty() && k.front() == ' ') {
-                k.erase(k.begin());
-            }
-            if (k == "category_token") {
-                return cookie.substr(eq + 1, end - (eq + 1));
-            }
-        }
-
-        start = end + 1;
-    }
-
-    return "";
+    return bearerOrCookieToken(req, "category_token");
 }
 
 bool getCategoryContext(const std::string& token, CategoryContext& out) {
+    StageTimer timer(Stage::Context);
     pruneCategoryContexts();
-    std::lock_guard<std::mutex> lock(g_category_mutex);
+    std::lock_guard<ProfiledMutex> lock(g_category_mutex);
     auto it = g_category_contexts.find(token);
     if (it == g_category_contexts.end()) {
         return false;
@@ -96,165 +89,183 @@ bool getCategoryContext(const std::string& token, CategoryContext& out) {
 using namespace std;
 
 void registerCategoryRoutes(crow::SimpleApp& app, sqlite3* db) {
+    registerSessionMapGauge("category_contexts", [] {
+        std::lock_guard<ProfiledMutex> lock(g_category_mutex);
+        return g_category_contexts.size();
+    });
+    registerResponseCacheMetrics(g_categories_cache);
+    subscribeChanges({"Category"}, [](const std::vector<RowChange>&) { g_categories_cache.invalidate(); });
 
     // POST: Create category context
+    const RouteTag category_context_post = routeTag("POST /category_context", RouteClass::ReadApi);
     CROW_ROUTE(app, "/category_context").methods("POST"_method)
-    ([db](const crow::request& req) {
-        if (!publicSessionValid(req)) {
-            return crow::response(401, "Please refresh and try again.");
-        }
-
-        auto body = crow::json::load(req.body);
-        if (!body || !body.has("category_id")) {
-            return crow::response(400, "Please provide category_id.");
-        }
-
-        const int category_id = body["category_id"].i();
-        if (category_id <= 0) {
-            return crow::response(400, "Please provide a valid category_id.");
-        }
+    ([category_context_post](const crow::request& req, crow::response& res)
+    {
+        respondFromDb(req, res, category_context_post, [](const crow::request& req, sqlite3* db)
+        {
+            if (!publicSessionValid(req)) {
+                return crow::response(401, "Please refresh and try again.");
+            }
 
-        sqlite3_stmt* stmt = nullptr;
-        const char* sql = "SELECT category_name FROM Category WHERE category_id = ? LIMIT 1";
-        if (sqlite3_prepare_v2(db, sql, -1, &stmt, nullptr) != SQLITE_OK) {
-            return crow::response(500, "Sorry, we couldn't load the category right now.");
-        }
+            const auto body = parseBody<CategoryContextRequest>(req);
+            if (!body) {
+                return crow::response(400, body.error());
+            }
 
-        sqlite3_bind_int(stmt, 1, category_id);
-        std::string category_name;
-        if (sqlite3_step(stmt) == SQLITE_ROW) {
-            category_name = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 0));
-        }
-        sqlite3_finalize(stmt);
+            const int category_id = body->category_id;
+            if (category_id <= 0) {
+                return crow::response(400, "Please provide a valid category_id.");
+            }
 
-        if (category_name.empty()) {
-            return crow::response(404, "Category not found.");
-        }
+            std::string category_name;
+            {
+                auto row = query(db, sql::kCategoryName, category_id);
+                if (row.step()) {
+                    category_name = row.get<0>();
+                } else if (!row.done()) {
+                    return crow::response(500, "Sorry, we couldn't load the category right now.");
+                }
+            }
 
-        const std::string token = generateCategoryToken();
-        const auto expires_at = std::chrono::system_clock::now() + std::chrono::minutes(15);
-        {
-            std::lock_guard<std::mutex> lock(g_category_mutex);
-            g_category_contexts[token] = {category_id, category_name, expires_at};
-        }
+            if (category_name.empty()) {
+                return crow::response(404, "Category not found.");
+            }
 
-        crow::json::wvalue res;
-        res["success"] = true;
-        res["message"] = "Category context created.";
+            const std::string token = generateToken();
+            const auto expires_at = std::chrono::system_clock::now() + std::chrono::minutes(15);
+            {
+                StageTimer timer(Stage::Context);
+                std::lock_guard<ProfiledMutex> lock(g_category_mutex);
+                g_category_contexts[token] = {category_id, category_name, expires_at};
+            }
 
-        crow::response response(200, res);
-        std::ostringstream cookie;
-        cookie << "category_token=" << token
-               << "; Path=/; Max-Age=900; HttpOnly; SameSite=Strict; Secure";
-        response.add_header("Set-Cookie", cookie.str());
-        return response;
+            crow::json::wvalue res;
+            res["success"] = true;
+            res["message"] = "Category context created.";
+
+            crow::response response = jsonResponse(200, res);
+            std::ostringstream cookie;
+            cookie << "category_token=" << token
+                   << "; Path=/; Max-Age=900; HttpOnly; SameSite=Strict; Secure";
+            response.add_header("Set-Cookie", cookie.str());
+            return response;
+        });
     });
 
     // GET: Category context
+    const RouteTag category_context_get = routeTag("GET /category_context", RouteClass::ReadApi);
     CROW_ROUTE(app, "/category_context").methods("GET"_method)
-    ([db](const crow::request& req) {
-        if (!publicSessionValid(req)) {
-            return crow::response(401, "Please refresh and try again.");
-        }
+    ([category_context_get](const crow::request& req) {
+        return respondInline(req, category_context_get, [&]() {
+            if (!publicSessionValid(req)) {
+                return crow::response(401, "Please refresh and try again.");
+            }
 
-        const std::string token = getCategoryTokenFromRequest(req);
-        if (token.empty()) {
-            return crow::response(401, "Missing category token.");
-        }
+            const std::string token = getCategoryTokenFromRequest(req);
+            if (token.empty()) {
+                return crow::response(401, "Missing category token.");
+            }
 
-        CategoryContext ctx;
-        if (!getCategoryContext(token, ctx)) {
-            return crow::response(401, "Invalid or expired category token.");
-        }
+            CategoryContext ctx;
+            if (!getCategoryContext(token, ctx)) {
+                return crow::response(401, "Invalid or expired category token.");
+            }
 
-        crow::json::wvalue res;
-        res["category_id"] = ctx.category_id;
-        res["category_name"] = ctx.category_name;
-        return crow::response(200, res);
+            crow::json::wvalue res;
+            res["category_id"] = ctx.category_id;
+            res["category_name"] = ctx.category_name;
+            return jsonResponse(200, res);
+        });
     });
 
     // GET all categories
+    const RouteTag get_categories = routeTag("GET /get_categories", RouteClass::ReadApi);
     CROW_ROUTE(app, "/get_categories").methods("GET"_method)
-([db](const crow::request& req) {
-    if (!publicSessionValid(req)) {
-        return crow::response(401, "Please refresh and try again.");
-    }
-
-    sqlite3_stmt* stmt;
-    const char* sql = "SELECT category_id, category_name, description FROM Category";
-
-    if (sqlite3_prepare_v2(db, sql, -1, &stmt, nullptr) != SQLITE_OK) {
-        cerr << "Prepare failed: " << sqlite3_errmsg(db) << endl;
-        return crow::response(500, "Sorry, we couldn't load the categories right now. Please try again.");
-    }
-
-    crow::json::wvalue result;
-    int i = 0;
-
-    while (sqlite3_step(stmt) == SQLITE_ROW) {
-        int id = sqlite3_column_int(stmt, 0);
-        const char* name_ptr = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 1));
-        const char* desc_ptr = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 2));
-
-        std::string name = name_ptr ? name_ptr : "";
-        std::string description = desc_ptr ? desc_ptr : "";
-
-        result[i]["category_id"] = id;
-        result[i]["category_name"] = name;
-        result[i]["description"] = description;
-        i++;
-    }
+    ([get_categories](const crow::request& req, crow::response& res)
+    {
+        if (!rateLimitAllow(req, RateBucket::Api, res)) {
+            endResponse(get_categories, res);
+            return;
+        }
+        if (!publicSessionValid(req)) {
+            res = crow::response(401, "Please refresh and try again.");
+            endResponse(get_categories, res);
+            return;
+        }
+        respondFromCache(req, res, get_categories, g_categories_cache, [](const crow::request& req, sqlite3* db)
+        {
+            // Rows are written out as they are stepped; there is no tree to dump.
+            auto rows = query(db, sql::kCategoriesAll);
+            JsonWriter out(4096);
+            out.beginArray();
+            while (rows.step()) {
+                writeRowObject<Category>(out, rows);
+            }
+            out.endArray();
 
-    sqlite3_finalize(stmt);
-    return crow::response(200, result);
-});
+            if (!rows.done()) {
+                LOG_ERROR("Loading categories failed", "error", sqlite3_errmsg(db));
+                return crow::response(500, "Sorry, we couldn't load the categories right now. Please try again.");
+            }
+            return out.response(200);
+        });
+    });
 
 
     // POST new category
+    const RouteTag add_category = routeTag("POST /add_category", RouteClass::WriteApi, RoutePriority::Low);
     CROW_ROUTE(app, "/add_category").methods("POST"_method)
-([db](const crow::request& req) {
-    if (!publicSessionValid(req)) {
-        return crow::response(401, "Please refresh and try again.");
-    }
-    auto body = crow::json::load(req.body);
-
-    if (!body || !body.has("category_name") || !body.has("description")) {
-        return crow::response(400, "Please provide a category name and description.");
-    }
+    ([add_category](const crow::request& req, crow::response& res)
+    {
+        respondFromDb(req, res, add_category, [](const crow::request& req, sqlite3* db)
+        {
+            if (!publicSessionValid(req)) {
+                return crow::response(401, "Please refresh and try again.");
+            }
+            const auto body = parseBody<AddCategoryRequest>(req);
+            if (!body) {
+                return crow::response(400, body.error());
+            }
 
-    string name = body["category_name"].s();
-    string description = body["description"].s();
+            string name(body->category_name);
+            string description(body->description);
 
-    bool inserted = Category::insert(db, name, description);
+            bool inserted = Category::insert(db, name, description);
 
-    crow::json::wvalue response;
-    response["success"] = inserted;
-    response["message"] =
-        inserted ? "Category added successfully." : "Sorry, we could not add that category right now.";
+            crow::json::wvalue response;
+            response["success"] = inserted;
+            response["message"] =
+                inserted ? "Category added successfully." : "Sorry, we could not add that category right now.";
 
-    return crow::response(200, response);
-});
+            return jsonResponse(200, response);
+        });
+    });
     // DELETE category
+    const RouteTag delete_category = routeTag("DELETE /delete_category/<int>", RouteClass::WriteApi, RoutePriority::Low);
     CROW_ROUTE(app, "/delete_category/<int>").methods("DELETE"_method)
-([db](const crow::request& req, int category_id) {
-    if (!publicSessionValid(req)) {
-        return crow::response(401, "Please refresh and try again.");
-    }
+    ([delete_category](const crow::request& req, crow::response& res, int category_id)
+    {
+        respondFromDb(req, res, delete_category, [category_id](const crow::request& req, sqlite3* db)
+        {
+            if (!publicSessionValid(req)) {
+                return crow::response(401, "Please refresh and try again.");
+            }
 
-    if (category_id <= 0) {
-        return crow::response(400, "Please provide a valid category_id.");
-    }
+            if (category_id <= 0) {
+                return crow::response(400, "Please provide a valid category_id.");
+            }
 
-    bool deleted = Category::remove(db, category_id);
+            bool deleted = Category::remove(db, category_id);
 
-    crow::json::wvalue response;
-    response["success"] = deleted;
-    response["message"] =
-        deleted ? "Category deleted successfully."
-                : "Sorry, that category was not found or has already been deleted.";
+            crow::json::wvalue response;
+            response["success"] = deleted;
+            response["message"] =
+                deleted ? "Category deleted successfully."
+                        : "Sorry, that category was not found or has already been deleted.";
 
-    return crow::response(200, response);
-});
+            return jsonResponse(200, response);
+        });
+    });
 
 
 }
@@ -1,133 +1,165 @@
 #include <crow.h>
 #include <sqlite3.h>
+#include <climits>
+#include <cstdlib>
 #include <vector>
 #include <string>
 #include "../models/doctor.h"          // Doctor model
 #include "../services/public_session.h"
+#include "../services/rate_limiter.h"
+#include "../services/change_feed.h"
+#include "../services/doctor_directory.h"
+#include "../services/response_cache.h"
+#include "../services/db_executor.h"
+#include "../services/request_body.h"
+#include "../services/stage_timing.h"
+#include "../services/logger.h"
+#include "../services/single_flight.h"
+#include "../services/metrics.h"
 #include "doctor_controller.h"         // This controller's header
 
 using namespace std;
+
+namespace {
+
+struct AddDoctorRequest {
+    std::string_view doctor_name;
+    std::string_view phone;
+    std::string_view experience_years;
+    std::string_view qualifications;
+    double ratings = 0;
+    int category_id = 0;
+
+    static constexpr auto fields() {
+        return std::make_tuple(requiredField("doctor_name", &AddDoctorRequest::doctor_name),
+                               requiredField("phone", &AddDoctorRequest::phone),
+                               requiredField("experience_years", &AddDoctorRequest::experience_years),
+                               requiredField("qualifications", &AddDoctorRequest::qualifications),
+                               requiredField("ratings", &AddDoctorRequest::ratings),
+                               requiredField("category_id", &AddDoctorRequest::category_id));
+    }
+};
+
+} // namespace
+
 void registerDoctorRoutes(crow::SimpleApp& app, sqlite3* db) {
+    // category_name is denormalized into the directory, so Category counts too.
+    subscribeChanges({"Doctor", "Category"}, [](const std::vector<RowChange>&) { invalidateDoctorDirectory(); });
 
     // ---------------------------------
     // GET doctors by category (query param version)
     // ---------------------------------
+    const RouteTag get_doctors = routeTag("GET /get_doctors", RouteClass::ReadApi);
     CROW_ROUTE(app, "/get_doctors").methods("GET"_method)
-    ([db](const crow::request& req) {
+    ([get_doctors](const crow::request& req, crow::response& res)
+    {
+        if (!rateLimitAllow(req, RateBucket::Api, res)) {
+            endResponse(get_doctors, res);
+            return;
+        }
         if (!publicSessionValid(req)) {
-            return crow::response(401, "Please refresh and try again.");
+            res = crow::response(401, "Please refresh and try again.");
+            endResponse(get_doctors, res);
+            return;
         }
-        auto query = req.url_params.get("category_id");
-        sqlite3_stmt* stmt;
-        const char* sql = nullptr;
+        // No filter, or one category id.
         int category_id = 0;
-        int cache_key = -1;
-
-        if (query) {
-            category_id = std::stoi(query);
-            cache_key = category_id;
-            sql =
-                "SELECT doctor_id, doctor_name, experience_years, qualification, ratings, category_id "
-                "FROM Doctor WHERE category_id = ?";
-        } else {
-            sql =
-                "SELECT doctor_id, doctor_name, experience_years, qualification, ratings, category_id "
-                "FROM Doctor";
-        }
-
-        if (sqlite3_prepare_v2(db, sql, -1, &stmt, nullptr) != SQLITE_OK) {
-            std::cerr << "SQL error: " << sqlite3_errmsg(db) << std::endl;
-            return crow::response(500, "Sorry, we couldn't load the doctors right now. Please try again.");
-        }
-
-        if (query) {
-            sqlite3_bind_int(stmt, 1, category_id);
+        if (const char* category = req.url_params.get("category_id")) {
+            char* end = nullptr;
+            const long parsed = std::strtol(category, &end, 10);
+            if (end == category || *end != '\0' || parsed <= 0 || parsed > INT_MAX) {
+                res = crow::response(400, "Please provide a valid category_id.");
+                endResponse(get_doctors, res);
+                return;
+            }
+            category_id = static_cast<int>(parsed);
         }
 
-        crow::json::wvalue result;
-        int i = 0;
-
-        while (sqlite3_step(stmt) == SQLITE_ROW) {
-            result[i]["doctor_id"] = sqlite3_column_int(stmt, 0);
-            result[i]["doctor_name"] =
-                reinterpret_cast<const char*>(sqlite3_column_text(stmt, 1));
-            result[i]["experience_years"] =
-                reinterpret_cast<const char*>(sqlite3_column_text(stmt, 2));
-            result[i]["qualifications"] =
-                reinterpret_cast<const char*>(sqlite3_column_text(stmt, 3));
-            result[i]["ratings"] = sqlite3_column_double(stmt, 4);
-            result[i]["category_id"] = sqlite3_column_int(stmt, 5);
-            i++;
+        if (std::shared_ptr<const DoctorDirectory> directory = currentDoctorDirectory()) {
+            const CachedBody& body = category_id ? directory->categoryBody(category_id) : directory->allBody();
+            respondWithCachedBody(req, res, get_doctors, body.json, body.etag);
+            return;
         }
-
-        sqlite3_finalize(stmt);
-        return crow::response(200, result);
+        const std::string key = "doctors:" + (category_id ? std::to_string(category_id) : std::string("*"));
+        respondFromDbCoalesced(req, res, get_doctors, key, [category_id](const crow::request& req, sqlite3* db)
+        {
+            std::shared_ptr<const DoctorDirectory> directory = doctorDirectory(db);
+            if (!directory) {
+                return crow::response(500, "Sorry, we couldn't load the doctors right now. Please try again.");
+            }
+            const CachedBody& body = category_id ? directory->categoryBody(category_id) : directory->allBody();
+            crow::response res(200, body.json);
+            res.set_header("Content-Type", "application/json");
+            res.set_header("ETag", body.etag);
+            return res;
+        });
     });
 
     // ---------------------------------
     // POST add new doctor
     // ---------------------------------
+    const RouteTag add_doctor = routeTag("POST /add_doctor", RouteClass::WriteApi, RoutePriority::Low);
     CROW_ROUTE(app, "/add_doctor").methods("POST"_method)
-    ([db](const crow::request& req) {
-        if (!publicSessionValid(req)) {
-            return crow::response(401, "Please refresh and try again.");
-        }
-
-        auto body = crow::json::load(req.body);
-        if (!body) {
-            return crow::response(400, "Please send a valid request.");
-        }
-
-        if (!body.has("doctor_name") ||
-            !body.has("phone") ||
-            !body.has("experience_years") ||
-            !body.has("qualifications") ||
-            !body.has("ratings") ||
-            !body.has("category_id")) {
-            return crow::response(400, "Please fill in all required fields.");
-        }
-
-        // Extract fields
-        string name = body["doctor_name"].s();
-        string phone = body["phone"].s();
-        string experience = body["experience_years"].s();
-        string degree = body["qualifications"].s();
-        double rating = body["ratings"].d();
-        int category_id = body["category_id"].i();
-
-        // Call insert() directly with proper arguments
-        bool inserted = Doctor::insert(db, name, phone, experience, degree, rating, category_id);
-
-        crow::json::wvalue response;
-        response["success"] = inserted;
-        response["message"] =
-            inserted ? "Doctor added successfully." : "Sorry, we could not add that doctor right now.";
-
-        return crow::response(200, response);
+    ([add_doctor](const crow::request& req, crow::response& res)
+    {
+        respondFromDb(req, res, add_doctor, [](const crow::request& req, sqlite3* db)
+        {
+            if (!publicSessionValid(req)) {
+                return crow::response(401, "Please refresh and try again.");
+            }
+
+            const auto body = parseBody<AddDoctorRequest>(req);
+            if (!body) {
+                return crow::response(400, body.error());
+            }
+
+            // Extract fields
+            string name(body->doctor_name);
+            string phone(body->phone);
+            string experience(body->experience_years);
+            string degree(body->qualifications);
+            double rating = body->ratings;
+            int category_id = body->category_id;
+
+            // Call insert() directly with proper arguments
+            bool inserted = Doctor::insert(db, name, phone, experience, degree, rating, category_id);
+
+            crow::json::wvalue response;
+            response["success"] = inserted;
+            response["message"] =
+                inserted ? "Doctor added successfully." : "Sorry, we could not add that doctor right now.";
+
+            return jsonResponse(200, response);
+        });
     });
 
     // ---------------------------------
     // DELETE doctor
     // ---------------------------------
+    const RouteTag delete_doctor = routeTag("DELETE /delete_doctor/<int>", RouteClass::WriteApi, RoutePriority::Low);
     CROW_ROUTE(app, "/delete_doctor/<int>").methods("DELETE"_method)
-    ([db](const crow::request& req, int doctor_id) {
-        if (!publicSessionValid(req)) {
-            return crow::response(401, "Please refresh and try again.");
-        }
-
-        if (doctor_id <= 0) {
-            return crow::response(400, "Please provide a valid doctor_id.");
-        }
-
-        bool deleted = Doctor::remove(db, doctor_id);
-
-        crow::json::wvalue response;
-        response["success"] = deleted;
-        response["message"] =
-            deleted ? "Doctor deleted successfully."
-                    : "Sorry, that doctor was not found or has already been deleted.";
-
-        return crow::response(200, response);
+    ([delete_doctor](const crow::request& req, crow::response& res, int doctor_id)
+    {
+        respondFromDb(req, res, delete_doctor, [doctor_id](const crow::request& req, sqlite3* db)
+        {
+            if (!publicSessionValid(req)) {
+                return crow::response(401, "Please refresh and try again.");
+            }
+
+            if (doctor_id <= 0) {
+                return crow::response(400, "Please provide a valid doctor_id.");
+            }
+
+            bool deleted = Doctor::remove(db, doctor_id);
+
+            crow::json::wvalue response;
+            response["success"] = deleted;
+            response["message"] =
+                deleted ? "Doctor deleted successfully."
+                        : "Sorry, that doctor was not found or has already been deleted.";
+
+            return jsonResponse(200, response);
+        });
     });
 
 }
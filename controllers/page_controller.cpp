@@ -1,5 +1,7 @@
 #include "page_controller.h"
 #include "../services/public_session.h"
+#include "../services/metrics.h"
+#include "../services/rate_limiter.h"
 
 #include <fstream>
 #include <sstream>
@@ -23,49 +25,60 @@ std::string getMimeType(const std::string& path) {
     return "application/octet-stream";
 }
 
-crow::response serveFile(const std::string& path) {
-    std::ifstream file(path, std::ios::binary);
-    crow::response res;
+crow::response serveFile(const RouteTag& tag, const std::string& path) {
+    return respondInline(tag, [&]() {
+        std::ifstream file(path, std::ios::binary);
+        crow::response res;
 
-    if (!file.is_open()) {
-        res.code = 404;
-        res.write("Sorry, the requested file was not found.");
-        return res;
-    }
+        if (!file.is_open()) {
+            res.code = 404;
+            res.write("Sorry, the requested file was not found.");
+            return res;
+        }
 
-    std::stringstream buffer;
-    buffer << file.rdbuf();
-    res.set_header("Content-Type", getMimeType(path));
-    res.write(buffer.str());
-    return res;
+        std::stringstream buffer;
+        buffer << file.rdbuf();
+        res.set_header("Content-Type", getMimeType(path));
+        res.write(buffer.str());
+        return res;
+    });
 }
 
 } // namespace
 
 void registerPageRoutes(crow::SimpleApp& app)
 {
+    const RouteTag public_session = routeTag("GET /public_session", RouteClass::ReadApi, RoutePriority::Critical);
     CROW_ROUTE(app, "/public_session").methods("GET"_method)
-    ([](const crow::request& req) {
-        crow::response res(204);
-        issuePublicSession(res);
-        return res;
+    ([public_session](const crow::request& req) {
+        return respondInline(req, public_session, [&]() {
+            crow::response limited;
+            if (!rateLimitAllow(req, RateBucket::PublicSession, limited)) {
+                return limited;
+            }
+            crow::response res(204);
+            issuePublicSession(res);
+            return res;
+        });
     });
 
-    CROW_ROUTE(app, "/categories_page")([]() { return serveFile("../public/category.html"); });
-    CROW_ROUTE(app, "/doctors_page")([]() { return serveFile("../public/doctor.html"); });
-    CROW_ROUTE(app, "/schedule_page")([]() { return serveFile("../public/schedule.html"); });
-    CROW_ROUTE(app, "/appointment_page")([]() { return serveFile("../public/appointment.html"); });
-    CROW_ROUTE(app, "/confirmation_page")([]() { return serveFile("../public/confirmation.html"); });
-    CROW_ROUTE(app, "/cancel_appointment_page")([]() { return serveFile("../public/cancellation.html"); });
-    CROW_ROUTE(app, "/doctor_dashboard_page")([]() { return serveFile("../public/doctor_dashboard.html"); });
-    CROW_ROUTE(app, "/controller(mind)")([]() { return serveFile("../public/mind.html"); });
+    const RouteTag page = routeTag("GET /<page>", RouteClass::Static, RoutePriority::Critical);
+    CROW_ROUTE(app, "/categories_page")([page]() { return serveFile(page, "../public/category.html"); });
+    CROW_ROUTE(app, "/doctors_page")([page]() { return serveFile(page, "../public/doctor.html"); });
+    CROW_ROUTE(app, "/schedule_page")([page]() { return serveFile(page, "../public/schedule.html"); });
+    CROW_ROUTE(app, "/appointment_page")([page]() { return serveFile(page, "../public/appointment.html"); });
+    CROW_ROUTE(app, "/confirmation_page")([page]() { return serveFile(page, "../public/confirmation.html"); });
+    CROW_ROUTE(app, "/cancel_appointment_page")([page]() { return serveFile(page, "../public/cancellation.html"); });
+    CROW_ROUTE(app, "/doctor_dashboard_page")([page]() { return serveFile(page, "../public/doctor_dashboard.html"); });
+    CROW_ROUTE(app, "/controller(mind)")([page]() { return serveFile(page, "../public/mind.html"); });
 
-    CROW_ROUTE(app, "/assets/<string>")([](const std::string& filename) {
+    const RouteTag asset = routeTag("GET /assets/<string>", RouteClass::Static, RoutePriority::Critical);
+    CROW_ROUTE(app, "/assets/<string>")([asset](const std::string& filename) {
         if (filename.find("..") != std::string::npos ||
             filename.find('/') != std::string::npos ||
             filename.find('\\') != std::string::npos) {
             return crow::response(400, "Sorry, that file path is not allowed.");
         }
-        return serveFile("../public/assets/" + filename);
+        return serveFile(asset, "../public/assets/" + filename);
     });
 }
@@ -1,10 +1,33 @@
 #include "patient_controller.h"
 #include "../models/patient.h"
 #include "../services/public_session.h"
-#include <iostream>
+#include "../services/db_executor.h"
+#include "../services/stage_timing.h"
+#include "../services/logger.h"
+#include "../services/request_body.h"
 #include <cstdlib>
 #include <ctime>
 
+namespace {
+
+struct AddPatientRequest {
+    std::string_view name;
+    int age = 0;
+    std::string_view email;
+    std::string_view gender;
+    std::string_view request;
+
+    static constexpr auto fields() {
+        return std::make_tuple(requiredField("name", &AddPatientRequest::name),
+                               requiredField("age", &AddPatientRequest::age),
+                               requiredField("email", &AddPatientRequest::email),
+                               requiredField("gender", &AddPatientRequest::gender),
+                               optionalField("request", &AddPatientRequest::request));
+    }
+};
+
+} // namespace
+
 void registerPatientRoutes(crow::SimpleApp& app, sqlite3* db) {
 
     // Seed random once (better in main.cpp ideally)
@@ -17,45 +40,44 @@ void registerPatientRoutes(crow::SimpleApp& app, sqlite3* db) {
     // ---------------------------------
     // POST: Create new patient
     // ---------------------------------
+    const RouteTag add_patient = routeTag("POST /add_patient", RouteClass::WriteApi, RoutePriority::Low);
     CROW_ROUTE(app, "/add_patient").methods("POST"_method)
-    ([db](const crow::request& req) {
-        if (!publicSessionValid(req)) {
-            return crow::response(401, "Please refresh and try again.");
-        }
-
-        auto body = crow::json::load(req.body);
-        if (!body || !body.has("name") || !body.has("age")
-            || !body.has("email") || !body.has("gender")) {
-            return crow::response(400, "Please provide all required patient information.");
-        }
-
-        std::string name   = body["name"].s();
-        int age            = body["age"].i();
-        std::string email  = body["email"].s();
-        std::string gender = body["gender"].s();
-
-        // OPTIONAL field
-        std::string request =
-            body.has("request") && body["request"].t() == crow::json::type::String
-                ? std::string(body["request"].s())
-                : "";
-
-        // --- Generate unique random 6-digit patient_id ---
-        int patient_id;
-        do {
-            patient_id = 100000 + std::rand() % 900000; // 100000–999999
-        } while (Patient::exists(db, patient_id));
-
-        // --- Insert patient ---
-        if (!Patient::insert(db, patient_id, name, age, email, gender, request)) {
-            std::cerr << "[ERROR] Failed to insert patient: " << patient_id << "\n";
-            return crow::response(500, "Sorry, we couldn't save the patient details right now. Please try again.");
-        }
-
-        crow::json::wvalue res;
-        res["success"] = true;
-        res["patient_id"] = patient_id;
-        res["message"] = "Patient added successfully.";
-        return crow::response(200, res);
+    ([add_patient](const crow::request& req, crow::response& res)
+    {
+        respondFromDb(req, res, add_patient, [](const crow::request& req, sqlite3* db)
+        {
+            if (!publicSessionValid(req)) {
+                return crow::response(401, "Please refresh and try again.");
+            }
+
+            const auto body = parseBody<AddPatientRequest>(req);
+            if (!body) {
+                return crow::response(400, body.error());
+            }
+
+            std::string name(body->name);
+            int age = body->age;
+            std::string email(body->email);
+            std::string gender(body->gender);
+            std::string request(body->request); // optional
+
+            // --- Generate unique random 6-digit patient_id ---
+            int patient_id;
+            do {
+                patient_id = 100000 + std::rand() % 900000; // 100000–999999
+            } while (Patient::exists(db, patient_id));
+
+            // --- Insert patient ---
+            if (!Patient::insert(db, patient_id, name, age, email, gender, request)) {
+                LOG_ERROR("Failed to insert patient", "patient_id", patient_id);
+                return crow::response(500, "Sorry, we couldn't save the patient details right now. Please try again.");
+            }
+
+            crow::json::wvalue res;
+            res["success"] = true;
+            res["patient_id"] = patient_id;
+            res["message"] = "Patient added successfully.";
+            return jsonResponse(200, res);
+        });
     });
 }
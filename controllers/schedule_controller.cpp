@@ -1,14 +1,30 @@
 #include "schedule_controller.h"
 #include "../models/schedule.h"
 #include "../services/public_session.h"
+#include "../services/change_feed.h"
+#include "../services/doctor_directory.h"
+#include "../services/etag.h"
+#include "../services/json_writer.h"
+#include "../services/slot_catalogue.h"
+#include "../services/slot_versions.h"
+#include "../services/slot_push.h"
+#include "../services/sql_statements.h"
+#include "../services/request_body.h"
+#include "../services/session_tokens.h"
+#include "../services/db_executor.h"
+#include "../services/stage_timing.h"
+#include "../services/logger.h"
+#include "../services/single_flight.h"
+#include "../services/rate_limiter.h"
+#include "../services/traffic_capture.h"
+#include "../services/metrics.h"
+#include "../services/profiled_mutex.h"
 
-#include <iostream>
 #include <fstream>
 #include <sstream>
 #include <unordered_map>
 #include <mutex>
 #include <chrono>
-#include <random>
 
 namespace {
 
@@ -26,35 +42,77 @@ struct ScheduleContext {
     std::chrono::system_clock::time_point expires_at;
 };
 
-std::unordered_map<std::string, DoctorSession> g_doctor_sessions;
-std::mutex g_session_mutex;
+struct SlotSubscribeMessage {
+    int doctor_id = 0;
+    std::string_view date;
 
-std::unordered_map<std::string, ScheduleContext> g_schedule_contexts;
-std::mutex g_schedule_mutex;
+    static constexpr auto fields() {
+        return std::make_tuple(requiredField("doctor_id", &SlotSubscribeMessage::doctor_id),
+                               requiredField("date", &SlotSubscribeMessage::date));
+    }
+};
 
-std::string generateSessionToken() {
-    static std::random_device rd;
-    static std::mt19937_64 gen(rd());
-    std::uniform_int_distribution<unsigned long long> dis;
+struct ScheduleContextRequest {
+    int doctor_id = 0;
 
-    std::ostringstream out;
-    out << std::hex << dis(gen) << dis(gen);
-    return out.str();
-}
+    static constexpr auto fields() {
+        return std::make_tuple(requiredField("doctor_id", &ScheduleContextRequest::doctor_id));
+    }
+};
 
-std::string generateScheduleToken() {
-    static std::random_device rd;
-    static std::mt19937_64 gen(rd());
-    std::uniform_int_distribution<unsigned long long> dis;
+struct AddSlotRequest {
+    std::string_view time_slot;
 
-    std::ostringstream out;
-    out << std::hex << dis(gen) << dis(gen);
-    return out.str();
-}
+    static constexpr auto fields() {
+        return std::make_tuple(requiredField("time_slot", &AddSlotRequest::time_slot));
+    }
+};
+
+struct BlockSlotRequest {
+    int doctor_id = 0;
+    int schedule_id = 0;
+    std::string_view appointment_date;
+
+    static constexpr auto fields() {
+        return std::make_tuple(requiredField("doctor_id", &BlockSlotRequest::doctor_id),
+                               requiredField("schedule_id", &BlockSlotRequest::schedule_id),
+                               requiredField("appointment_date", &BlockSlotRequest::appointment_date));
+    }
+};
+
+struct DashboardVerifyRequest {
+    std::string_view doctor_name;
+    std::string_view phone;
+
+    static constexpr auto fields() {
+        return std::make_tuple(requiredField("doctor_name", &DashboardVerifyRequest::doctor_name),
+                               requiredField("phone", &DashboardVerifyRequest::phone));
+    }
+};
+
+// Block and unblock from the dashboard; the doctor comes from the token.
+struct DashboardSlotRequest {
+    int schedule_id = 0;
+    std::string_view appointment_date;
+    std::string_view token;
+
+    static constexpr auto fields() {
+        return std::make_tuple(requiredField("schedule_id", &DashboardSlotRequest::schedule_id),
+                               requiredField("appointment_date", &DashboardSlotRequest::appointment_date),
+                               optionalField("token", &DashboardSlotRequest::token));
+    }
+};
+
+std::unordered_map<std::string, DoctorSession> g_doctor_sessions;
+ProfiledMutex g_session_mutex("doctor_sessions");
+
+std::unordered_map<std::string, ScheduleContext> g_schedule_contexts;
+ProfiledMutex g_schedule_mutex("schedule_contexts");
 
 void pruneExpiredSessions() {
+    StageTimer timer(Stage::Context);
     const auto now = std::chrono::system_clock::now();
-    std::lock_guard<std::mutex> lock(g_session_mutex);
+    std::lock_guard<ProfiledMutex> lock(g_session_mutex);
 
     for (auto it = g_doctor_sessions.begin(); it != g_doctor_sessions.end();) {
         if (it->second.expires_at <= now) {
@@ -66,8 +124,9 @@ void pruneExpiredSessions() {
 }
 
 void pruneExpiredScheduleContexts() {
+    StageTimer timer(Stage::Context);
     const auto now = std::chrono::system_clock::now();
-    std::lock_guard<std::mutex> lock(g_schedule_mutex);
+    std::lock_guard<ProfiledMutex> lock(g_schedule_mutex);
     for (auto it = g_schedule_contexts.begin(); it != g_schedule_contexts.end();) {
         if (it->second.expires_at <= now) {
             it = g_schedule_contexts.erase(it);
@@ -78,8 +137,9 @@ void pruneExpiredScheduleContexts() {
 }
 
 int doctorIdFromToken(const std::string& token) {
+    StageTimer timer(Stage::Context);
     pruneExpiredSessions();
-    std::lock_guard<std::mutex> lock(g_session_mutex);
+    std::lock_guard<ProfiledMutex> lock(g_session_mutex);
     auto it = g_doctor_sessions.find(token);
     if (it == g_doctor_sessions.end()) {
         return -1;
@@ -87,9 +147,9 @@ int doctorIdFromToken(const std::string& token) {
     return it->second.doctor_id;
 }
 
-std::string getTokenFromRequest(const crow::request& req, crow::json::rvalue body = crow::json::rvalue()) {
-    if (body && body.has("token") && body["token"].t() == crow::json::type::String) {
-        return std::string(body["token"].s());
+std::string getTokenFromRequest(const crow::request& req, std::string_view body_token = {}) {
+    if (!body_token.empty()) {
+        return std::string(body_token);
     }
 
     const char* query_token = req.url_params.get("token");
@@ -107,44 +167,13 @@ std::string getTokenFromRequest(const crow::request& req, crow::json::rvalue bod
 }
 
 std::string getScheduleTokenFromRequest(const crow::request& req) {
-    auto auth_header = req.get_header_value("Authorization");
-    const std::string prefix = "Bearer ";
-    if (auth_header.rfind(prefix, 0) == 0) {
-        return auth_header.substr(prefix.size());
-    }
-
-    const std::string cookie = req.get_header_value("Cookie");
-    if (cookie.empty()) {
-        return "";
-    }
-
-    size_t start = 0;
-    while (start < cookie.size()) {
-        size_t end = cookie.find(';', start);
-        if (end == std::string::npos) {
-            end = cookie.size();
-        }
-
-        size_t eq = cookie.find('=', start);
-        if (eq != std::string::npos && eq < end) {
-            std::string k = cookie.substr(start, eq - start);
-            while (!k.empty() && k.front() == ' ') {
-                k.erase(k.begin());
-            }
-            if (k == "schedule_token") {
-                return cookie.substr(eq + 1, end - (eq + 1));
-            }
-        }
-
-        start = end + 1;
-    }
-
-    return "";
+    return bearerOrCookieToken(req, "schedule_token");
 }
 
 bool getScheduleContext(const std::string& token, ScheduleContext& out) {
+    StageTimer timer(Stage::Context);
     pruneExpiredScheduleContexts();
-    std::lock_guard<std::mutex> lock(g_schedule_mutex);
+    std::lock_guard<ProfiledMutex> lock(g_schedule_mutex);
     auto it = g_schedule_contexts.find(token);
     if (it == g_schedule_contexts.end()) {
         return false;
@@ -153,609 +182,522 @@ bool getScheduleContext(const std::string& token, ScheduleContext& out) {
     return true;
 }
 
+// Shape check for "YYYY-MM-DD"; an impossible date just never changes.
+bool isIsoDate(std::string_view date) {
+    if (date.size() != 10 || date[4] != '-' || date[7] != '-') {
+        return false;
+    }
+    for (std::size_t i = 0; i < date.size(); ++i) {
+        if (i != 4 && i != 7 && (date[i] < '0' || date[i] > '9')) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Every catalogue slot for a doctor on a date as {schedule_id, time_slot,
+// status}, in time-of-day order; `available_only` drops BOOKED and BLOCKED
+// slots and the status field. BOOKED wins when a slot is both.
+crow::response slotStatusResponse(sqlite3* db, int doctor_id, const std::string& date, bool available_only) {
+    const auto catalogue = slotCatalogue(db);
+    std::vector<SlotStatus> status;
+    if (!catalogue || !querySlotStatuses(db, *catalogue, doctor_id, date, status)) {
+        return crow::response(500, "Sorry, we couldn't load the slots right now. Please try again.");
+    }
+
+    const auto& slots = catalogue->slots();
+    JsonWriter out(64 * slots.size() + 2);
+    out.beginArray();
+    for (size_t i = 0; i < slots.size(); ++i) {
+        if (available_only && status[i] != SlotStatus::Available) {
+            continue;
+        }
+        out.beginObject();
+        writeFields<DoctorSchedule>(out, slots[i]);
+        if (!available_only) {
+            out.key("status").value(slotStatusName(status[i]));
+        }
+        out.endObject();
+    }
+    out.endArray();
+    return out.response(200);
+}
+
 } // namespace
 
 void registerScheduleRoutes(crow::SimpleApp& app, sqlite3* db)
 {
-    // Keep doctor blocking data separate from Appointment to avoid
-    // schema conflicts (Appointment has a unique constraint on doctor+slot).
-    const char* create_blocked_slots_sql =
-        "CREATE TABLE IF NOT EXISTS Doctor_Blocked_Slots ("
-        "  doctor_id INTEGER NOT NULL,"
-        "  schedule_id INTEGER NOT NULL,"
-        "  appointment_date TEXT NOT NULL,"
-        "  created_at TEXT NOT NULL DEFAULT (datetime('now','localtime')),"
-        "  PRIMARY KEY (doctor_id, schedule_id, appointment_date),"
-        "  FOREIGN KEY (doctor_id) REFERENCES Doctor(doctor_id) ON DELETE CASCADE,"
-        "  FOREIGN KEY (schedule_id) REFERENCES Doctor_Schedule(schedule_id) ON DELETE CASCADE"
-        ");";
-    char* err_msg = nullptr;
-    if (sqlite3_exec(db, create_blocked_slots_sql, nullptr, nullptr, &err_msg) != SQLITE_OK) {
-        std::cerr << "[ERROR] Failed to ensure Doctor_Blocked_Slots table: "
-                  << (err_msg ? err_msg : "unknown") << std::endl;
-        sqlite3_free(err_msg);
-    }
+    registerSessionMapGauge("doctor_sessions", [] {
+        std::lock_guard<ProfiledMutex> lock(g_session_mutex);
+        return g_doctor_sessions.size();
+    });
+    registerSessionMapGauge("schedule_contexts", [] {
+        std::lock_guard<ProfiledMutex> lock(g_schedule_mutex);
+        return g_schedule_contexts.size();
+    });
 
+    subscribeChanges({"Doctor_Schedule"}, [](const std::vector<RowChange>&) { invalidateSlotCatalogue(); });
+    subscribeChanges({"Appointment", "Doctor_Blocked_Slots", "Doctor_Schedule"}, slotTablesChanged);
+    subscribeChanges({"Appointment", "Doctor_Blocked_Slots", "Doctor_Schedule"}, slotPushTablesChanged);
+
+    // Load the slot catalogue now so the first slot request doesn't pay for it.
+    if (!slotCatalogue(db)) {
+        LOG_ERROR("Failed to load the slot catalogue");
+    }
 
     // --------------------------------------------------
     // GET: Available slots for a doctor on a given date
     // Exclude BOOKED or BLOCKED
     // --------------------------------------------------
+    const RouteTag get_available_slots = routeTag("GET /get_available_slots/<int>/<string>", RouteClass::ReadApi);
     CROW_ROUTE(app, "/get_available_slots/<int>/<string>").methods("GET"_method)
-    ([db](const crow::request& req, int doctor_id, const std::string& appointment_date)
+    ([get_available_slots](const crow::request& req, crow::response& res, int doctor_id, const std::string& appointment_date)
     {
-        if (!publicSessionValid(req)) {
-            return crow::response(401, "Please refresh and try again.");
-        }
-        sqlite3_stmt* stmt = nullptr;
-
-        const char* sql =
-            "SELECT ds.schedule_id, ds.time_slot "
-            "FROM Doctor_Schedule ds "
-            "WHERE NOT EXISTS ( "
-            "    SELECT 1 "
-            "    FROM Appointment a "
-            "    WHERE a.doctor_id = ? "
-            "      AND a.appointment_date = ? "
-            "      AND a.schedule_id = ds.schedule_id "
-            "      AND a.status = 'BOOKED' "
-            ") "
-            "AND NOT EXISTS ( "
-            "    SELECT 1 "
-            "    FROM Doctor_Blocked_Slots b "
-            "    WHERE b.doctor_id = ? "
-            "      AND b.appointment_date = ? "
-            "      AND b.schedule_id = ds.schedule_id "
-            ") "
-            "ORDER BY ds.time_slot;";
-
-        if (sqlite3_prepare_v2(db, sql, -1, &stmt, nullptr) != SQLITE_OK) {
-            std::cerr << "[ERROR] Prepare failed: " << sqlite3_errmsg(db) << std::endl;
-            return crow::response(500, "Sorry, we couldn't load the slots right now. Please try again.");
-        }
-
-        sqlite3_bind_int(stmt, 1, doctor_id);
-        sqlite3_bind_text(stmt, 2, appointment_date.c_str(), -1, SQLITE_STATIC);
-        sqlite3_bind_int(stmt, 3, doctor_id);
-        sqlite3_bind_text(stmt, 4, appointment_date.c_str(), -1, SQLITE_STATIC);
-
-        crow::json::wvalue result;
-        int index = 0;
-
-        while (sqlite3_step(stmt) == SQLITE_ROW) {
-            result[index]["schedule_id"] = sqlite3_column_int(stmt, 0);
-            result[index]["time_slot"] =
-                std::string(reinterpret_cast<const char*>(sqlite3_column_text(stmt, 1)));
-            index++;
+        if (!rateLimitAllow(req, RateBucket::Api, res)) {
+            endResponse(get_available_slots, res);
+            return;
         }
-
-        sqlite3_finalize(stmt);
-        return crow::response(200, result);
+        if (!publicSessionValid(req)) {
+            res = crow::response(401, "Please refresh and try again.");
+            endResponse(get_available_slots, res);
+            return;
+        }
+        const std::string etag = slotSetEtag(doctor_id, appointment_date);
+        if (etagMatches(req, etag)) {
+            respondNotModified(req, res, get_available_slots, etag);
+            return;
+        }
+        // respondFromDb() without its Api charge, which was taken above.
+        captureRequest(req);
+        submitDbWork(req, res, get_available_slots, [doctor_id, appointment_date, etag](const crow::request& req, sqlite3* db)
+        {
+            crow::response res = slotStatusResponse(db, doctor_id, appointment_date, true);
+            if (res.code == 200) {
+                res.set_header("ETag", etag);
+            }
+            return res;
+        });
     });
 
     // --------------------------------------------------
     // GET: All slots for a doctor on a given date with status
     // --------------------------------------------------
+    const RouteTag get_slots_status = routeTag("GET /get_slots_status/<int>/<string>", RouteClass::ReadApi);
     CROW_ROUTE(app, "/get_slots_status/<int>/<string>").methods("GET"_method)
-    ([db](const crow::request& req, int doctor_id, const std::string& appointment_date)
+    ([get_slots_status](const crow::request& req, crow::response& res, int doctor_id, const std::string& appointment_date)
     {
-        if (!publicSessionValid(req)) {
-            return crow::response(401, "Please refresh and try again.");
-        }
-        const char* sql =
-            "SELECT ds.schedule_id, ds.time_slot, "
-            "       CASE "
-            "         WHEN EXISTS ("
-            "           SELECT 1 FROM Appointment a "
-            "           WHERE a.doctor_id = ? "
-            "             AND a.schedule_id = ds.schedule_id "
-            "             AND a.appointment_date = ? "
-            "             AND a.status = 'BOOKED' "
-            "         ) THEN 'BOOKED' "
-            "         WHEN EXISTS ("
-            "           SELECT 1 FROM Doctor_Blocked_Slots b "
-            "           WHERE b.doctor_id = ? "
-            "             AND b.schedule_id = ds.schedule_id "
-            "             AND b.appointment_date = ? "
-            "         ) THEN 'BLOCKED' "
-            "         ELSE 'AVAILABLE' "
-            "       END AS slot_status "
-            "FROM Doctor_Schedule ds "
-            "ORDER BY ds.time_slot;";
-
-        sqlite3_stmt* stmt = nullptr;
-        if (sqlite3_prepare_v2(db, sql, -1, &stmt, nullptr) != SQLITE_OK) {
-            std::cerr << "[ERROR] Prepare failed: " << sqlite3_errmsg(db) << std::endl;
-            return crow::response(500, "Sorry, we couldn't load the slots right now. Please try again.");
-        }
-
-        sqlite3_bind_int(stmt, 1, doctor_id);
-        sqlite3_bind_text(stmt, 2, appointment_date.c_str(), -1, SQLITE_TRANSIENT);
-        sqlite3_bind_int(stmt, 3, doctor_id);
-        sqlite3_bind_text(stmt, 4, appointment_date.c_str(), -1, SQLITE_TRANSIENT);
-
-        crow::json::wvalue result;
-        int index = 0;
-        while (sqlite3_step(stmt) == SQLITE_ROW) {
-            result[index]["schedule_id"] = sqlite3_column_int(stmt, 0);
-            result[index]["time_slot"] =
-                std::string(reinterpret_cast<const char*>(sqlite3_column_text(stmt, 1)));
-            result[index]["status"] =
-                std::string(reinterpret_cast<const char*>(sqlite3_column_text(stmt, 2)));
-            index++;
+        if (!rateLimitAllow(req, RateBucket::SlotStatus, res) || !rateLimitAllow(req, RateBucket::Api, res)) {
+            endResponse(get_slots_status, res);
+            return;
         }
-        sqlite3_finalize(stmt);
-
-        return crow::response(200, result);
+        if (!publicSessionValid(req)) {
+            res = crow::response(401, "Please refresh and try again.");
+            endResponse(get_slots_status, res);
+            return;
+        }
+        // Read before the query: a write committed meanwhile changes the tag,
+        // so the client refetches rather than keeping a stale body.
+        const std::string etag = slotSetEtag(doctor_id, appointment_date);
+        if (etagMatches(req, etag)) {
+            respondNotModified(req, res, get_slots_status, etag);
+            return;
+        }
+        const std::string key = "slots:" + std::to_string(doctor_id) + ":" + appointment_date;
+        respondFromDbCoalesced(req, res, get_slots_status, key,
+                               [doctor_id, appointment_date, etag](const crow::request& req, sqlite3* db)
+        {
+            crow::response res = slotStatusResponse(db, doctor_id, appointment_date, false);
+            if (res.code == 200) {
+                res.set_header("ETag", etag);
+            }
+            return res;
+        });
     });
 
+    // --------------------------------------------------
+    // WebSocket: live slot status for one doctor and date
+    // Client sends {"doctor_id":4,"date":"2030-01-07"}; see slot_push.h
+    // --------------------------------------------------
+    CROW_WEBSOCKET_ROUTE(app, "/slot_updates")
+        .onaccept([](const crow::request& req, auto&&...) { return publicSessionValid(req); })
+        .onmessage([](crow::websocket::connection& conn, const std::string& data, bool is_binary)
+        {
+            if (is_binary || data.size() > 256) {
+                conn.close("Unsupported message.");
+                return;
+            }
+            const auto message = parseBody<SlotSubscribeMessage>(data);
+            if (!message) {
+                conn.close(message.error());
+                return;
+            }
+            if (message->doctor_id <= 0 || !isIsoDate(message->date)) {
+                conn.close("Please provide a valid doctor_id and date.");
+                return;
+            }
+            slotPushSubscribe(conn, message->doctor_id, std::string(message->date));
+        })
+        .onclose([](crow::websocket::connection& conn, const std::string&, auto&&...) { slotPushDisconnect(conn); });
+
     // --------------------------------------------------
     // POST: Create schedule context (public flow)
     // --------------------------------------------------
+    const RouteTag schedule_context_post = routeTag("POST /schedule_context", RouteClass::ReadApi);
     CROW_ROUTE(app, "/schedule_context").methods("POST"_method)
-    ([db](const crow::request& req)
+    ([schedule_context_post](const crow::request& req, crow::response& res)
     {
-        if (!publicSessionValid(req)) {
-            return crow::response(401, "Please refresh and try again.");
-        }
-
-        auto body = crow::json::load(req.body);
-        if (!body || !body.has("doctor_id")) {
-            return crow::response(400, "Please provide doctor_id.");
-        }
-
-        const int doctor_id = body["doctor_id"].i();
-        if (doctor_id <= 0) {
-            return crow::response(400, "Please provide a valid doctor_id.");
-        }
-
-        sqlite3_stmt* stmt = nullptr;
-        const char* sql_doctor =
-            "SELECT doctor_name, experience_years, ratings, category_id "
-            "FROM Doctor WHERE doctor_id = ? LIMIT 1;";
-        if (sqlite3_prepare_v2(db, sql_doctor, -1, &stmt, nullptr) != SQLITE_OK) {
-            return crow::response(500, "Sorry, we couldn't load the doctor right now.");
-        }
-
-        sqlite3_bind_int(stmt, 1, doctor_id);
-        std::string doctor_name;
-        std::string experience_years;
-        double ratings = 0.0;
-        int category_id = -1;
-
-        if (sqlite3_step(stmt) == SQLITE_ROW) {
-            doctor_name = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 0));
-            experience_years = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 1));
-            ratings = sqlite3_column_double(stmt, 2);
-            category_id = sqlite3_column_int(stmt, 3);
-        }
-        sqlite3_finalize(stmt);
-
-        if (doctor_name.empty() || category_id <= 0) {
-            return crow::response(404, "Doctor not found.");
-        }
+        respondFromDb(req, res, schedule_context_post, [](const crow::request& req, sqlite3* db)
+        {
+            if (!publicSessionValid(req)) {
+                return crow::response(401, "Please refresh and try again.");
+            }
 
-        std::string category_name;
-        const char* sql_category =
-            "SELECT category_name FROM Category WHERE category_id = ? LIMIT 1;";
-        if (sqlite3_prepare_v2(db, sql_category, -1, &stmt, nullptr) != SQLITE_OK) {
-            return crow::response(500, "Sorry, we couldn't load the category right now.");
-        }
-        sqlite3_bind_int(stmt, 1, category_id);
-        if (sqlite3_step(stmt) == SQLITE_ROW) {
-            category_name = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 0));
-        }
-        sqlite3_finalize(stmt);
+            const auto body = parseBody<ScheduleContextRequest>(req);
+            if (!body) {
+                return crow::response(400, body.error());
+            }
 
-        const std::string token = generateScheduleToken();
-        const auto expires_at = std::chrono::system_clock::now() + std::chrono::minutes(15);
-        {
-            std::lock_guard<std::mutex> lock(g_schedule_mutex);
-            g_schedule_contexts[token] = {doctor_id, doctor_name, category_name, experience_years, ratings, expires_at};
-        }
+            const int doctor_id = body->doctor_id;
+            if (doctor_id <= 0) {
+                return crow::response(400, "Please provide a valid doctor_id.");
+            }
 
-        crow::json::wvalue res;
-        res["success"] = true;
-        res["message"] = "Schedule context created.";
+            std::shared_ptr<const DoctorDirectory> directory = doctorDirectory(db);
+            if (!directory) {
+                return crow::response(500, "Sorry, we couldn't load the doctor right now.");
+            }
+            const DirectoryDoctor* doctor = directory->byId(doctor_id);
+            if (!doctor || doctor->doctor_name.empty() || doctor->category_id <= 0) {
+                return crow::response(404, "Doctor not found.");
+            }
+            const std::string& doctor_name = doctor->doctor_name;
+            const std::string& experience_years = doctor->experience;
+            const double ratings = doctor->rating;
+            const std::string& category_name = doctor->category_name;
+
+            const std::string token = generateToken();
+            const auto expires_at = std::chrono::system_clock::now() + std::chrono::minutes(15);
+            {
+                StageTimer timer(Stage::Context);
+                std::lock_guard<ProfiledMutex> lock(g_schedule_mutex);
+                g_schedule_contexts[token] = {doctor_id, doctor_name, category_name, experience_years, ratings, expires_at};
+            }
 
-        crow::response response(200, res);
-        std::ostringstream cookie;
-        cookie << "schedule_token=" << token
-               << "; Path=/; Max-Age=900; HttpOnly; SameSite=Strict; Secure";
-        response.add_header("Set-Cookie", cookie.str());
-        return response;
+            crow::json::wvalue res;
+            res["success"] = true;
+            res["message"] = "Schedule context created.";
+
+            crow::response response = jsonResponse(200, res);
+            std::ostringstream cookie;
+            cookie << "schedule_token=" << token
+                   << "; Path=/; Max-Age=900; HttpOnly; SameSite=Strict; Secure";
+            response.add_header("Set-Cookie", cookie.str());
+            return response;
+        });
     });
 
     // --------------------------------------------------
     // GET: Schedule context (public flow)
     // --------------------------------------------------
+    const RouteTag schedule_context_get = routeTag("GET /schedule_context", RouteClass::ReadApi);
     CROW_ROUTE(app, "/schedule_context").methods("GET"_method)
-    ([db](const crow::request& req)
+    ([schedule_context_get](const crow::request& req)
     {
-        if (!publicSessionValid(req)) {
-            return crow::response(401, "Please refresh and try again.");
-        }
+        return respondInline(req, schedule_context_get, [&]() {
+            if (!publicSessionValid(req)) {
+                return crow::response(401, "Please refresh and try again.");
+            }
 
-        const std::string token = getScheduleTokenFromRequest(req);
-        if (token.empty()) {
-            return crow::response(401, "Missing schedule token.");
-        }
+            const std::string token = getScheduleTokenFromRequest(req);
+            if (token.empty()) {
+                return crow::response(401, "Missing schedule token.");
+            }
 
-        ScheduleContext ctx;
-        if (!getScheduleContext(token, ctx)) {
-            return crow::response(401, "Invalid or expired schedule token.");
-        }
+            ScheduleContext ctx;
+            if (!getScheduleContext(token, ctx)) {
+                return crow::response(401, "Invalid or expired schedule token.");
+            }
 
-        crow::json::wvalue res;
-        res["doctor_id"] = ctx.doctor_id;
-        res["doctor_name"] = ctx.doctor_name;
-        res["category_name"] = ctx.category_name;
-        res["experience_years"] = ctx.experience_years;
-        res["ratings"] = ctx.ratings;
+            crow::json::wvalue res;
+            res["doctor_id"] = ctx.doctor_id;
+            res["doctor_name"] = ctx.doctor_name;
+            res["category_name"] = ctx.category_name;
+            res["experience_years"] = ctx.experience_years;
+            res["ratings"] = ctx.ratings;
 
-        return crow::response(200, res);
+            return jsonResponse(200, res);
+        });
     });
 
     // --------------------------------------------------
     // GET: Appointment page
     // --------------------------------------------------
+    const RouteTag appointment_page = routeTag("GET /appointment_page/<int>/<string>/<string>/<string>/<string>",
+                                               RouteClass::Static, RoutePriority::Critical);
     CROW_ROUTE(app, "/appointment_page/<int>/<string>/<string>/<string>/<string>")
-    ([db](int doctor_id,
+    ([appointment_page](int doctor_id,
           const std::string& category_name,
           const std::string& doctor_name,
           const std::string& date,
           const std::string& slot_time)
     {
-        std::ifstream file("../public/appointment.html");
-        if (!file.is_open()) {
-            return crow::response(404, "Sorry, the appointment page is not available right now.");
-        }
+        return respondInline(appointment_page, [&]() {
+            std::ifstream file("../public/appointment.html");
+            if (!file.is_open()) {
+                return crow::response(404, "Sorry, the appointment page is not available right now.");
+            }
 
-        std::stringstream buffer;
-        buffer << file.rdbuf();
-        std::string html = buffer.str();
+            std::stringstream buffer;
+            buffer << file.rdbuf();
+            std::string html = buffer.str();
 
-        auto replace = [&](const std::string& key, const std::string& value) {
-            size_t pos = html.find(key);
-            if (pos != std::string::npos) {
-                html.replace(pos, key.length(), value);
-            }
-        };
+            auto replace = [&](const std::string& key, const std::string& value) {
+                size_t pos = html.find(key);
+                if (pos != std::string::npos) {
+                    html.replace(pos, key.length(), value);
+                }
+            };
 
-        replace("{{CATEGORY_NAME}}", category_name);
-        replace("{{DOCTOR_NAME}}", doctor_name);
-        replace("{{SLOT_DATE}}", date);
-        replace("{{SLOT_TIME}}", slot_time);
+            replace("{{CATEGORY_NAME}}", category_name);
+            replace("{{DOCTOR_NAME}}", doctor_name);
+            replace("{{SLOT_DATE}}", date);
+            replace("{{SLOT_TIME}}", slot_time);
 
-        return crow::response(200, html);
+            return crow::response(200, html);
+        });
     });
 
     // --------------------------------------------------
     // POST: Add a new slot (dev/admin)
     // --------------------------------------------------
+    const RouteTag add_slot = routeTag("POST /add_slot", RouteClass::WriteApi, RoutePriority::Low);
     CROW_ROUTE(app, "/add_slot").methods("POST"_method)
-    ([db](const crow::request& req)
+    ([add_slot](const crow::request& req, crow::response& res)
     {
-        if (!publicSessionValid(req)) {
-            return crow::response(401, "Please refresh and try again.");
-        }
-        auto body = crow::json::load(req.body);
-        if (!body || !body.has("time_slot")) {
-            return crow::response(400, "Please provide a time slot.");
-        }
-
-        std::string time_slot = std::string(body["time_slot"].s());
-
-        const char* sql =
-            "INSERT INTO Doctor_Schedule (time_slot) VALUES (?)";
-
-        sqlite3_stmt* stmt = nullptr;
-        if (sqlite3_prepare_v2(db, sql, -1, &stmt, nullptr) != SQLITE_OK) {
-            return crow::response(500, "Sorry, we couldn't add the slot right now. Please try again.");
-        }
-
-        sqlite3_bind_text(stmt, 1, time_slot.c_str(), -1, SQLITE_STATIC);
+        respondFromDb(req, res, add_slot, [](const crow::request& req, sqlite3* db)
+        {
+            if (!publicSessionValid(req)) {
+                return crow::response(401, "Please refresh and try again.");
+            }
+            const auto body = parseBody<AddSlotRequest>(req);
+            if (!body) {
+                return crow::response(400, body.error());
+            }
 
-        if (sqlite3_step(stmt) != SQLITE_DONE) {
-            sqlite3_finalize(stmt);
-            return crow::response(500, "Sorry, we couldn't add the slot right now. Please try again.");
-        }
+            const std::string_view time_slot = body->time_slot;
 
-        sqlite3_finalize(stmt);
+            if (execute(db, sql::kSlotInsert, time_slot) != SQLITE_DONE) {
+                return crow::response(500, "Sorry, we couldn't add the slot right now. Please try again.");
+            }
 
-        crow::json::wvalue res;
-        res["success"] = true;
-        res["message"] = "Slot added successfully.";
-        return crow::response(200, res);
+            crow::json::wvalue res;
+            res["success"] = true;
+            res["message"] = "Slot added successfully.";
+            return jsonResponse(200, res);
+        });
     });
 
     // --------------------------------------------------
     // POST: Block a slot for a doctor (legacy endpoint)
     // --------------------------------------------------
+    const RouteTag block_slot = routeTag("POST /block_slot", RouteClass::WriteApi, RoutePriority::Low);
     CROW_ROUTE(app, "/block_slot").methods("POST"_method)
-    ([db](const crow::request& req)
+    ([block_slot](const crow::request& req, crow::response& res)
     {
-        if (!publicSessionValid(req)) {
-            return crow::response(401, "Please refresh and try again.");
-        }
-        auto body = crow::json::load(req.body);
-        if (!body || !body.has("doctor_id") || !body.has("schedule_id") || !body.has("appointment_date")) {
-            return crow::response(400, "Please provide doctor_id, schedule_id, and appointment_date.");
-        }
-
-        int doctor_id = body["doctor_id"].i();
-        int schedule_id = body["schedule_id"].i();
-        std::string appointment_date = body["appointment_date"].s();
-
-        const char* booked_check_sql =
-            "SELECT 1 FROM Appointment "
-            "WHERE doctor_id = ? AND schedule_id = ? AND appointment_date = ? AND status = 'BOOKED' "
-            "LIMIT 1;";
-        sqlite3_stmt* booked_stmt = nullptr;
-        if (sqlite3_prepare_v2(db, booked_check_sql, -1, &booked_stmt, nullptr) != SQLITE_OK) {
-            return crow::response(500, "Sorry, we couldn't update the slot right now. Please try again.");
-        }
-        sqlite3_bind_int(booked_stmt, 1, doctor_id);
-        sqlite3_bind_int(booked_stmt, 2, schedule_id);
-        sqlite3_bind_text(booked_stmt, 3, appointment_date.c_str(), -1, SQLITE_TRANSIENT);
-        bool already_booked = sqlite3_step(booked_stmt) == SQLITE_ROW;
-        sqlite3_finalize(booked_stmt);
-        if (already_booked) {
-            return crow::response(409, "Sorry, that slot is already booked for this date.");
-        }
-
-        const char* sql =
-            "INSERT OR IGNORE INTO Doctor_Blocked_Slots (doctor_id, schedule_id, appointment_date) "
-            "VALUES (?, ?, ?);";
-
-        sqlite3_stmt* stmt = nullptr;
-        if (sqlite3_prepare_v2(db, sql, -1, &stmt, nullptr) != SQLITE_OK) {
-            return crow::response(500, "Sorry, we couldn't update the slot right now. Please try again.");
-        }
+        respondFromDb(req, res, block_slot, [](const crow::request& req, sqlite3* db)
+        {
+            if (!publicSessionValid(req)) {
+                return crow::response(401, "Please refresh and try again.");
+            }
+            const auto body = parseBody<BlockSlotRequest>(req);
+            if (!body) {
+                return crow::response(400, body.error());
+            }
 
-        sqlite3_bind_int(stmt, 1, doctor_id);
-        sqlite3_bind_int(stmt, 2, schedule_id);
-        sqlite3_bind_text(stmt, 3, appointment_date.c_str(), -1, SQLITE_STATIC);
+            int doctor_id = body->doctor_id;
+            int schedule_id = body->schedule_id;
+            std::string appointment_date(body->appointment_date);
+
+            {
+                auto booked = query(db, sql::kSlotBooked, doctor_id, schedule_id, appointment_date);
+                if (booked.step()) {
+                    return crow::response(409, "Sorry, that slot is already booked for this date.");
+                }
+                if (!booked.done()) {
+                    return crow::response(500, "Sorry, we couldn't update the slot right now. Please try again.");
+                }
+            }
 
-        bool blocked = sqlite3_step(stmt) == SQLITE_DONE;
-        int changes = sqlite3_changes(db);
-        sqlite3_finalize(stmt);
+            const SlotWriteScope slot_write(doctor_id, appointment_date);
+            bool blocked = execute(db, sql::kSlotBlock, doctor_id, schedule_id, appointment_date) == SQLITE_DONE;
+            int changes = sqlite3_changes(db);
 
-        crow::json::wvalue res;
-        res["success"] = blocked && changes > 0;
-        res["message"] = (blocked && changes > 0) ? "Slot blocked successfully." : "That slot is already blocked.";
+            crow::json::wvalue res;
+            res["success"] = blocked && changes > 0;
+            res["message"] = (blocked && changes > 0) ? "Slot blocked successfully." : "That slot is already blocked.";
 
-        return crow::response(blocked ? 200 : 409, res);
+            return crow::response(blocked ? 200 : 409, res);
+        });
     });
 
     // --------------------------------------------------
     // POST: Verify doctor for dashboard
     // Required: doctor_name + phone
     // --------------------------------------------------
+    const RouteTag dashboard_verify = routeTag("POST /doctor_dashboard/verify", RouteClass::ReadApi);
     CROW_ROUTE(app, "/doctor_dashboard/verify").methods("POST"_method)
-    ([db](const crow::request& req)
+    ([dashboard_verify](const crow::request& req, crow::response& res)
     {
-        auto body = crow::json::load(req.body);
-        if (!body || !body.has("doctor_name") || !body.has("phone")) {
-            return crow::response(400, "Please provide both doctor_name and phone.");
-        }
-
-        std::string doctor_name = body["doctor_name"].s();
-        std::string phone = body["phone"].s();
-
-        const char* sql =
-            "SELECT doctor_id, doctor_name "
-            "FROM Doctor "
-            "WHERE lower(trim(doctor_name)) = lower(trim(?)) "
-            "  AND trim(phone) = trim(?) "
-            "LIMIT 1;";
-
-        sqlite3_stmt* stmt = nullptr;
-        if (sqlite3_prepare_v2(db, sql, -1, &stmt, nullptr) != SQLITE_OK) {
-            return crow::response(500, "Sorry, we couldn't verify you right now. Please try again.");
+        if (!rateLimitAllow(req, RateBucket::DashboardVerify, res)) {
+            endResponse(dashboard_verify, res);
+            return;
         }
+        respondFromDb(req, res, dashboard_verify, [](const crow::request& req, sqlite3* db)
+        {
+            const auto body = parseBody<DashboardVerifyRequest>(req);
+            if (!body) {
+                return crow::response(400, body.error());
+            }
 
-        sqlite3_bind_text(stmt, 1, doctor_name.c_str(), -1, SQLITE_TRANSIENT);
-        sqlite3_bind_text(stmt, 2, phone.c_str(), -1, SQLITE_TRANSIENT);
-
-        int doctor_id = -1;
-        std::string matched_name;
-
-        if (sqlite3_step(stmt) == SQLITE_ROW) {
-            doctor_id = sqlite3_column_int(stmt, 0);
-            matched_name = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 1));
-        }
-        sqlite3_finalize(stmt);
+            const std::string_view doctor_name = body->doctor_name;
+            const std::string_view phone = body->phone;
+
+            int doctor_id = -1;
+            std::string matched_name;
+            {
+                auto row = query(db, sql::kDoctorVerify, doctor_name, phone);
+                if (row.step()) {
+                    std::tie(doctor_id, matched_name) = row.row();
+                } else if (!row.done()) {
+                    return crow::response(500, "Sorry, we couldn't verify you right now. Please try again.");
+                }
+            }
 
-        if (doctor_id <= 0) {
-            return crow::response(401, "Sorry, we could not verify those details. Please check and try again.");
-        }
+            if (doctor_id <= 0) {
+                return crow::response(401, "Sorry, we could not verify those details. Please check and try again.");
+            }
 
-        const auto expires_at = std::chrono::system_clock::now() + std::chrono::hours(12);
-        const std::string token = generateSessionToken();
+            const auto expires_at = std::chrono::system_clock::now() + std::chrono::hours(12);
+            const std::string token = generateToken();
 
-        {
-            std::lock_guard<std::mutex> lock(g_session_mutex);
-            g_doctor_sessions[token] = {doctor_id, expires_at};
-        }
+            {
+                StageTimer timer(Stage::Context);
+                std::lock_guard<ProfiledMutex> lock(g_session_mutex);
+                g_doctor_sessions[token] = {doctor_id, expires_at};
+            }
 
-        crow::json::wvalue res;
-        res["success"] = true;
-        res["token"] = token;
-        res["doctor_id"] = doctor_id;
-        res["doctor_name"] = matched_name;
-        res["message"] = "Verification successful.";
+            crow::json::wvalue res;
+            res["success"] = true;
+            res["token"] = token;
+            res["doctor_id"] = doctor_id;
+            res["doctor_name"] = matched_name;
+            res["message"] = "Verification successful.";
 
-        return crow::response(200, res);
+            return jsonResponse(200, res);
+        });
     });
 
     // --------------------------------------------------
     // GET: Doctor dashboard slots (doctor can only view own)
     // --------------------------------------------------
+    const RouteTag dashboard_slots = routeTag("GET /doctor_dashboard/slots/<string>", RouteClass::ReadApi);
     CROW_ROUTE(app, "/doctor_dashboard/slots/<string>").methods("GET"_method)
-    ([db](const crow::request& req, const std::string& appointment_date)
+    ([dashboard_slots](const crow::request& req, crow::response& res, const std::string& appointment_date)
     {
-        const std::string token = getTokenFromRequest(req);
-        const int doctor_id = doctorIdFromToken(token);
-
-        if (doctor_id <= 0) {
-            return crow::response(401, "Please verify your session and try again.");
-        }
-
-        const char* sql =
-            "SELECT ds.schedule_id, ds.time_slot, "
-            "       CASE "
-            "         WHEN EXISTS ("
-            "           SELECT 1 FROM Appointment a "
-            "           WHERE a.doctor_id = ? "
-            "             AND a.schedule_id = ds.schedule_id "
-            "             AND a.appointment_date = ? "
-            "             AND a.status = 'BOOKED'"
-            "         ) THEN 'BOOKED' "
-            "         WHEN EXISTS ("
-            "           SELECT 1 FROM Doctor_Blocked_Slots b "
-            "           WHERE b.doctor_id = ? "
-            "             AND b.schedule_id = ds.schedule_id "
-            "             AND b.appointment_date = ? "
-            "         ) THEN 'BLOCKED' "
-            "         ELSE 'AVAILABLE' "
-            "       END AS slot_status "
-            "FROM Doctor_Schedule ds "
-            "ORDER BY ds.time_slot;";
-
-        sqlite3_stmt* stmt = nullptr;
-        if (sqlite3_prepare_v2(db, sql, -1, &stmt, nullptr) != SQLITE_OK) {
-            return crow::response(500, "Sorry, we couldn't load the slots right now. Please try again.");
-        }
+        respondFromDb(req, res, dashboard_slots, [appointment_date](const crow::request& req, sqlite3* db)
+        {
+            const std::string token = getTokenFromRequest(req);
+            const int doctor_id = doctorIdFromToken(token);
 
-        sqlite3_bind_int(stmt, 1, doctor_id);
-        sqlite3_bind_text(stmt, 2, appointment_date.c_str(), -1, SQLITE_TRANSIENT);
-        sqlite3_bind_int(stmt, 3, doctor_id);
-        sqlite3_bind_text(stmt, 4, appointment_date.c_str(), -1, SQLITE_TRANSIENT);
-
-        crow::json::wvalue result;
-        int idx = 0;
-        while (sqlite3_step(stmt) == SQLITE_ROW) {
-            result[idx]["schedule_id"] = sqlite3_column_int(stmt, 0);
-            result[idx]["time_slot"] =
-                std::string(reinterpret_cast<const char*>(sqlite3_column_text(stmt, 1)));
-            result[idx]["status"] =
-                std::string(reinterpret_cast<const char*>(sqlite3_column_text(stmt, 2)));
-            idx++;
-        }
-        sqlite3_finalize(stmt);
+            if (doctor_id <= 0) {
+                return crow::response(401, "Please verify your session and try again.");
+            }
 
-        return crow::response(200, result);
+            return slotStatusResponse(db, doctor_id, appointment_date, false);
+        });
     });
 
     // --------------------------------------------------
     // POST: Block slot from doctor dashboard (own slots only)
     // --------------------------------------------------
+    const RouteTag dashboard_block_slot = routeTag("POST /doctor_dashboard/block_slot", RouteClass::WriteApi);
     CROW_ROUTE(app, "/doctor_dashboard/block_slot").methods("POST"_method)
-    ([db](const crow::request& req)
+    ([dashboard_block_slot](const crow::request& req, crow::response& res)
     {
-        auto body = crow::json::load(req.body);
-        if (!body || !body.has("schedule_id") || !body.has("appointment_date")) {
-            return crow::response(400, "Please provide schedule_id and appointment_date.");
-        }
-
-        const std::string token = getTokenFromRequest(req, body);
-        const int doctor_id = doctorIdFromToken(token);
-
-        if (doctor_id <= 0) {
-            return crow::response(401, "Please verify your session and try again.");
-        }
-
-        int schedule_id = body["schedule_id"].i();
-        std::string appointment_date = body["appointment_date"].s();
-
-        const char* booked_check_sql =
-            "SELECT 1 FROM Appointment "
-            "WHERE doctor_id = ? AND schedule_id = ? AND appointment_date = ? AND status = 'BOOKED' "
-            "LIMIT 1;";
-        sqlite3_stmt* booked_stmt = nullptr;
-        if (sqlite3_prepare_v2(db, booked_check_sql, -1, &booked_stmt, nullptr) != SQLITE_OK) {
-            return crow::response(500, "Sorry, we couldn't update the slot right now. Please try again.");
-        }
-        sqlite3_bind_int(booked_stmt, 1, doctor_id);
-        sqlite3_bind_int(booked_stmt, 2, schedule_id);
-        sqlite3_bind_text(booked_stmt, 3, appointment_date.c_str(), -1, SQLITE_TRANSIENT);
-        bool already_booked = sqlite3_step(booked_stmt) == SQLITE_ROW;
-        sqlite3_finalize(booked_stmt);
-        if (already_booked) {
-            return crow::response(409, "Sorry, that slot is already booked for this date.");
-        }
+        respondFromDb(req, res, dashboard_block_slot, [](const crow::request& req, sqlite3* db)
+        {
+            const auto body = parseBody<DashboardSlotRequest>(req);
+            if (!body) {
+                return crow::response(400, body.error());
+            }
 
-        const char* sql =
-            "INSERT OR IGNORE INTO Doctor_Blocked_Slots (doctor_id, schedule_id, appointment_date) "
-            "VALUES (?, ?, ?);";
+            const std::string token = getTokenFromRequest(req, body->token);
+            const int doctor_id = doctorIdFromToken(token);
 
-        sqlite3_stmt* stmt = nullptr;
-        if (sqlite3_prepare_v2(db, sql, -1, &stmt, nullptr) != SQLITE_OK) {
-            return crow::response(500, "Sorry, we couldn't update the slot right now. Please try again.");
-        }
+            if (doctor_id <= 0) {
+                return crow::response(401, "Please verify your session and try again.");
+            }
 
-        sqlite3_bind_int(stmt, 1, doctor_id);
-        sqlite3_bind_int(stmt, 2, schedule_id);
-        sqlite3_bind_text(stmt, 3, appointment_date.c_str(), -1, SQLITE_TRANSIENT);
+            int schedule_id = body->schedule_id;
+            std::string appointment_date(body->appointment_date);
+
+            {
+                auto booked = query(db, sql::kSlotBooked, doctor_id, schedule_id, appointment_date);
+                if (booked.step()) {
+                    return crow::response(409, "Sorry, that slot is already booked for this date.");
+                }
+                if (!booked.done()) {
+                    return crow::response(500, "Sorry, we couldn't update the slot right now. Please try again.");
+                }
+            }
 
-        bool ok = sqlite3_step(stmt) == SQLITE_DONE;
-        int changes = sqlite3_changes(db);
-        sqlite3_finalize(stmt);
+            const SlotWriteScope slot_write(doctor_id, appointment_date);
+            bool ok = execute(db, sql::kSlotBlock, doctor_id, schedule_id, appointment_date) == SQLITE_DONE;
+            int changes = sqlite3_changes(db);
 
-        if (!ok) {
-            return crow::response(409, "Sorry, that slot cannot be blocked right now.");
-        }
+            if (!ok) {
+                return crow::response(409, "Sorry, that slot cannot be blocked right now.");
+            }
 
-        crow::json::wvalue res;
-        res["success"] = changes > 0;
-        res["message"] = (changes > 0) ? "Slot blocked." : "That slot is already blocked.";
-        return crow::response(200, res);
+            crow::json::wvalue res;
+            res["success"] = changes > 0;
+            res["message"] = (changes > 0) ? "Slot blocked." : "That slot is already blocked.";
+            return jsonResponse(200, res);
+        });
     });
 
     // --------------------------------------------------
     // POST: Unblock slot from doctor dashboard (own slots only)
     // --------------------------------------------------
+    const RouteTag dashboard_unblock_slot = routeTag("POST /doctor_dashboard/unblock_slot", RouteClass::WriteApi);
     CROW_ROUTE(app, "/doctor_dashboard/unblock_slot").methods("POST"_method)
-    ([db](const crow::request& req)
+    ([dashboard_unblock_slot](const crow::request& req, crow::response& res)
     {
-        auto body = crow::json::load(req.body);
-        if (!body || !body.has("schedule_id") || !body.has("appointment_date")) {
-            return crow::response(400, "Please provide schedule_id and appointment_date.");
-        }
-
-        const std::string token = getTokenFromRequest(req, body);
-        const int doctor_id = doctorIdFromToken(token);
-
-        if (doctor_id <= 0) {
-            return crow::response(401, "Please verify your session and try again.");
-        }
-
-        int schedule_id = body["schedule_id"].i();
-        std::string appointment_date = body["appointment_date"].s();
+        respondFromDb(req, res, dashboard_unblock_slot, [](const crow::request& req, sqlite3* db)
+        {
+            const auto body = parseBody<DashboardSlotRequest>(req);
+            if (!body) {
+                return crow::response(400, body.error());
+            }
 
-        const char* sql =
-            "DELETE FROM Doctor_Blocked_Slots "
-            "WHERE doctor_id = ? "
-            "  AND schedule_id = ? "
-            "  AND appointment_date = ?;";
+            const std::string token = getTokenFromRequest(req, body->token);
+            const int doctor_id = doctorIdFromToken(token);
 
-        sqlite3_stmt* stmt = nullptr;
-        if (sqlite3_prepare_v2(db, sql, -1, &stmt, nullptr) != SQLITE_OK) {
-            return crow::response(500, "Sorry, we couldn't update the slot right now. Please try again.");
-        }
+            if (doctor_id <= 0) {
+                return crow::response(401, "Please verify your session and try again.");
+            }
 
-        sqlite3_bind_int(stmt, 1, doctor_id);
-        sqlite3_bind_int(stmt, 2, schedule_id);
-        sqlite3_bind_text(stmt, 3, appointment_date.c_str(), -1, SQLITE_TRANSIENT);
+            int schedule_id = body->schedule_id;
+            std::string appointment_date(body->appointment_date);
 
-        bool ok = sqlite3_step(stmt) == SQLITE_DONE;
-        int changes = sqlite3_changes(db);
-        sqlite3_finalize(stmt);
+            const SlotWriteScope slot_write(doctor_id, appointment_date);
+            bool ok = execute(db, sql::kSlotUnblock, doctor_id, schedule_id, appointment_date) == SQLITE_DONE;
+            int changes = sqlite3_changes(db);
 
-        crow::json::wvalue res;
-        res["success"] = ok && changes > 0;
-        res["message"] = (ok && changes > 0) ? "Slot unblocked." : "No blocked slot was found.";
-        return crow::response((ok && changes > 0) ? 200 : 404, res);
+            crow::json::wvalue res;
+            res["success"] = ok && changes > 0;
+            res["message"] = (ok && changes > 0) ? "Slot unblocked." : "No blocked slot was found.";
+            return crow::response((ok && changes > 0) ? 200 : 404, res);
+        });
     });
 }
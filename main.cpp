@@ -1,6 +1,5 @@
 #include <crow.h>
 #include <sqlite3.h>
-#include <iostream>
 #include <cstdlib>
 using namespace std;
 
@@ -11,8 +10,30 @@ using namespace std;
 #include "controllers/appointment_controller.h"
 #include "controllers/cancellation_controller.h"
 #include "controllers/page_controller.h"
+#include "controllers/admin_controller.h"
+
+// Services
+#include "services/db_executor.h"
+#include "services/logger.h"
+#include "services/slot_push.h"
+#include "services/traffic_capture.h"
 
 int main() {
+    // -------------------------------------------------
+    // Logging: buffered per thread, flushed by a background writer
+    // -------------------------------------------------
+    if (!startLogger()) {
+        return 1;
+    }
+
+    // -------------------------------------------------
+    // Traffic capture for replay (TRAFFIC_CAPTURE=<file>, off by default)
+    // -------------------------------------------------
+    if (!startTrafficCapture()) {
+        stopLogger();
+        return 1;
+    }
+
     crow::SimpleApp app;
 
     // Optional: Mustache templates
@@ -21,24 +42,39 @@ int main() {
     // -------------------------------------------------
     // Open SQLite database
     // -------------------------------------------------
-    sqlite3* db = nullptr;
-    if (sqlite3_open("../db/Marta_K Database.db", &db) != SQLITE_OK) {
-        std::cerr << "Failed to open DB: " << sqlite3_errmsg(db) << std::endl;
+    const std::string db_path = "../db/Marta_K Database.db";
+    sqlite3* db = openDatabase(db_path);
+    if (!db) {
+        stopTrafficCapture();
+        stopLogger();
         return 1;
     }
-    sqlite3_busy_timeout(db, 5000);
 
-    char* pragma_err = nullptr;
-    sqlite3_exec(db, "PRAGMA journal_mode=WAL;", nullptr, nullptr, &pragma_err);
-    if (pragma_err) {
-        std::cerr << "PRAGMA journal_mode failed: " << pragma_err << std::endl;
-        sqlite3_free(pragma_err);
+    // -------------------------------------------------
+    // DB executor: SQLite work runs off the Crow IO threads
+    // -------------------------------------------------
+    const char* db_workers_env = std::getenv("DB_WORKERS");
+    const int db_workers = db_workers_env ? std::atoi(db_workers_env) : 4;
+    if (!startDbExecutor(db_path, db_workers > 0 ? static_cast<size_t>(db_workers) : 4)) {
+        LOG_ERROR("Failed to start DB executor");
+        closeDatabase(db);
+        stopTrafficCapture();
+        stopLogger();
+        return 1;
     }
-    sqlite3_exec(db, "PRAGMA synchronous=NORMAL;", nullptr, nullptr, &pragma_err);
-    if (pragma_err) {
-        std::cerr << "PRAGMA synchronous failed: " << pragma_err << std::endl;
-        sqlite3_free(pragma_err);
+
+    // -------------------------------------------------
+    // Slot push: live slot status for open schedule pages
+    // -------------------------------------------------
+    if (!startSlotPush(db_path)) {
+        LOG_ERROR("Failed to start slot push");
+        stopDbExecutor();
+        closeDatabase(db);
+        stopTrafficCapture();
+        stopLogger();
+        return 1;
     }
+
     // -------------------------------------------------
     // API routes (MVC controllers)
     // -------------------------------------------------
@@ -48,6 +84,7 @@ int main() {
     registerScheduleRoutes(app, db);
     registerAppointmentRoutes(app, db);
     registerCancellationRoutes(app, db);
+    registerAdminRoutes(app);
 
     // -------------------------------------------------
     // Start the server
@@ -56,14 +93,14 @@ int main() {
     const bool use_ssl = !(disable_ssl && std::string(disable_ssl) == "1");
 
     if (use_ssl) {
-        cout << "Server running at https://localhost:8443\n";
+        LOG_INFO("Server running", "url", "https://localhost:8443");
         app.port(8443)
             .ssl_file("D:/APPOINTMNENT BOOKING SYSTEM/crow_backend/cert.pem",
                       "D:/APPOINTMNENT BOOKING SYSTEM/crow_backend/key.pem")
             .multithreaded()
             .run();
     } else {
-        cout << "Server running at http://localhost:8443 (SSL disabled)\n";
+        LOG_INFO("Server running", "url", "http://localhost:8443", "ssl", false);
         app.port(8443)
             .multithreaded()
             .run();
@@ -71,7 +108,11 @@ int main() {
 
 
 
-    // Close DB connection
-    sqlite3_close(db);
+    // Drain pending DB work, then close connections
+    stopSlotPush();
+    stopDbExecutor();
+    closeDatabase(db);
+    stopTrafficCapture();
+    stopLogger();
     return 0;
 }
@@ -3,7 +3,9 @@
 #include <sqlite3.h>
 #include <string>
 #include <vector>
-#include <iostream>
+#include "../services/logger.h"
+#include "../services/model_fields.h"
+#include "../services/sql_statements.h"
 #include "patient.h"        // Patient model
 #include "schedule.h"       // DoctorSchedule model
 #include "doctor.h"         // Doctor model
@@ -27,19 +29,19 @@ public:
         : patient_id(patient), doctor_id(doctor), schedule_id(schedule),
           appointment_date(date), status(stat) {}
 
+    static constexpr auto fields() {
+        return std::make_tuple(field("appointment_id", &Appointment::appointment_id),
+                               field("patient_id", &Appointment::patient_id),
+                               field("doctor_id", &Appointment::doctor_id),
+                               field("schedule_id", &Appointment::schedule_id),
+                               field("appointment_date", &Appointment::appointment_date),
+                               field("status", &Appointment::status),
+                               field("created_at", &Appointment::created_at));
+    }
+
     // Check if appointment ID exists
     static bool exists(sqlite3* db, int appointment_id) {
-        const char* sql = "SELECT 1 FROM Appointment WHERE appointment_id = ?";
-        sqlite3_stmt* stmt;
-        if (sqlite3_prepare_v2(db, sql, -1, &stmt, nullptr) != SQLITE_OK) {
-            std::cerr << "[ERROR] Exists check failed: " << sqlite3_errmsg(db) << "\n";
-            return false;
-        }
-
-        sqlite3_bind_int(stmt, 1, appointment_id);
-        int rc = sqlite3_step(stmt);
-        sqlite3_finalize(stmt);
-        return rc == SQLITE_ROW;
+        return query(db, sql::kAppointmentExists, appointment_id).step();
     }
 
     // Insert appointment with random pre-generated ID
@@ -48,74 +50,34 @@ public:
     {
         // --- Validate inputs ---
         if (patient_id <= 0 || doctor_id <= 0 || schedule_id <= 0 || date.empty()) {
-            std::cerr << "[ERROR] Insert failed: invalid input values\n";
+            LOG_ERROR("Insert failed: invalid input values");
             return false;
         }
 
         // --- Check for appointment ID collision ---
         if (exists(db, appointment_id)) {
-            std::cerr << "[ERROR] Insert failed: appointment_id " << appointment_id << " already exists\n";
+            LOG_ERROR("Insert failed: appointment already exists", "appointment_id", appointment_id);
             return false;
         }
 
-        const char* sql =
-            "INSERT INTO Appointment(appointment_id, patient_id, doctor_id, schedule_id, appointment_date, status, created_at) "
-            "VALUES (?, ?, ?, ?, ?, 'BOOKED', datetime('now','localtime'));";
-
-        sqlite3_stmt* stmt;
-        if (sqlite3_prepare_v2(db, sql, -1, &stmt, nullptr) != SQLITE_OK) {
-            std::cerr << "[ERROR] Prepare failed: " << sqlite3_errmsg(db) << std::endl;
-            return false;
-        }
-
-        sqlite3_bind_int(stmt, 1, appointment_id);
-        sqlite3_bind_int(stmt, 2, patient_id);
-        sqlite3_bind_int(stmt, 3, doctor_id);
-        sqlite3_bind_int(stmt, 4, schedule_id);
-        sqlite3_bind_text(stmt, 5, date.c_str(), -1, SQLITE_TRANSIENT);
-
-        bool ok = sqlite3_step(stmt) == SQLITE_DONE;
+        bool ok = execute(db, sql::kAppointmentInsert, appointment_id, patient_id, doctor_id, schedule_id, date) ==
+                  SQLITE_DONE;
         if (!ok) {
-            std::cerr << "[ERROR] Insert failed: " << sqlite3_errmsg(db) << std::endl;
+            LOG_ERROR("Insert failed", "error", sqlite3_errmsg(db));
         } else {
-            std::cout << "[DEBUG] Appointment inserted successfully: ID=" << appointment_id << "\n";
+            LOG_DEBUG("Appointment inserted successfully", "appointment_id", appointment_id);
         }
 
-        sqlite3_finalize(stmt);
         return ok;
     }
 
     // Fetch appointments for a doctor on a specific date
     static std::vector<Appointment> fetchByDoctorAndDate(sqlite3* db, int doctor_id, const std::string& date) {
         std::vector<Appointment> appointments;
-        const char* sql =
-            "SELECT appointment_id, patient_id, doctor_id, schedule_id, appointment_date, status, created_at "
-            "FROM Appointment "
-            "WHERE doctor_id = ? AND appointment_date = ? "
-            "ORDER BY schedule_id;";
-
-        sqlite3_stmt* stmt;
-        if (sqlite3_prepare_v2(db, sql, -1, &stmt, nullptr) != SQLITE_OK) {
-            std::cerr << "[ERROR] Prepare failed: " << sqlite3_errmsg(db) << std::endl;
-            return appointments;
+        auto rows = query(db, sql::kAppointmentsForDoctorDay, doctor_id, date);
+        while (rows.step()) {
+            readRow(rows, appointments.emplace_back());
         }
-
-        sqlite3_bind_int(stmt, 1, doctor_id);
-        sqlite3_bind_text(stmt, 2, date.c_str(), -1, SQLITE_TRANSIENT);
-
-        while (sqlite3_step(stmt) == SQLITE_ROW) {
-            Appointment a;
-            a.appointment_id = sqlite3_column_int(stmt, 0);
-            a.patient_id = sqlite3_column_int(stmt, 1);
-            a.doctor_id = sqlite3_column_int(stmt, 2);
-            a.schedule_id = sqlite3_column_int(stmt, 3);
-            a.appointment_date = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 4));
-            a.status = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 5));
-            a.created_at = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 6));
-            appointments.push_back(a);
-        }
-
-        sqlite3_finalize(stmt);
         return appointments;
     }
 };
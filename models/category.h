@@ -2,7 +2,9 @@
 // header sqlite3.h used for database operations
 #include <sqlite3.h>
 #include <string>
-#include <iostream>
+#include "../services/logger.h"
+#include "../services/model_fields.h"
+#include "../services/sql_statements.h"
 // we can use vector and map from STL
 #include <vector>
 #include <map>
@@ -19,47 +21,26 @@ public:
     Category(int id, const string& name, const string& description)
         : category_id(id), category_name(name), description(description) {}
 
+    static constexpr auto fields() {
+        return std::make_tuple(field("category_id", &Category::category_id),
+                               field("category_name", &Category::category_name),
+                               field("description", &Category::description));
+    }
+
     // Insert a new category into DB
     //static method because it does not depend on instance/object
     static bool insert(sqlite3* db, const string& name, const string& description) {
-        const char* sql = "INSERT INTO Category (category_name, description) VALUES (?, ?);";
-        sqlite3_stmt* stmt;
-    // prepare the SQL statement
-        if (sqlite3_prepare_v2(db, sql, -1, &stmt, nullptr) != SQLITE_OK) {
-            cerr << "Prepare failed: " << sqlite3_errmsg(db) << endl;
-            return false;
-        }
-    // bind the category name parameter preventing SQL injection
-        sqlite3_bind_text(stmt, 1, name.c_str(), -1, SQLITE_TRANSIENT);
-    // bind the category description parameter preventing SQL injection
-        sqlite3_bind_text(stmt, 2, description.c_str(), -1, SQLITE_TRANSIENT);
-    // execute the statement
-        int rc = sqlite3_step(stmt);
-        sqlite3_finalize(stmt);
-        // check if insertion was successful
-        if (rc != SQLITE_DONE) {
-            cerr << "Insert failed: " << sqlite3_errmsg(db) << endl;
+        // parameters are bound, never spliced into the SQL
+        if (execute(db, sql::kCategoryInsert, name, description) != SQLITE_DONE) {
+            LOG_ERROR("Insert failed", "error", sqlite3_errmsg(db));
             return false;
         }
 
         return true;
     }
     static bool remove(sqlite3* db, int category_id) {
-        const char* sql = "DELETE FROM Category WHERE category_id = ?;";
-        sqlite3_stmt* stmt; 
-        // prepare the SQL statement
-        if (sqlite3_prepare_v2(db, sql, -1, &stmt, nullptr) != SQLITE_OK) {
-            cerr << "Prepare failed: " << sqlite3_errmsg(db) << endl;
-            return false;
-        }
-        // bind the category_id parameter preventing SQL injection
-        sqlite3_bind_int(stmt, 1, category_id);
-        // execute the statement
-        int rc = sqlite3_step(stmt);
-        sqlite3_finalize(stmt);
-        // check if deletion was successful
-        if (rc != SQLITE_DONE) {
-            cerr << "Delete failed: " << sqlite3_errmsg(db) << endl;
+        if (execute(db, sql::kCategoryDelete, category_id) != SQLITE_DONE) {
+            LOG_ERROR("Delete failed", "error", sqlite3_errmsg(db));
             return false;
         }
 
@@ -69,23 +50,10 @@ public:
     // Fetch all categories from DB
     static vector<Category> fetchAll(sqlite3* db) {
         vector<Category> categories;
-        const char* sql = "SELECT category_id, category_name, description FROM Category;";
-        sqlite3_stmt* stmt;
-        // prepare the SQL statement
-        if (sqlite3_prepare_v2(db, sql, -1, &stmt, nullptr) != SQLITE_OK) {
-            cerr << "Prepare failed: " << sqlite3_errmsg(db) << endl;
-            return categories;
-        }
-        // execute the statement and iterate through the results
-        while (sqlite3_step(stmt) == SQLITE_ROW) {
-            int id = sqlite3_column_int(stmt, 0);
-            string name = (const char*)sqlite3_column_text(stmt, 1);
-            const char* desc = (const char*)sqlite3_column_text(stmt, 2);
-            string description = desc ? desc : "";
-            categories.emplace_back(id, name, description);
+        auto rows = query(db, sql::kCategoriesAll);
+        while (rows.step()) {
+            readRow(rows, categories.emplace_back());
         }
-        // clean up
-        sqlite3_finalize(stmt);
         return categories;
     }
 };
@@ -1,7 +1,8 @@
 #pragma once
 #include <sqlite3.h>
 #include <string>
-#include <iostream>
+#include "../services/logger.h"
+#include "../services/sql_statements.h"
 
 class Patient {
 public:
@@ -24,60 +25,28 @@ public:
     ) {
         // --- Validate required fields ---
         if (name.empty() || email.empty() || gender.empty()) {
-            std::cerr << "[ERROR] Insert failed: required fields are empty\n";
+            LOG_ERROR("Insert failed: required fields are empty");
             return false;
         }
 
         // --- Check if patient ID already exists ---
         if (exists(db, patient_id)) {
-            std::cerr << "[ERROR] Insert failed: patient_id " << patient_id << " already exists\n";
+            LOG_ERROR("Insert failed: patient already exists", "patient_id", patient_id);
             return false;
         }
 
-        // --- Prepare SQL insert ---
-        const char* sql =
-            "INSERT INTO Patient "
-            "(patient_id, name, age, email, gender, request) "
-            "VALUES (?, ?, ?, ?, ?, ?)";
-        sqlite3_stmt* stmt;
-
-        if (sqlite3_prepare_v2(db, sql, -1, &stmt, nullptr) != SQLITE_OK) {
-            std::cerr << "[ERROR] Prepare failed: " << sqlite3_errmsg(db) << "\n";
-            return false;
-        }
-
-        sqlite3_bind_int(stmt, 1, patient_id);
-        sqlite3_bind_text(stmt, 2, name.c_str(), -1, SQLITE_TRANSIENT);
-        sqlite3_bind_int(stmt, 3, age);
-        sqlite3_bind_text(stmt, 4, email.c_str(), -1, SQLITE_TRANSIENT);
-        sqlite3_bind_text(stmt, 5, gender.c_str(), -1, SQLITE_TRANSIENT);
-        sqlite3_bind_text(stmt, 6, request.c_str(), -1, SQLITE_TRANSIENT);
-
-        bool ok = sqlite3_step(stmt) == SQLITE_DONE;
+        bool ok = execute(db, sql::kPatientInsert, patient_id, name, age, email, gender, request) == SQLITE_DONE;
         if (!ok) {
-            std::cerr << "[ERROR] Insert failed: " << sqlite3_errmsg(db) << "\n";
+            LOG_ERROR("Insert failed", "error", sqlite3_errmsg(db));
         } else {
-            std::cout << "[DEBUG] Patient inserted successfully: ID=" << patient_id << "\n";
+            LOG_DEBUG("Patient inserted successfully", "patient_id", patient_id);
         }
 
-        sqlite3_finalize(stmt);
         return ok;
     }
 
     // Check if patient ID exists
     static bool exists(sqlite3* db, int patient_id) {
-        const char* sql = "SELECT 1 FROM Patient WHERE patient_id = ?";
-        sqlite3_stmt* stmt;
-
-        if (sqlite3_prepare_v2(db, sql, -1, &stmt, nullptr) != SQLITE_OK) {
-            std::cerr << "[ERROR] Exists check prepare failed: " << sqlite3_errmsg(db) << "\n";
-            return false;
-        }
-
-        sqlite3_bind_int(stmt, 1, patient_id);
-        int rc = sqlite3_step(stmt);
-        sqlite3_finalize(stmt);
-
-        return rc == SQLITE_ROW;
+        return query(db, sql::kPatientExists, patient_id).step();
     }
 };
@@ -0,0 +1,166 @@
+#include "admission.h"
+#include "db_executor.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <vector>
+
+namespace {
+
+// Work queued per executor thread before Normal / Low routes are shed.
+constexpr int kNormalQueuePerWorker = 16;
+constexpr int kLowQueuePerWorker = 4;
+
+// Share of DB requests that hit a locked database before shedding starts.
+constexpr double kNormalBusyRate = 0.5;
+constexpr double kLowBusyRate = 0.2;
+
+// The busy rate is measured over kBusyBuckets * kBucketMillis (2 s).
+constexpr int kBusyBuckets = 8;
+constexpr long long kBucketMillis = 250;
+constexpr unsigned kMinBusySamples = 20;
+
+constexpr int kMaxRetryAfterSeconds = 10;
+
+constexpr int kDefaultReadDeadlineMillis = 2000;
+
+std::vector<std::string> g_route_names;
+std::mutex g_route_mutex;
+
+std::atomic<int> g_in_flight[3];
+std::atomic<unsigned long long> g_shed[3];
+std::atomic<int> g_waiting_on_db{0};
+std::atomic<unsigned long long> g_busy_total{0};
+
+struct BusyBucket {
+    std::atomic<long long> slot{-1};
+    std::atomic<unsigned> ops{0};
+    std::atomic<unsigned> busy{0};
+};
+
+BusyBucket g_busy_window[kBusyBuckets];
+
+long long currentSlot() {
+    const auto now = std::chrono::steady_clock::now().time_since_epoch();
+    return std::chrono::duration_cast<std::chrono::milliseconds>(now).count() / kBucketMillis;
+}
+
+BusyBucket& bucketFor(long long slot) {
+    BusyBucket& bucket = g_busy_window[slot % kBusyBuckets];
+    long long seen = bucket.slot.load(std::memory_order_relaxed);
+    if (seen != slot && bucket.slot.compare_exchange_strong(seen, slot)) {
+        bucket.ops.store(0, std::memory_order_relaxed);
+        bucket.busy.store(0, std::memory_order_relaxed);
+    }
+    return bucket;
+}
+
+double busyRate() {
+    const long long now = currentSlot();
+    unsigned ops = 0;
+    unsigned busy = 0;
+    for (const BusyBucket& bucket : g_busy_window) {
+        if (bucket.slot.load(std::memory_order_relaxed) > now - kBusyBuckets) {
+            ops += bucket.ops.load(std::memory_order_relaxed);
+            busy += bucket.busy.load(std::memory_order_relaxed);
+        }
+    }
+    if (ops < kMinBusySamples) {
+        return 0.0;
+    }
+    return std::min(1.0, static_cast<double>(busy) / ops);
+}
+
+int classIndex(RouteClass cls) {
+    return static_cast<int>(cls);
+}
+
+} // namespace
+
+RouteTag routeTag(const char* name, RouteClass cls, RoutePriority priority, int deadline_ms) {
+    if (deadline_ms < 0) {
+        deadline_ms = cls == RouteClass::ReadApi ? kDefaultReadDeadlineMillis : 0;
+    }
+    std::lock_guard<std::mutex> lock(g_route_mutex);
+    g_route_names.emplace_back(name);
+    return {static_cast<int>(g_route_names.size() - 1), name, cls, priority, deadline_ms};
+}
+
+std::string routeName(int id) {
+    std::lock_guard<std::mutex> lock(g_route_mutex);
+    if (id < 0 || static_cast<size_t>(id) >= g_route_names.size()) {
+        return "";
+    }
+    return g_route_names[id];
+}
+
+std::size_t routeCount() {
+    std::lock_guard<std::mutex> lock(g_route_mutex);
+    return g_route_names.size();
+}
+
+bool admitDbRequest(const RouteTag& tag, crow::response& res) {
+    const int workers = std::max<int>(1, static_cast<int>(dbExecutorWorkers()));
+    const int waiting = g_waiting_on_db.load(std::memory_order_relaxed);
+    const double busy = busyRate();
+
+    bool shed = false;
+    switch (tag.priority) {
+    case RoutePriority::Critical:
+        break;
+    case RoutePriority::Normal:
+        shed = waiting >= workers * kNormalQueuePerWorker || busy >= kNormalBusyRate;
+        break;
+    case RoutePriority::Low:
+        shed = waiting >= workers * kLowQueuePerWorker || busy >= kLowBusyRate;
+        break;
+    }
+
+    if (shed) {
+        g_shed[classIndex(tag.cls)].fetch_add(1, std::memory_order_relaxed);
+        int retry_after = 1 + waiting / (workers * kNormalQueuePerWorker);
+        if (busy >= kNormalBusyRate) {
+            retry_after += 2;
+        }
+        res = crow::response(503, "The server is busy. Please try again in a moment.");
+        res.set_header("Retry-After", std::to_string(std::min(retry_after, kMaxRetryAfterSeconds)));
+        return false;
+    }
+
+    bucketFor(currentSlot()).ops.fetch_add(1, std::memory_order_relaxed);
+    g_in_flight[classIndex(tag.cls)].fetch_add(1, std::memory_order_relaxed);
+    g_waiting_on_db.fetch_add(1, std::memory_order_relaxed);
+    return true;
+}
+
+void releaseDbRequest(const RouteTag& tag) {
+    g_in_flight[classIndex(tag.cls)].fetch_sub(1, std::memory_order_relaxed);
+    g_waiting_on_db.fetch_sub(1, std::memory_order_relaxed);
+}
+
+void noteSqliteBusy() {
+    g_busy_total.fetch_add(1, std::memory_order_relaxed);
+    bucketFor(currentSlot()).busy.fetch_add(1, std::memory_order_relaxed);
+}
+
+AdmissionTicket::AdmissionTicket(const RouteTag& tag) : cls_(tag.cls) {
+    g_in_flight[classIndex(cls_)].fetch_add(1, std::memory_order_relaxed);
+}
+
+AdmissionTicket::~AdmissionTicket() {
+    g_in_flight[classIndex(cls_)].fetch_sub(1, std::memory_order_relaxed);
+}
+
+AdmissionStats admissionStats() {
+    AdmissionStats stats{};
+    for (int i = 0; i < 3; ++i) {
+        stats.in_flight[i] = g_in_flight[i].load(std::memory_order_relaxed);
+        stats.shed[i] = g_shed[i].load(std::memory_order_relaxed);
+    }
+    stats.waiting_on_db = g_waiting_on_db.load(std::memory_order_relaxed);
+    stats.busy_rate = busyRate();
+    stats.busy_total = g_busy_total.load(std::memory_order_relaxed);
+    return stats;
+}
@@ -0,0 +1,68 @@
+#pragma once
+
+#include <crow.h>
+
+#include <cstddef>
+#include <string>
+
+// Coarse class of a route, used for in-flight accounting and load shedding.
+enum class RouteClass { Static, ReadApi, WriteApi };
+
+// Critical routes (booking writes, static pages) are never shed; Low routes
+// (admin/dev tools) are shed first.
+enum class RoutePriority { Low, Normal, Critical };
+
+// Routes registered beyond this are served but left out of per-route
+// statistics (metrics, stage timings).
+constexpr int kMaxTrackedRoutes = 64;
+
+struct RouteTag {
+    int id;
+    const char* name;
+    RouteClass cls;
+    RoutePriority priority;
+    int deadline_ms; // 0 = no deadline
+};
+
+// Registers a route once at startup and returns its tag. A negative
+// deadline picks the class default: 2 s for reads, none for writes (an
+// interrupted booking would leave half-written rows) and static pages.
+RouteTag routeTag(const char* name, RouteClass cls, RoutePriority priority = RoutePriority::Normal,
+                  int deadline_ms = -1);
+
+// Name of a registered route (or "" for an unknown id).
+std::string routeName(int id);
+std::size_t routeCount();
+
+// Admission for routes that go through the DB executor. When the request is
+// shed, `res` is filled with 503 + Retry-After and false is returned.
+bool admitDbRequest(const RouteTag& tag, crow::response& res);
+
+// Pairs with a successful admitDbRequest() once the response has been sent.
+void releaseDbRequest(const RouteTag& tag);
+
+// Called by the SQLite busy handler the first time a statement hits a lock.
+void noteSqliteBusy();
+
+// In-flight tracking for routes that never touch the DB (never shed).
+class AdmissionTicket {
+public:
+    explicit AdmissionTicket(const RouteTag& tag);
+    ~AdmissionTicket();
+
+    AdmissionTicket(const AdmissionTicket&) = delete;
+    AdmissionTicket& operator=(const AdmissionTicket&) = delete;
+
+private:
+    RouteClass cls_;
+};
+
+struct AdmissionStats {
+    int in_flight[3];
+    unsigned long long shed[3];
+    int waiting_on_db;
+    double busy_rate;
+    unsigned long long busy_total; // statements that hit SQLITE_BUSY
+};
+
+AdmissionStats admissionStats();
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// Traffic capture file layout (written by traffic_capture.cpp, read by
+// tools/replay.cpp). Integers are unsigned LEB128 varints.
+//
+//   file    := magic record*
+//   magic   := "CRWCAP1\n"
+//   record  := varint(delta_us) string(method) string(target)
+//              varint(header_count) header* string(body)
+//   header  := string(name) string(value)
+//   string  := varint(length) bytes
+//
+// delta_us is the time since the previous record (the first record counts
+// from the start of the capture); method is the name ("GET", "POST", ...);
+// target is the raw URL including the query string.
+constexpr char kCaptureMagic[] = "CRWCAP1\n";
+constexpr std::size_t kCaptureMagicSize = sizeof(kCaptureMagic) - 1;
+
+inline void appendVarint(std::string& out, uint64_t value) {
+    while (value >= 0x80) {
+        out += static_cast<char>((value & 0x7f) | 0x80);
+        value >>= 7;
+    }
+    out += static_cast<char>(value);
+}
+
+inline void appendCaptureString(std::string& out, const std::string& value) {
+    appendVarint(out, value.size());
+    out += value;
+}
+
+// Reads from data[pos..size); false on truncated input.
+inline bool readVarint(const char* data, std::size_t size, std::size_t& pos, uint64_t& value) {
+    value = 0;
+    for (int shift = 0; shift < 64 && pos < size; shift += 7) {
+        const auto byte = static_cast<unsigned char>(data[pos++]);
+        value |= static_cast<uint64_t>(byte & 0x7f) << shift;
+        if (!(byte & 0x80)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+inline bool readCaptureString(const char* data, std::size_t size, std::size_t& pos, std::string& value) {
+    uint64_t length = 0;
+    if (!readVarint(data, size, pos, length) || length > size - pos) {
+        return false;
+    }
+    value.assign(data + pos, static_cast<std::size_t>(length));
+    pos += static_cast<std::size_t>(length);
+    return true;
+}
@@ -0,0 +1,149 @@
+#include "change_feed.h"
+#include "logger.h"
+
+#include <atomic>
+#include <cstring>
+#include <exception>
+#include <memory>
+#include <mutex>
+
+namespace {
+
+// Matches SQLITE_DEFAULT_WAL_AUTOCHECKPOINT; installing a WAL hook replaces
+// SQLite's own auto-checkpoint, so the hook runs it instead.
+constexpr int kAutoCheckpointPages = 1000;
+
+struct Subscription {
+    std::vector<std::string> tables;
+    ChangeSubscriber subscriber;
+};
+
+// Written during startup only; read without locking afterwards.
+std::vector<Subscription> g_subscriptions;
+
+// Changes of the open transaction on one connection. A connection is used
+// by one thread at a time, so no locking.
+struct ConnectionFeed {
+    std::vector<RowChange> pending;
+    bool wal = false;
+};
+
+std::mutex g_feeds_mutex;
+std::vector<std::unique_ptr<ConnectionFeed>> g_feeds;
+
+std::atomic<unsigned long long> g_transactions{0};
+std::atomic<unsigned long long> g_rows{0};
+std::atomic<unsigned long long> g_rollbacks{0};
+
+bool subscribedTo(const Subscription& subscription, const std::string& table) {
+    for (const std::string& name : subscription.tables) {
+        if (sqlite3_stricmp(name.c_str(), table.c_str()) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void publish(ConnectionFeed& feed) {
+    if (feed.pending.empty()) {
+        return;
+    }
+    std::vector<RowChange> changes;
+    changes.swap(feed.pending);
+    g_transactions.fetch_add(1, std::memory_order_relaxed);
+    g_rows.fetch_add(changes.size(), std::memory_order_relaxed);
+
+    std::vector<RowChange> matched;
+    for (const Subscription& subscription : g_subscriptions) {
+        matched.clear();
+        for (const RowChange& change : changes) {
+            if (subscribedTo(subscription, change.table)) {
+                matched.push_back(change);
+            }
+        }
+        if (matched.empty()) {
+            continue;
+        }
+        // Called from SQLite hooks: nothing may unwind through them.
+        try {
+            subscription.subscriber(matched);
+        } catch (const std::exception& e) {
+            LOG_ERROR("Change subscriber failed", "table", matched.front().table, "error", e.what());
+        }
+    }
+}
+
+void updateHook(void* arg, int op, const char* database, const char* table, sqlite3_int64 rowid) {
+    if (std::strcmp(database, "main") != 0) {
+        return; // temp tables are private to the connection
+    }
+    ChangeOp change = ChangeOp::Update;
+    if (op == SQLITE_INSERT) {
+        change = ChangeOp::Insert;
+    } else if (op == SQLITE_DELETE) {
+        change = ChangeOp::Delete;
+    }
+    static_cast<ConnectionFeed*>(arg)->pending.push_back({table, rowid, change});
+}
+
+// Runs just before the commit is written. In WAL mode the WAL hook publishes
+// once it has; other journal modes have no later hook, so publish here.
+int commitHook(void* arg) {
+    auto* feed = static_cast<ConnectionFeed*>(arg);
+    if (!feed->wal) {
+        publish(*feed);
+    }
+    return 0;
+}
+
+void rollbackHook(void* arg) {
+    auto* feed = static_cast<ConnectionFeed*>(arg);
+    if (!feed->pending.empty()) {
+        feed->pending.clear();
+        g_rollbacks.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+int walHook(void* arg, sqlite3* db, const char* database, int pages) {
+    publish(*static_cast<ConnectionFeed*>(arg));
+    if (pages >= kAutoCheckpointPages) {
+        sqlite3_wal_checkpoint_v2(db, database, SQLITE_CHECKPOINT_PASSIVE, nullptr, nullptr);
+    }
+    return SQLITE_OK;
+}
+
+int journalModeRow(void* out, int, char** values, char**) {
+    *static_cast<std::string*>(out) = values[0] ? values[0] : "";
+    return 0;
+}
+
+} // namespace
+
+void installChangeFeed(sqlite3* db) {
+    auto feed = std::make_unique<ConnectionFeed>();
+    std::string journal_mode;
+    sqlite3_exec(db, "PRAGMA journal_mode;", journalModeRow, &journal_mode, nullptr);
+    feed->wal = sqlite3_stricmp(journal_mode.c_str(), "wal") == 0;
+    if (!feed->wal) {
+        LOG_WARN("Change feed publishing before commit", "journal_mode", journal_mode);
+    }
+
+    sqlite3_update_hook(db, updateHook, feed.get());
+    sqlite3_commit_hook(db, commitHook, feed.get());
+    sqlite3_rollback_hook(db, rollbackHook, feed.get());
+    if (feed->wal) {
+        sqlite3_wal_hook(db, walHook, feed.get());
+    }
+
+    std::lock_guard<std::mutex> lock(g_feeds_mutex);
+    g_feeds.push_back(std::move(feed));
+}
+
+void subscribeChanges(std::vector<std::string> tables, ChangeSubscriber subscriber) {
+    g_subscriptions.push_back({std::move(tables), std::move(subscriber)});
+}
+
+ChangeFeedStats changeFeedStats() {
+    return {g_transactions.load(std::memory_order_relaxed), g_rows.load(std::memory_order_relaxed),
+            g_rollbacks.load(std::memory_order_relaxed)};
+}
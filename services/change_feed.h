@@ -0,0 +1,40 @@
+#pragma once
+
+#include <sqlite3.h>
+
+#include <functional>
+#include <string>
+#include <vector>
+
+enum class ChangeOp { Insert, Update, Delete };
+
+struct RowChange {
+    std::string table;
+    sqlite3_int64 rowid;
+    ChangeOp op;
+};
+
+// Receives the rows one committed transaction changed in the tables it
+// subscribed to, in statement order, on the thread that committed.
+using ChangeSubscriber = std::function<void(const std::vector<RowChange>& changes)>;
+
+// Hooks sqlite3_update_hook, commit and rollback hooks on `db`. Row changes
+// are buffered per transaction and published once the commit has landed (from
+// the WAL hook, which also keeps the 1000-page auto-checkpoint), so nobody
+// re-reads and re-caches rows that are not visible yet. Rolled-back changes
+// are dropped. Catches every write path: admin routes, /block_slot, cascades
+// run by foreign-key actions and triggers.
+void installChangeFeed(sqlite3* db);
+
+// Calls `subscriber` for committed changes to any of `tables` (SQLite table
+// names, case-insensitive). Subscribe during startup, before requests run;
+// subscribers must not run SQL on the connection they are called from.
+void subscribeChanges(std::vector<std::string> tables, ChangeSubscriber subscriber);
+
+struct ChangeFeedStats {
+    unsigned long long transactions; // committed with at least one row change
+    unsigned long long rows;         // row changes published
+    unsigned long long rollbacks;    // transactions whose changes were dropped
+};
+
+ChangeFeedStats changeFeedStats();
@@ -0,0 +1,347 @@
+#include "db_executor.h"
+#include "change_feed.h"
+#include "metrics.h"
+#include "logger.h"
+#include "rate_limiter.h"
+#include "sql_statements.h"
+#include "stage_timing.h"
+#include "stmt_stats.h"
+#include "traffic_capture.h"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace {
+
+// Beyond this many queued tasks new DB requests are answered with 503
+// instead of waiting behind a backlog that cannot finish in time.
+constexpr std::size_t kMaxQueuedTasks = 4096;
+
+// Same total wait as the old sqlite3_busy_timeout(db, 5000).
+constexpr int kBusyTimeoutMillis = 5000;
+
+using Task = std::function<void(sqlite3*)>;
+
+// Priority lane: writes and Critical reads. Read lane: everything else.
+std::deque<Task> g_db_tasks;
+std::deque<Task> g_db_read_tasks;
+std::mutex g_db_tasks_mutex;
+std::condition_variable g_db_tasks_cv;
+bool g_db_running = false;
+std::size_t g_running_reads = 0;
+std::size_t g_max_running_reads = 1;
+
+std::vector<std::thread> g_db_workers;
+std::vector<sqlite3*> g_db_connections;
+
+// SQLite VM instructions between deadline / disconnect checks.
+constexpr int kProgressOpsInterval = 1000;
+
+std::atomic<unsigned long long> g_timed_out{0};
+std::atomic<unsigned long long> g_cancelled{0};
+
+// Deadline and client of the task running on this executor thread.
+struct QueryBudget {
+    sqlite3* db;
+    std::chrono::steady_clock::time_point deadline;
+    crow::response* res; // null: do not cancel when the client goes away
+    bool timed_out = false;
+    bool disconnected = false;
+    unsigned ticks = 0;
+};
+
+thread_local QueryBudget* t_budget = nullptr;
+
+bool budgetExhausted(QueryBudget& budget) {
+    if (budget.timed_out || budget.disconnected) {
+        return true;
+    }
+    if (std::chrono::steady_clock::now() >= budget.deadline) {
+        budget.timed_out = true;
+        return true;
+    }
+    // The liveness check touches the socket; poll it less often than the clock.
+    if (budget.res && (++budget.ticks & 7) == 0 && !budget.res->is_alive()) {
+        budget.disconnected = true;
+        sqlite3_interrupt(budget.db);
+        return true;
+    }
+    return false;
+}
+
+int progressHandler(void* arg) {
+    return budgetExhausted(*static_cast<QueryBudget*>(arg)) ? 1 : 0;
+}
+
+bool readTaskRunnable() {
+    // While stopping, drain reads on every worker so shutdown never spins.
+    return !g_db_read_tasks.empty() &&
+           (g_running_reads < g_max_running_reads || !g_db_running);
+}
+
+void workerLoop(sqlite3* db) {
+    for (;;) {
+        Task task;
+        bool is_read = false;
+        {
+            std::unique_lock<std::mutex> lock(g_db_tasks_mutex);
+            g_db_tasks_cv.wait(lock, [] {
+                return !g_db_running || !g_db_tasks.empty() || readTaskRunnable();
+            });
+            if (!g_db_tasks.empty()) {
+                task = std::move(g_db_tasks.front());
+                g_db_tasks.pop_front();
+            } else if (readTaskRunnable()) {
+                task = std::move(g_db_read_tasks.front());
+                g_db_read_tasks.pop_front();
+                is_read = true;
+                ++g_running_reads;
+            } else {
+                return;
+            }
+        }
+
+        task(db);
+
+        if (is_read) {
+            {
+                std::lock_guard<std::mutex> lock(g_db_tasks_mutex);
+                --g_running_reads;
+            }
+            g_db_tasks_cv.notify_all();
+        }
+    }
+}
+
+// Mirrors SQLite's default busy-timeout backoff, but reports the first wait
+// of every statement so admission control can see lock contention.
+int busyHandler(void*, int count) {
+    static const int delays[] = {1, 2, 5, 10, 15, 20, 25, 25, 25, 50, 50, 100};
+    static const int total_before[] = {0, 1, 3, 8, 18, 33, 53, 78, 103, 128, 178, 228};
+    constexpr int steps = sizeof(delays) / sizeof(delays[0]);
+
+    if (count == 0) {
+        noteSqliteBusy();
+    }
+    // The progress handler does not run while waiting on a lock.
+    if (t_budget && budgetExhausted(*t_budget)) {
+        return 0;
+    }
+
+    int delay;
+    int prior;
+    if (count < steps) {
+        delay = delays[count];
+        prior = total_before[count];
+    } else {
+        delay = delays[steps - 1];
+        prior = total_before[steps - 1] + delay * (count - (steps - 1));
+    }
+    if (prior + delay > kBusyTimeoutMillis) {
+        delay = kBusyTimeoutMillis - prior;
+        if (delay <= 0) {
+            return 0;
+        }
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(delay));
+    return 1;
+}
+
+} // namespace
+
+sqlite3* openDatabase(const std::string& path) {
+    sqlite3* db = nullptr;
+    if (sqlite3_open(path.c_str(), &db) != SQLITE_OK) {
+        LOG_ERROR("Failed to open DB", "error", sqlite3_errmsg(db));
+        sqlite3_close(db);
+        return nullptr;
+    }
+    sqlite3_busy_handler(db, busyHandler, nullptr);
+    installStatementStats(db);
+
+    char* pragma_err = nullptr;
+    sqlite3_exec(db, "PRAGMA journal_mode=WAL;", nullptr, nullptr, &pragma_err);
+    if (pragma_err) {
+        LOG_ERROR("PRAGMA journal_mode failed", "error", pragma_err);
+        sqlite3_free(pragma_err);
+        pragma_err = nullptr;
+    }
+    sqlite3_exec(db, "PRAGMA synchronous=NORMAL;", nullptr, nullptr, &pragma_err);
+    if (pragma_err) {
+        LOG_ERROR("PRAGMA synchronous failed", "error", pragma_err);
+        sqlite3_free(pragma_err);
+    }
+    installChangeFeed(db); // after journal_mode: it picks the publish point
+    if (!prepareStatements(db)) {
+        closeDatabase(db);
+        return nullptr;
+    }
+    return db;
+}
+
+void closeDatabase(sqlite3* db) {
+    finalizeStatements(db);
+    sqlite3_close(db);
+}
+
+bool startDbExecutor(const std::string& path, std::size_t workers) {
+    if (workers == 0) {
+        workers = 1;
+    }
+
+    for (std::size_t i = 0; i < workers; ++i) {
+        sqlite3* db = openDatabase(path);
+        if (!db) {
+            for (sqlite3* opened : g_db_connections) {
+                closeDatabase(opened);
+            }
+            g_db_connections.clear();
+            return false;
+        }
+        g_db_connections.push_back(db);
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(g_db_tasks_mutex);
+        g_db_running = true;
+        // Keep one worker free for bookings whenever there is more than one.
+        g_max_running_reads = workers > 1 ? workers - 1 : 1;
+    }
+    for (sqlite3* db : g_db_connections) {
+        g_db_workers.emplace_back(workerLoop, db);
+    }
+    return true;
+}
+
+void stopDbExecutor() {
+    {
+        std::lock_guard<std::mutex> lock(g_db_tasks_mutex);
+        g_db_running = false;
+    }
+    g_db_tasks_cv.notify_all();
+
+    for (std::thread& worker : g_db_workers) {
+        worker.join();
+    }
+    g_db_workers.clear();
+
+    for (sqlite3* db : g_db_connections) {
+        closeDatabase(db);
+    }
+    g_db_connections.clear();
+}
+
+void respondFromDb(const crow::request& req, crow::response& res, const RouteTag& tag, DbWork work) {
+    captureRequest(req);
+    if (!rateLimitAllow(req, RateBucket::Api, res)) {
+        endResponse(tag, res);
+        return;
+    }
+    submitDbWork(req, res, tag, std::move(work));
+}
+
+bool submitDbWork(const crow::request& req, crow::response& res, const RouteTag& tag, DbWork work,
+                  bool cancel_on_disconnect, DbDone done) {
+    const auto arrived = std::chrono::steady_clock::now();
+    if (!admitDbRequest(tag, res)) {
+        if (done) {
+            done(res);
+        }
+        endResponse(tag, res, arrived);
+        return false;
+    }
+
+    // The budget starts at admission, so time spent queued counts against it.
+    const auto deadline = tag.deadline_ms > 0
+        ? arrived + std::chrono::milliseconds(tag.deadline_ms)
+        : std::chrono::steady_clock::time_point::max();
+
+    // Crow keeps the connection (and therefore req/res) alive until res.end().
+    Task task = [&req, &res, tag, arrived, deadline, cancel_on_disconnect, work = std::move(work), done](sqlite3* db) {
+        RequestTiming timing(Stage::Db);
+        timing.add(Stage::Queue, std::chrono::steady_clock::now() - arrived);
+
+        QueryBudget budget{db, deadline, cancel_on_disconnect ? &res : nullptr};
+        if (tag.deadline_ms > 0) {
+            sqlite3_progress_handler(db, kProgressOpsInterval, progressHandler, &budget);
+            t_budget = &budget;
+        }
+
+        if (tag.deadline_ms > 0 && std::chrono::steady_clock::now() >= deadline) {
+            budget.timed_out = true;
+        } else {
+            try {
+                res = work(req, db);
+            } catch (const std::exception& e) {
+                LOG_ERROR("DB task failed", "route", tag.name, "error", e.what());
+                res = crow::response(500, "Sorry, something went wrong. Please try again.");
+            }
+        }
+
+        if (tag.deadline_ms > 0) {
+            sqlite3_progress_handler(db, 0, nullptr, nullptr);
+            t_budget = nullptr;
+        }
+        if (budget.disconnected) {
+            g_cancelled.fetch_add(1, std::memory_order_relaxed);
+        } else if (budget.timed_out) {
+            g_timed_out.fetch_add(1, std::memory_order_relaxed);
+            res = dbTimeoutResponse();
+        }
+        timing.finish(tag, res);
+        if (done) {
+            done(res);
+        }
+        endResponse(tag, res, arrived);
+        releaseDbRequest(tag);
+    };
+
+    const bool priority = tag.cls == RouteClass::WriteApi || tag.priority == RoutePriority::Critical;
+    {
+        std::lock_guard<std::mutex> lock(g_db_tasks_mutex);
+        if (g_db_running && g_db_tasks.size() + g_db_read_tasks.size() < kMaxQueuedTasks) {
+            (priority ? g_db_tasks : g_db_read_tasks).push_back(std::move(task));
+            task = nullptr;
+        }
+    }
+
+    if (task) {
+        releaseDbRequest(tag);
+        res = crow::response(503, "The server is busy. Please try again in a moment.");
+        res.set_header("Retry-After", "1");
+        if (done) {
+            done(res);
+        }
+        endResponse(tag, res, arrived);
+        return false;
+    }
+    g_db_tasks_cv.notify_one();
+    return true;
+}
+
+std::size_t dbExecutorPending() {
+    std::lock_guard<std::mutex> lock(g_db_tasks_mutex);
+    return g_db_tasks.size() + g_db_read_tasks.size();
+}
+
+std::size_t dbExecutorWorkers() {
+    return g_db_connections.size();
+}
+
+DbDeadlineStats dbDeadlineStats() {
+    return {g_timed_out.load(std::memory_order_relaxed), g_cancelled.load(std::memory_order_relaxed)};
+}
+
+bool dbTaskTimedOut() {
+    return t_budget && t_budget->timed_out;
+}
+
+crow::response dbTimeoutResponse() {
+    return crow::response(504, "Sorry, that took too long. Please try again.");
+}
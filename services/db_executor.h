@@ -0,0 +1,72 @@
+#pragma once
+
+#include <crow.h>
+#include <sqlite3.h>
+
+#include "admission.h"
+
+#include <cstddef>
+#include <functional>
+#include <string>
+
+// Work executed on a DB executor thread. `db` is the worker's own connection.
+using DbWork = std::function<crow::response(const crow::request& req, sqlite3* db)>;
+
+// Sees the final response just before it is sent.
+using DbDone = std::function<void(const crow::response& res)>;
+
+// Opens a connection with the pragmas every connection in this server uses,
+// a busy handler that waits up to 5 s and reports lock contention, the
+// statement statistics hook, the change feed and every statement in
+// sql_statements.h prepared. Returns nullptr (and logs) on failure, including
+// when a statement no longer matches the schema.
+sqlite3* openDatabase(const std::string& path);
+
+// Closes a connection from openDatabase(), finalizing its statements.
+void closeDatabase(sqlite3* db);
+
+// Starts `workers` executor threads, each with its own connection to `path`.
+bool startDbExecutor(const std::string& path, std::size_t workers);
+
+// Stops accepting work, drains queued tasks and closes worker connections.
+void stopDbExecutor();
+
+// Queues `work` on the DB executor and completes `res` from there (res.end()).
+// The calling network thread returns immediately, so slow SQLite work never
+// blocks page and asset requests. Clients over the RateBucket::Api limit get
+// 429; the rest go through submitDbWork().
+void respondFromDb(const crow::request& req, crow::response& res, const RouteTag& tag, DbWork work);
+
+// Admits the request according to `tag` and queues `work`. WriteApi and
+// Critical work is dequeued before reads, and reads may occupy at most
+// all-but-one worker. Returns false when the request was shed and `res` has
+// already been completed with 503.
+//
+// Routes with a deadline (tag.deadline_ms) are measured from admission: work
+// that is still queued at the deadline never runs, and running statements are
+// aborted through sqlite3_progress_handler; either way the client gets 504.
+// When the client disconnects the statement is stopped with sqlite3_interrupt,
+// unless `cancel_on_disconnect` is false (other requests share the result).
+//
+// `done`, when set, is called exactly once on every path: after `work`, after
+// a deadline expired in the queue (when `work` never runs), and when the
+// request is shed.
+bool submitDbWork(const crow::request& req, crow::response& res, const RouteTag& tag, DbWork work,
+                  bool cancel_on_disconnect = true, DbDone done = nullptr);
+
+// Tasks queued but not yet picked up by a worker.
+std::size_t dbExecutorPending();
+
+std::size_t dbExecutorWorkers();
+
+struct DbDeadlineStats {
+    unsigned long long timed_out; // answered 504
+    unsigned long long cancelled; // client went away mid-query
+};
+
+DbDeadlineStats dbDeadlineStats();
+
+// True when the task running on this executor thread has blown its deadline
+// (its statements are being aborted). The 504 it will be answered with:
+bool dbTaskTimedOut();
+crow::response dbTimeoutResponse();
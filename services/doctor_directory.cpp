@@ -0,0 +1,147 @@
+#include "doctor_directory.h"
+
+#include "json_writer.h"
+#include "logger.h"
+#include "sql_statements.h"
+#include "stage_timing.h"
+
+#include <atomic>
+#include <map>
+#include <mutex>
+#include <utility>
+
+namespace {
+
+constexpr auto kDirectoryTtl = std::chrono::seconds(60);
+
+std::atomic<uint64_t> g_version{1};
+std::atomic<unsigned long long> g_loads{0};
+std::atomic<unsigned long long> g_invalidations{0};
+
+std::mutex g_directory_mutex;
+std::shared_ptr<const DoctorDirectory> g_directory;
+uint64_t g_directory_version = 0;
+std::chrono::steady_clock::time_point g_loaded_at;
+
+// Serializes loads, so a burst of misses queries the table once.
+std::mutex g_load_mutex;
+
+// The Doctor fields only; category_name is for the server's own lookups.
+std::string renderDoctors(const std::vector<const DirectoryDoctor*>& doctors) {
+    JsonWriter out(160 * doctors.size() + 2);
+    out.beginArray();
+    for (const DirectoryDoctor* d : doctors) {
+        writeObject<Doctor>(out, *d);
+    }
+    out.endArray();
+    return out.take();
+}
+
+CachedBody renderBody(const std::vector<const DirectoryDoctor*>& doctors) {
+    std::string json = renderDoctors(doctors);
+    std::string etag = bodyEtag(json);
+    return {std::move(json), std::move(etag)};
+}
+
+bool queryDoctors(sqlite3* db, std::vector<DirectoryDoctor>& doctors) {
+    auto rows = query(db, sql::kDoctorDirectory);
+    while (rows.step()) {
+        readRow(rows, doctors.emplace_back());
+    }
+    if (!rows.done()) {
+        LOG_ERROR("Loading doctor directory failed", "error", sqlite3_errmsg(db));
+        return false;
+    }
+    return true;
+}
+
+} // namespace
+
+DoctorDirectory::DoctorDirectory(std::vector<DirectoryDoctor> doctors) : doctors_(std::move(doctors)) {
+    std::map<int, std::vector<const DirectoryDoctor*>> by_category;
+    std::vector<const DirectoryDoctor*> all;
+    for (std::size_t i = 0; i < doctors_.size(); ++i) {
+        const DirectoryDoctor& d = doctors_[i];
+        by_id_.emplace(d.doctor_id, i);
+        by_name_.emplace(d.doctor_name, i);
+        by_category[d.category_id].push_back(&d);
+        all.push_back(&d);
+    }
+    for (const auto& [category_id, members] : by_category) {
+        category_bodies_.emplace(category_id, renderBody(members));
+    }
+    all_body_ = renderBody(all);
+    empty_body_ = renderBody({});
+}
+
+const DirectoryDoctor* DoctorDirectory::byId(int doctor_id) const {
+    auto it = by_id_.find(doctor_id);
+    return it == by_id_.end() ? nullptr : &doctors_[it->second];
+}
+
+const DirectoryDoctor* DoctorDirectory::byName(const std::string& doctor_name) const {
+    auto it = by_name_.find(doctor_name);
+    return it == by_name_.end() ? nullptr : &doctors_[it->second];
+}
+
+const CachedBody& DoctorDirectory::categoryBody(int category_id) const {
+    auto it = category_bodies_.find(category_id);
+    return it == category_bodies_.end() ? empty_body_ : it->second;
+}
+
+std::shared_ptr<const DoctorDirectory> currentDoctorDirectory() {
+    std::lock_guard<std::mutex> lock(g_directory_mutex);
+    if (g_directory && g_directory_version == g_version.load(std::memory_order_acquire) &&
+        std::chrono::steady_clock::now() - g_loaded_at < kDirectoryTtl) {
+        return g_directory;
+    }
+    return nullptr;
+}
+
+std::shared_ptr<const DoctorDirectory> doctorDirectory(sqlite3* db) {
+    if (auto directory = currentDoctorDirectory()) {
+        return directory;
+    }
+
+    std::lock_guard<std::mutex> load_lock(g_load_mutex);
+    if (auto directory = currentDoctorDirectory()) {
+        return directory; // another thread loaded it while we waited
+    }
+
+    // Read before querying: a write committed after this point bumps the
+    // version, and this snapshot is used once but not kept.
+    const uint64_t version = g_version.load(std::memory_order_acquire);
+    std::vector<DirectoryDoctor> doctors;
+    if (!queryDoctors(db, doctors)) {
+        return nullptr;
+    }
+    std::shared_ptr<const DoctorDirectory> directory;
+    {
+        StageTimer timer(Stage::Serialize);
+        directory = std::make_shared<const DoctorDirectory>(std::move(doctors));
+    }
+    g_loads.fetch_add(1, std::memory_order_relaxed);
+
+    std::lock_guard<std::mutex> lock(g_directory_mutex);
+    if (version == g_version.load(std::memory_order_acquire)) {
+        g_directory = directory;
+        g_directory_version = version;
+        g_loaded_at = std::chrono::steady_clock::now();
+    }
+    return directory;
+}
+
+void invalidateDoctorDirectory() {
+    g_version.fetch_add(1, std::memory_order_acq_rel);
+    g_invalidations.fetch_add(1, std::memory_order_relaxed);
+}
+
+DoctorDirectoryStats doctorDirectoryStats() {
+    std::shared_ptr<const DoctorDirectory> directory;
+    {
+        std::lock_guard<std::mutex> lock(g_directory_mutex);
+        directory = g_directory;
+    }
+    return {g_loads.load(std::memory_order_relaxed), g_invalidations.load(std::memory_order_relaxed),
+            directory ? directory->size() : 0};
+}
@@ -0,0 +1,69 @@
+#pragma once
+
+#include <sqlite3.h>
+
+#include "../models/doctor.h"
+#include "etag.h"
+
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+struct DirectoryDoctor : Doctor {
+    std::string category_name; // empty if the category is gone
+
+    static constexpr auto fields() {
+        return std::tuple_cat(Doctor::fields(),
+                              std::make_tuple(field("category_name", &DirectoryDoctor::category_name)));
+    }
+};
+
+// Immutable snapshot of every doctor, with the /get_doctors bodies rendered
+// up front. Readers hold a shared_ptr, so a reload never disturbs them.
+class DoctorDirectory {
+public:
+    explicit DoctorDirectory(std::vector<DirectoryDoctor> doctors);
+
+    const DirectoryDoctor* byId(int doctor_id) const;
+    // Exact match, lowest doctor_id first (as WHERE doctor_name = ? did).
+    const DirectoryDoctor* byName(const std::string& doctor_name) const;
+
+    // The /get_doctors body for one category (an empty list for unknown ids).
+    // Each segment carries its own ETag, so a change to one category leaves
+    // the others' tags alone.
+    const CachedBody& categoryBody(int category_id) const;
+    // The /get_doctors body without a category filter.
+    const CachedBody& allBody() const { return all_body_; }
+
+    std::size_t size() const { return doctors_.size(); }
+
+private:
+    std::vector<DirectoryDoctor> doctors_; // by doctor_id
+    std::unordered_map<int, std::size_t> by_id_;
+    std::unordered_map<std::string, std::size_t> by_name_;
+    std::unordered_map<int, CachedBody> category_bodies_;
+    CachedBody all_body_;
+    CachedBody empty_body_;
+};
+
+// The directory if it is loaded and current; never touches the database.
+std::shared_ptr<const DoctorDirectory> currentDoctorDirectory();
+
+// The current directory, loading it through `db` first if needed (DB
+// executor threads only). Null if the load failed.
+std::shared_ptr<const DoctorDirectory> doctorDirectory(sqlite3* db);
+
+// Call after committing a change to Doctor or Category. Loaded snapshots
+// also expire after a minute, to pick up edits made outside the server.
+void invalidateDoctorDirectory();
+
+struct DoctorDirectoryStats {
+    unsigned long long loads;
+    unsigned long long invalidations;
+    std::size_t doctors; // in the current snapshot, 0 if none
+};
+
+DoctorDirectoryStats doctorDirectoryStats();
@@ -0,0 +1,81 @@
+#include "etag.h"
+
+#include "metrics.h"
+#include "traffic_capture.h"
+
+#include <atomic>
+#include <chrono>
+#include <cinttypes>
+#include <cstdio>
+
+namespace {
+
+std::atomic<unsigned long long> g_not_modified{0};
+
+bool isListSpace(char c) {
+    return c == ' ' || c == '\t' || c == ',';
+}
+
+} // namespace
+
+std::string bodyEtag(std::string_view body) {
+    uint64_t h = 1469598103934665603ULL; // FNV-1a
+    for (unsigned char c : body) {
+        h ^= c;
+        h *= 1099511628211ULL;
+    }
+    char tag[24];
+    std::snprintf(tag, sizeof(tag), "\"%016" PRIx64 "\"", h);
+    return tag;
+}
+
+bool etagMatches(const crow::request& req, const std::string& etag) {
+    const std::string& header = req.get_header_value("If-None-Match");
+    if (header.empty() || etag.empty()) {
+        return false;
+    }
+
+    // Comma-separated entity-tags; each is "..." or W/"...".
+    std::string_view rest = header;
+    while (!rest.empty()) {
+        while (!rest.empty() && isListSpace(rest.front())) {
+            rest.remove_prefix(1);
+        }
+        if (rest.empty()) {
+            break;
+        }
+        if (rest.front() == '*') {
+            return true;
+        }
+        if (rest.substr(0, 2) == "W/") {
+            rest.remove_prefix(2);
+        }
+        std::size_t end = rest.size();
+        if (!rest.empty() && rest.front() == '"') {
+            const std::size_t close = rest.find('"', 1);
+            end = close == std::string_view::npos ? rest.size() : close + 1;
+        } else {
+            const std::size_t comma = rest.find(',');
+            end = comma == std::string_view::npos ? rest.size() : comma;
+        }
+        if (rest.substr(0, end) == etag) {
+            return true;
+        }
+        rest.remove_prefix(end);
+    }
+    return false;
+}
+
+void respondNotModified(const crow::request& req, crow::response& res, const RouteTag& tag,
+                        const std::string& etag) {
+    captureRequest(req);
+    const auto start = std::chrono::steady_clock::now();
+    res.code = 304;
+    res.set_header("ETag", etag);
+    g_not_modified.fetch_add(1, std::memory_order_relaxed);
+    endResponse(tag, res, start);
+}
+
+unsigned long long notModifiedResponses() {
+    return g_not_modified.load(std::memory_order_relaxed);
+}
@@ -0,0 +1,31 @@
+#pragma once
+
+#include <crow.h>
+
+#include "admission.h"
+
+#include <string>
+#include <string_view>
+
+// A pre-serialized JSON body and its strong ETag.
+struct CachedBody {
+    std::string json;
+    std::string etag;
+};
+
+// Strong validator for a response body: the quoted 64-bit FNV-1a of its
+// bytes, so identical bodies get identical tags across reloads and restarts.
+std::string bodyEtag(std::string_view body);
+
+// True when the request's If-None-Match lists `etag` or is "*". Uses the
+// weak comparison RFC 9110 prescribes for If-None-Match (W/ is ignored).
+bool etagMatches(const crow::request& req, const std::string& etag);
+
+// Completes `res` with 304 and the ETag header. No DB work, no body. The
+// request is captured; rate limits are the caller's, charged before its
+// session check.
+void respondNotModified(const crow::request& req, crow::response& res, const RouteTag& tag,
+                        const std::string& etag);
+
+// Requests answered with 304 so far.
+unsigned long long notModifiedResponses();
@@ -0,0 +1,139 @@
+#include "json_writer.h"
+
+#include <charconv>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+
+JsonWriter& JsonWriter::key(std::string_view name) {
+    separate();
+    out_ += '"';
+    appendEscaped(name);
+    out_ += "\":";
+    after_key_ = true;
+    return *this;
+}
+
+JsonWriter& JsonWriter::value(std::string_view text) {
+    separate();
+    out_ += '"';
+    appendEscaped(text);
+    out_ += '"';
+    return *this;
+}
+
+JsonWriter& JsonWriter::value(int64_t number) {
+    separate();
+    char digits[24];
+    const std::to_chars_result end = std::to_chars(digits, digits + sizeof(digits), number);
+    out_.append(digits, end.ptr);
+    return *this;
+}
+
+JsonWriter& JsonWriter::value(double number) {
+    if (!std::isfinite(number)) {
+        return null();
+    }
+    separate();
+    // Shortest of the usual precisions that reads back exactly: 4.7, not
+    // 4.7000000000000002.
+    char digits[32];
+    int n = std::snprintf(digits, sizeof(digits), "%.15g", number);
+    if (std::strtod(digits, nullptr) != number) {
+        n = std::snprintf(digits, sizeof(digits), "%.17g", number);
+    }
+    out_.append(digits, static_cast<std::size_t>(n));
+    return *this;
+}
+
+JsonWriter& JsonWriter::value(bool flag) {
+    separate();
+    out_ += flag ? "true" : "false";
+    return *this;
+}
+
+JsonWriter& JsonWriter::null() {
+    separate();
+    out_ += "null";
+    return *this;
+}
+
+JsonWriter& JsonWriter::textColumn(sqlite3_stmt* stmt, int column) {
+    const unsigned char* text = sqlite3_column_text(stmt, column);
+    const int bytes = sqlite3_column_bytes(stmt, column); // after _text, as SQLite requires
+    return value(text ? std::string_view(reinterpret_cast<const char*>(text), static_cast<std::size_t>(bytes))
+                      : std::string_view());
+}
+
+crow::response JsonWriter::response(int code) {
+    crow::response res(code, take());
+    res.set_header("Content-Type", "application/json");
+    return res;
+}
+
+JsonWriter& JsonWriter::open(char bracket) {
+    separate();
+    out_ += bracket;
+    ++depth_;
+    has_member_ &= ~(uint64_t{1} << (depth_ & 63));
+    return *this;
+}
+
+JsonWriter& JsonWriter::close(char bracket) {
+    out_ += bracket;
+    --depth_;
+    return *this;
+}
+
+void JsonWriter::separate() {
+    if (after_key_) {
+        after_key_ = false; // the value of a member: the key placed the comma
+        return;
+    }
+    const uint64_t bit = uint64_t{1} << (depth_ & 63);
+    if (depth_ > 0 && (has_member_ & bit)) {
+        out_ += ',';
+    }
+    has_member_ |= bit;
+}
+
+void JsonWriter::appendEscaped(std::string_view text) {
+    static const char kHex[] = "0123456789abcdef";
+    std::size_t run = 0; // start of the pending run of bytes that need no escaping
+    for (std::size_t i = 0; i < text.size(); ++i) {
+        const unsigned char c = static_cast<unsigned char>(text[i]);
+        if (c >= 0x20 && c != '"' && c != '\\') {
+            continue;
+        }
+        out_.append(text.data() + run, i - run);
+        run = i + 1;
+        switch (c) {
+        case '"':
+            out_ += "\\\"";
+            break;
+        case '\\':
+            out_ += "\\\\";
+            break;
+        case '\n':
+            out_ += "\\n";
+            break;
+        case '\r':
+            out_ += "\\r";
+            break;
+        case '\t':
+            out_ += "\\t";
+            break;
+        case '\b':
+            out_ += "\\b";
+            break;
+        case '\f':
+            out_ += "\\f";
+            break;
+        default:
+            out_ += "\\u00";
+            out_ += kHex[c >> 4];
+            out_ += kHex[c & 0xF];
+        }
+    }
+    out_.append(text.data() + run, text.size() - run);
+}
@@ -0,0 +1,67 @@
+#pragma once
+
+#include <crow.h>
+#include <sqlite3.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+// Writes JSON straight into one growing buffer: no wvalue tree, no per-node
+// allocations, and column text is escaped from SQLite's buffer without an
+// intermediate std::string. Commas are placed automatically; the caller is
+// responsible for balancing begin/end and for putting key() before each
+// object member.
+//
+//   JsonWriter out(64 * expected_rows);
+//   out.beginArray();
+//   while (sqlite3_step(stmt) == SQLITE_ROW) {
+//       out.beginObject().key("category_id").value(sqlite3_column_int(stmt, 0))
+//          .key("category_name").textColumn(stmt, 1).endObject();
+//   }
+//   out.endArray();
+//   return out.response(200);
+class JsonWriter {
+public:
+    explicit JsonWriter(std::size_t reserve = 256) { out_.reserve(reserve); }
+
+    JsonWriter& beginArray() { return open('['); }
+    JsonWriter& endArray() { return close(']'); }
+    JsonWriter& beginObject() { return open('{'); }
+    JsonWriter& endObject() { return close('}'); }
+
+    JsonWriter& key(std::string_view name);
+
+    JsonWriter& value(std::string_view text);
+    JsonWriter& value(const char* text) { return value(std::string_view(text)); }
+    JsonWriter& value(const std::string& text) { return value(std::string_view(text)); }
+    JsonWriter& value(int number) { return value(static_cast<int64_t>(number)); }
+    JsonWriter& value(int64_t number);
+    JsonWriter& value(double number); // non-finite values are written as null
+    JsonWriter& value(bool flag);
+    JsonWriter& null();
+
+    // Column `column` of the current row as a string; NULL is written as ""
+    // (what the list endpoints have always returned for missing text).
+    JsonWriter& textColumn(sqlite3_stmt* stmt, int column);
+
+    const std::string& str() const { return out_; }
+    std::string take() { return std::move(out_); }
+
+    // The buffer as a `code` response with Content-Type application/json.
+    crow::response response(int code);
+
+private:
+    JsonWriter& open(char bracket);
+    JsonWriter& close(char bracket);
+    void separate();
+    void appendEscaped(std::string_view text);
+
+    std::string out_;
+    // One bit per open container, set once it has a member. Nesting beyond
+    // 64 levels is not supported (nothing here comes close).
+    uint64_t has_member_ = 0;
+    int depth_ = 0;
+    bool after_key_ = false;
+};
@@ -0,0 +1,53 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+
+// HDR-style log-linear buckets over microseconds: 4 sub-buckets per power of
+// two (~19% relative error), 1 us .. ~2 min. Shared by the route metrics and
+// the statement statistics so their percentiles are comparable.
+constexpr int kLatencySubBucketBits = 2;
+constexpr int kLatencySubBuckets = 1 << kLatencySubBucketBits;
+constexpr int kLatencyOctaves = 27;
+constexpr int kLatencyBuckets = kLatencyOctaves * kLatencySubBuckets;
+
+inline int latencyBucket(uint64_t us) {
+    if (us < static_cast<uint64_t>(kLatencySubBuckets)) {
+        return static_cast<int>(us);
+    }
+    const int octave = 63 - __builtin_clzll(us);
+    const int mantissa = static_cast<int>((us >> (octave - kLatencySubBucketBits)) & (kLatencySubBuckets - 1));
+    const int index = (octave - kLatencySubBucketBits + 1) * kLatencySubBuckets + mantissa;
+    return std::min(index, kLatencyBuckets - 1);
+}
+
+// Exclusive upper bound (us) of a bucket.
+inline uint64_t latencyBucketUpperBound(int index) {
+    if (index < kLatencySubBuckets) {
+        return static_cast<uint64_t>(index) + 1;
+    }
+    const int octave = index / kLatencySubBuckets + kLatencySubBucketBits - 1;
+    const int mantissa = index % kLatencySubBuckets;
+    return static_cast<uint64_t>(kLatencySubBuckets + mantissa + 1) << (octave - kLatencySubBucketBits);
+}
+
+// Upper bound (us) of the bucket holding quantile `q` of `counts`.
+inline uint64_t latencyQuantile(const uint64_t (&counts)[kLatencyBuckets], double q) {
+    uint64_t total = 0;
+    for (uint64_t n : counts) {
+        total += n;
+    }
+    if (total == 0) {
+        return 0;
+    }
+    const uint64_t rank = std::max<uint64_t>(1, static_cast<uint64_t>(std::ceil(q * static_cast<double>(total))));
+    uint64_t seen = 0;
+    for (int i = 0; i < kLatencyBuckets; ++i) {
+        seen += counts[i];
+        if (seen >= rank) {
+            return latencyBucketUpperBound(i);
+        }
+    }
+    return latencyBucketUpperBound(kLatencyBuckets - 1);
+}
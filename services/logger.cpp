@@ -0,0 +1,337 @@
+#include "logger.h"
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+std::atomic<int> g_log_level{static_cast<int>(LogLevel::Info)};
+
+namespace {
+
+// Per-thread ring size (a power of two). At one flush per kFlushInterval this
+// absorbs ~12k lines per second per thread before anything is dropped.
+constexpr std::size_t kRingSlots = 256;
+constexpr auto kFlushInterval = std::chrono::milliseconds(20);
+
+struct Record {
+    int64_t micros; // system clock
+    uint32_t thread;
+    uint16_t len;
+    uint8_t level;
+    char text[LogLine::kCapacity];
+};
+
+// Single producer (the owning thread), single consumer (the writer).
+struct Ring {
+    Record slots[kRingSlots];
+    std::atomic<uint64_t> head{0};
+    std::atomic<uint64_t> tail{0};
+    std::atomic<bool> retired{false};
+};
+
+std::vector<Ring*> g_rings;
+std::mutex g_rings_mutex;
+
+std::atomic<bool> g_logger_running{false};
+std::atomic<unsigned long long> g_dropped{0};
+std::atomic<uint32_t> g_next_thread{0};
+std::thread g_writer;
+std::mutex g_writer_mutex;
+std::condition_variable g_writer_cv;
+bool g_writer_stop = false;
+FILE* g_log_file = nullptr;
+
+// Marks the ring retired when its thread exits; the writer frees it once
+// drained.
+struct RingOwner {
+    Ring* ring = nullptr;
+    uint32_t thread = g_next_thread.fetch_add(1, std::memory_order_relaxed);
+
+    ~RingOwner() {
+        if (ring) {
+            ring->retired.store(true, std::memory_order_release);
+        }
+    }
+};
+
+thread_local RingOwner t_owner;
+
+Ring& localRing() {
+    if (!t_owner.ring) {
+        t_owner.ring = new Ring();
+        std::lock_guard<std::mutex> lock(g_rings_mutex);
+        g_rings.push_back(t_owner.ring);
+    }
+    return *t_owner.ring;
+}
+
+int64_t nowMicros() {
+    const auto now = std::chrono::system_clock::now().time_since_epoch();
+    return std::chrono::duration_cast<std::chrono::microseconds>(now).count();
+}
+
+const char* levelName(int level) {
+    switch (static_cast<LogLevel>(level)) {
+    case LogLevel::Debug: return "DEBUG";
+    case LogLevel::Info: return "INFO";
+    case LogLevel::Warn: return "WARN";
+    case LogLevel::Error: return "ERROR";
+    }
+    return "INFO";
+}
+
+// "YYYY-MM-DDTHH:MM:SS.uuuuuuZ" without gmtime (not thread-safe, and spelled
+// differently on MinGW).
+void appendTimestamp(std::string& out, int64_t micros) {
+    int64_t secs = micros / 1000000;
+    int64_t frac = micros % 1000000;
+    if (frac < 0) {
+        frac += 1000000;
+        --secs;
+    }
+    int64_t days = secs / 86400;
+    int64_t rem = secs % 86400;
+    if (rem < 0) {
+        rem += 86400;
+        --days;
+    }
+
+    // Civil date from days since 1970-01-01 (H. Hinnant's algorithm).
+    days += 719468;
+    const int64_t era = (days >= 0 ? days : days - 146096) / 146097;
+    const int64_t doe = days - era * 146097;
+    const int64_t yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+    const int64_t doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+    const int64_t mp = (5 * doy + 2) / 153;
+    const int64_t day = doy - (153 * mp + 2) / 5 + 1;
+    const int64_t month = mp < 10 ? mp + 3 : mp - 9;
+    const int64_t year = yoe + era * 400 + (month <= 2 ? 1 : 0);
+
+    char buf[64];
+    std::snprintf(buf, sizeof(buf), "%04lld-%02lld-%02lldT%02lld:%02lld:%02lld.%06lldZ",
+                  static_cast<long long>(year), static_cast<long long>(month), static_cast<long long>(day),
+                  static_cast<long long>(rem / 3600), static_cast<long long>(rem / 60 % 60),
+                  static_cast<long long>(rem % 60), static_cast<long long>(frac));
+    out += buf;
+}
+
+void appendLine(std::string& out, const Record& record) {
+    appendTimestamp(out, record.micros);
+    out += ' ';
+    out += levelName(record.level);
+    out += " tid=";
+    out += std::to_string(record.thread);
+    out += ' ';
+    out.append(record.text, record.len);
+    out += '\n';
+}
+
+void writeOut(const std::string& text) {
+    FILE* file = g_log_file ? g_log_file : stderr;
+    std::fwrite(text.data(), 1, text.size(), file);
+    std::fflush(file);
+}
+
+void drainRings() {
+    std::vector<Record> batch;
+    {
+        std::lock_guard<std::mutex> lock(g_rings_mutex);
+        for (auto it = g_rings.begin(); it != g_rings.end();) {
+            Ring* ring = *it;
+            const bool retired = ring->retired.load(std::memory_order_acquire);
+            const uint64_t tail = ring->tail.load(std::memory_order_relaxed);
+            const uint64_t head = ring->head.load(std::memory_order_acquire);
+            for (uint64_t i = tail; i < head; ++i) {
+                batch.push_back(ring->slots[i & (kRingSlots - 1)]);
+            }
+            ring->tail.store(head, std::memory_order_release);
+
+            if (retired) {
+                delete ring;
+                it = g_rings.erase(it);
+            } else {
+                ++it;
+            }
+        }
+    }
+    if (batch.empty()) {
+        return;
+    }
+
+    // Lines from different threads interleave in time order.
+    std::stable_sort(batch.begin(), batch.end(),
+                     [](const Record& a, const Record& b) { return a.micros < b.micros; });
+    std::string out;
+    out.reserve(batch.size() * 128);
+    for (const Record& record : batch) {
+        appendLine(out, record);
+    }
+    writeOut(out);
+}
+
+void writerLoop() {
+    std::unique_lock<std::mutex> lock(g_writer_mutex);
+    while (!g_writer_stop) {
+        g_writer_cv.wait_for(lock, kFlushInterval, [] { return g_writer_stop; });
+        lock.unlock();
+        drainRings();
+        lock.lock();
+    }
+}
+
+bool parseLevel(const char* text, LogLevel& level) {
+    if (!text) {
+        return false;
+    }
+    const std::string value(text);
+    if (value == "debug") level = LogLevel::Debug;
+    else if (value == "info") level = LogLevel::Info;
+    else if (value == "warn") level = LogLevel::Warn;
+    else if (value == "error") level = LogLevel::Error;
+    else return false;
+    return true;
+}
+
+} // namespace
+
+LogLine::LogLine(std::string_view msg) {
+    append("msg=");
+    appendQuoted(msg);
+}
+
+void LogLine::field(std::string_view key, std::string_view value) {
+    append(" ");
+    append(key);
+    append("=");
+    const bool plain = !value.empty() &&
+        value.find_first_of(" \"=\\\n\r\t") == std::string_view::npos;
+    if (plain) {
+        append(value);
+    } else {
+        appendQuoted(value);
+    }
+}
+
+void LogLine::field(std::string_view key, double value) {
+    char buf[32];
+    const int n = std::snprintf(buf, sizeof(buf), "%g", value);
+    field(key, std::string_view(buf, n > 0 ? static_cast<std::size_t>(n) : 0));
+}
+
+void LogLine::field(std::string_view key, long long value) {
+    char buf[24];
+    const int n = std::snprintf(buf, sizeof(buf), "%lld", value);
+    field(key, std::string_view(buf, n > 0 ? static_cast<std::size_t>(n) : 0));
+}
+
+void LogLine::field(std::string_view key, unsigned long long value) {
+    char buf[24];
+    const int n = std::snprintf(buf, sizeof(buf), "%llu", value);
+    field(key, std::string_view(buf, n > 0 ? static_cast<std::size_t>(n) : 0));
+}
+
+void LogLine::append(std::string_view text) {
+    const std::size_t n = std::min(text.size(), kCapacity - len_);
+    std::memcpy(buf_ + len_, text.data(), n);
+    len_ += n;
+}
+
+void LogLine::appendQuoted(std::string_view text) {
+    append("\"");
+    for (char c : text) {
+        switch (c) {
+        case '"': append("\\\""); break;
+        case '\\': append("\\\\"); break;
+        case '\n': append("\\n"); break;
+        case '\r': append("\\r"); break;
+        case '\t': append("\\t"); break;
+        default: append(std::string_view(&c, 1)); break;
+        }
+    }
+    append("\"");
+}
+
+void LogLine::commit(LogLevel level) {
+    if (!g_logger_running.load(std::memory_order_acquire)) {
+        Record record;
+        record.micros = nowMicros();
+        record.thread = t_owner.thread;
+        record.level = static_cast<uint8_t>(level);
+        record.len = static_cast<uint16_t>(len_);
+        std::memcpy(record.text, buf_, len_);
+        std::string out;
+        appendLine(out, record);
+        std::fwrite(out.data(), 1, out.size(), stderr);
+        return;
+    }
+
+    Ring& ring = localRing();
+    const uint64_t head = ring.head.load(std::memory_order_relaxed);
+    if (head - ring.tail.load(std::memory_order_acquire) >= kRingSlots) {
+        g_dropped.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    Record& record = ring.slots[head & (kRingSlots - 1)];
+    record.micros = nowMicros();
+    record.thread = t_owner.thread;
+    record.level = static_cast<uint8_t>(level);
+    record.len = static_cast<uint16_t>(len_);
+    std::memcpy(record.text, buf_, len_);
+    ring.head.store(head + 1, std::memory_order_release);
+}
+
+bool startLogger() {
+    LogLevel level;
+    if (parseLevel(std::getenv("LOG_LEVEL"), level)) {
+        setLogLevel(level);
+    }
+
+    const char* path = std::getenv("LOG_FILE");
+    if (path && *path) {
+        g_log_file = std::fopen(path, "a");
+        if (!g_log_file) {
+            LOG_ERROR("Failed to open log file", "path", path);
+            return false;
+        }
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(g_writer_mutex);
+        g_writer_stop = false;
+    }
+    g_logger_running.store(true, std::memory_order_release);
+    g_writer = std::thread(writerLoop);
+    return true;
+}
+
+void stopLogger() {
+    if (!g_logger_running.exchange(false, std::memory_order_acq_rel)) {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(g_writer_mutex);
+        g_writer_stop = true;
+    }
+    g_writer_cv.notify_all();
+    g_writer.join();
+    drainRings();
+
+    if (g_log_file) {
+        std::fclose(g_log_file);
+        g_log_file = nullptr;
+    }
+}
+
+void setLogLevel(LogLevel level) {
+    g_log_level.store(static_cast<int>(level), std::memory_order_relaxed);
+}
+
+unsigned long long loggerDropped() {
+    return g_dropped.load(std::memory_order_relaxed);
+}
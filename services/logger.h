@@ -0,0 +1,109 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <type_traits>
+
+enum class LogLevel { Debug, Info, Warn, Error };
+
+// Starts the background writer. Records are appended to LOG_FILE (stderr when
+// unset) in batches; LOG_LEVEL (debug|info|warn|error, default info) sets the
+// runtime threshold. Before this runs and after stopLogger(), records are
+// written synchronously to stderr.
+bool startLogger();
+
+// Flushes everything still buffered and stops the writer.
+void stopLogger();
+
+void setLogLevel(LogLevel level);
+
+// Records dropped because a thread's buffer was full (the writer fell behind).
+unsigned long long loggerDropped();
+
+// --------------------------------------------------
+// Structured logging:
+//   LOG_INFO("Slot blocked", "doctor_id", doctor_id, "date", date);
+// writes one line
+//   2026-01-05T09:30:00.123456Z INFO tid=3 msg="Slot blocked" doctor_id=7 date=2026-01-06
+// Formatting happens on the calling thread into a stack buffer and the line is
+// handed to a per-thread lock-free ring, so logging never takes a lock or
+// touches a stream. LOG_DEBUG is a single relaxed load when disabled at
+// runtime, and compiles away entirely with LOG_STRIP_DEBUG.
+// --------------------------------------------------
+
+#define LOG_AT(level, ...)                        \
+    do {                                          \
+        if (logLevelEnabled(level)) {             \
+            logEvent(level, __VA_ARGS__);         \
+        }                                         \
+    } while (0)
+
+#ifdef LOG_STRIP_DEBUG
+#define LOG_DEBUG(...) do {} while (0)
+#else
+#define LOG_DEBUG(...) LOG_AT(LogLevel::Debug, __VA_ARGS__)
+#endif
+#define LOG_INFO(...) LOG_AT(LogLevel::Info, __VA_ARGS__)
+#define LOG_WARN(...) LOG_AT(LogLevel::Warn, __VA_ARGS__)
+#define LOG_ERROR(...) LOG_AT(LogLevel::Error, __VA_ARGS__)
+
+extern std::atomic<int> g_log_level;
+
+inline bool logLevelEnabled(LogLevel level) {
+    return static_cast<int>(level) >= g_log_level.load(std::memory_order_relaxed);
+}
+
+// One formatted line (without timestamp / level, added by the writer).
+class LogLine {
+public:
+    // Longer lines are truncated.
+    static constexpr std::size_t kCapacity = 480;
+
+    explicit LogLine(std::string_view msg);
+
+    void field(std::string_view key, std::string_view value);
+    void field(std::string_view key, const std::string& value) { field(key, std::string_view(value)); }
+    void field(std::string_view key, const char* value) { field(key, std::string_view(value ? value : "")); }
+    void field(std::string_view key, bool value) { field(key, std::string_view(value ? "true" : "false")); }
+    void field(std::string_view key, double value);
+    void field(std::string_view key, long long value);
+    void field(std::string_view key, unsigned long long value);
+
+    template <typename T, typename = std::enable_if_t<std::is_integral_v<T>>>
+    void field(std::string_view key, T value) {
+        if constexpr (std::is_signed_v<T>) {
+            field(key, static_cast<long long>(value));
+        } else {
+            field(key, static_cast<unsigned long long>(value));
+        }
+    }
+    void field(std::string_view key, float value) { field(key, static_cast<double>(value)); }
+
+    void commit(LogLevel level);
+
+private:
+    void append(std::string_view text);
+    void appendQuoted(std::string_view text);
+
+    char buf_[kCapacity];
+    std::size_t len_ = 0;
+};
+
+inline void logFields(LogLine&) {}
+
+template <typename Value, typename... Rest>
+void logFields(LogLine& line, std::string_view key, const Value& value, const Rest&... rest) {
+    line.field(key, value);
+    logFields(line, rest...);
+}
+
+template <typename... Fields>
+void logEvent(LogLevel level, std::string_view msg, const Fields&... fields) {
+    static_assert(sizeof...(Fields) % 2 == 0, "log fields are key, value pairs");
+    LogLine line(msg);
+    logFields(line, fields...);
+    line.commit(level);
+}
@@ -0,0 +1,218 @@
+#include "metrics.h"
+#include "latency_histogram.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <sstream>
+#include <vector>
+
+namespace {
+
+// Exported cumulative boundaries: powers of two from 64 us to ~33 s.
+constexpr int kFirstExportedOctave = 6;
+constexpr int kLastExportedOctave = 25;
+
+constexpr int kStatusCodes[] = {200, 204, 304, 400, 401, 403, 404, 409, 429, 500, 503, 504};
+constexpr int kStatusSlots = sizeof(kStatusCodes) / sizeof(kStatusCodes[0]) + 1; // + "other"
+
+struct RouteShard {
+    std::atomic<uint64_t> latency[kLatencyBuckets];
+    std::atomic<uint64_t> status[kStatusSlots];
+    std::atomic<uint64_t> sum_us;
+};
+
+struct ThreadShard {
+    RouteShard routes[kMaxTrackedRoutes];
+};
+
+// Shards are never freed: a thread that exits keeps its counts.
+std::vector<ThreadShard*> g_shards;
+std::mutex g_shards_mutex;
+thread_local ThreadShard* t_shard = nullptr;
+
+struct Series {
+    std::string name;
+    std::string labels;
+    std::string help;
+    const char* type;
+    std::function<double()> sample;
+};
+
+std::vector<Series> g_series;
+std::mutex g_series_mutex;
+
+ThreadShard& localShard() {
+    if (!t_shard) {
+        t_shard = new ThreadShard();
+        std::lock_guard<std::mutex> lock(g_shards_mutex);
+        g_shards.push_back(t_shard);
+    }
+    return *t_shard;
+}
+
+int statusSlot(int status) {
+    for (int i = 0; i < kStatusSlots - 1; ++i) {
+        if (kStatusCodes[i] == status) {
+            return i;
+        }
+    }
+    return kStatusSlots - 1;
+}
+
+void bump(std::atomic<uint64_t>& counter, uint64_t by = 1) {
+    // Single writer per shard: load + store avoids a locked RMW instruction.
+    counter.store(counter.load(std::memory_order_relaxed) + by, std::memory_order_relaxed);
+}
+
+std::string escapeLabel(const std::string& value) {
+    std::string out;
+    out.reserve(value.size());
+    for (char c : value) {
+        if (c == '\\' || c == '"') {
+            out += '\\';
+            out += c;
+        } else if (c == '\n') {
+            out += "\\n";
+        } else {
+            out += c;
+        }
+    }
+    return out;
+}
+
+void registerSeries(const std::string& name, const std::string& labels, const std::string& help,
+                    const char* type, std::function<double()> sample) {
+    std::lock_guard<std::mutex> lock(g_series_mutex);
+    g_series.push_back({name, labels, help, type, std::move(sample)});
+}
+
+} // namespace
+
+void recordRequestMetrics(int route_id, int status, std::chrono::steady_clock::duration latency) {
+    if (route_id < 0 || route_id >= kMaxTrackedRoutes) {
+        return;
+    }
+    const auto us = std::chrono::duration_cast<std::chrono::microseconds>(latency).count();
+    const uint64_t value = us > 0 ? static_cast<uint64_t>(us) : 0;
+
+    RouteShard& shard = localShard().routes[route_id];
+    bump(shard.latency[latencyBucket(value)]);
+    bump(shard.status[statusSlot(status)]);
+    bump(shard.sum_us, value);
+}
+
+void endResponse(const RouteTag& tag, crow::response& res, std::chrono::steady_clock::time_point start) {
+    recordRequestMetrics(tag.id, res.code, std::chrono::steady_clock::now() - start);
+    res.end();
+}
+
+void endResponse(const RouteTag& tag, crow::response& res) {
+    recordRequestMetrics(tag.id, res.code, std::chrono::steady_clock::duration::zero());
+    res.end();
+}
+
+void registerMetricGauge(const std::string& name, const std::string& labels, const std::string& help,
+                         std::function<double()> sample) {
+    registerSeries(name, labels, help, "gauge", std::move(sample));
+}
+
+void registerMetricCounter(const std::string& name, const std::string& labels, const std::string& help,
+                           std::function<double()> sample) {
+    registerSeries(name, labels, help, "counter", std::move(sample));
+}
+
+void registerSessionMapGauge(const char* map, std::function<std::size_t()> size) {
+    registerMetricGauge("session_map_entries", std::string("map=\"") + map + "\"",
+                        "Entries held in an in-memory session or context map.",
+                        [size = std::move(size)] { return static_cast<double>(size()); });
+}
+
+std::string renderMetrics() {
+    const int routes = std::min<int>(kMaxTrackedRoutes, static_cast<int>(routeCount()));
+
+    std::vector<RouteShard> totals(routes);
+    {
+        std::lock_guard<std::mutex> lock(g_shards_mutex);
+        for (const ThreadShard* shard : g_shards) {
+            for (int r = 0; r < routes; ++r) {
+                const RouteShard& src = shard->routes[r];
+                RouteShard& dst = totals[r];
+                for (int b = 0; b < kLatencyBuckets; ++b) {
+                    bump(dst.latency[b], src.latency[b].load(std::memory_order_relaxed));
+                }
+                for (int s = 0; s < kStatusSlots; ++s) {
+                    bump(dst.status[s], src.status[s].load(std::memory_order_relaxed));
+                }
+                bump(dst.sum_us, src.sum_us.load(std::memory_order_relaxed));
+            }
+        }
+    }
+
+    std::ostringstream out;
+    out.precision(10);
+    out << "# HELP http_request_duration_seconds Request latency by route, from arrival to response.\n"
+        << "# TYPE http_request_duration_seconds histogram\n";
+    for (int r = 0; r < routes; ++r) {
+        const std::string route = escapeLabel(routeName(r));
+        const RouteShard& t = totals[r];
+        uint64_t cumulative = 0;
+        int bucket = 0;
+        for (int octave = kFirstExportedOctave; octave <= kLastExportedOctave; ++octave) {
+            const uint64_t le_us = 1ULL << octave;
+            while (bucket < kLatencyBuckets && latencyBucketUpperBound(bucket) <= le_us) {
+                cumulative += t.latency[bucket].load(std::memory_order_relaxed);
+                ++bucket;
+            }
+            out << "http_request_duration_seconds_bucket{route=\"" << route << "\",le=\""
+                << static_cast<double>(le_us) / 1e6 << "\"} " << cumulative << "\n";
+        }
+        uint64_t count = cumulative;
+        for (; bucket < kLatencyBuckets; ++bucket) {
+            count += t.latency[bucket].load(std::memory_order_relaxed);
+        }
+        out << "http_request_duration_seconds_bucket{route=\"" << route << "\",le=\"+Inf\"} " << count << "\n"
+            << "http_request_duration_seconds_sum{route=\"" << route << "\"} "
+            << static_cast<double>(t.sum_us.load(std::memory_order_relaxed)) / 1e6 << "\n"
+            << "http_request_duration_seconds_count{route=\"" << route << "\"} " << count << "\n";
+    }
+
+    out << "# HELP http_responses_total Responses by route and status code.\n"
+        << "# TYPE http_responses_total counter\n";
+    for (int r = 0; r < routes; ++r) {
+        const std::string route = escapeLabel(routeName(r));
+        for (int s = 0; s < kStatusSlots; ++s) {
+            const uint64_t n = totals[r].status[s].load(std::memory_order_relaxed);
+            if (n == 0) {
+                continue;
+            }
+            out << "http_responses_total{route=\"" << route << "\",code=\""
+                << (s < kStatusSlots - 1 ? std::to_string(kStatusCodes[s]) : std::string("other"))
+                << "\"} " << n << "\n";
+        }
+    }
+
+    std::lock_guard<std::mutex> lock(g_series_mutex);
+    std::vector<const Series*> ordered;
+    for (const Series& series : g_series) {
+        ordered.push_back(&series);
+    }
+    std::stable_sort(ordered.begin(), ordered.end(),
+                     [](const Series* a, const Series* b) { return a->name < b->name; });
+
+    const std::string* previous = nullptr;
+    for (const Series* series : ordered) {
+        if (!previous || *previous != series->name) {
+            out << "# HELP " << series->name << " " << series->help << "\n"
+                << "# TYPE " << series->name << " " << series->type << "\n";
+            previous = &series->name;
+        }
+        out << series->name;
+        if (!series->labels.empty()) {
+            out << "{" << series->labels << "}";
+        }
+        out << " " << series->sample() << "\n";
+    }
+    return out.str();
+}
@@ -0,0 +1,59 @@
+#pragma once
+
+#include <crow.h>
+
+#include "admission.h"
+#include "stage_timing.h"
+#include "traffic_capture.h"
+
+#include <chrono>
+#include <cstddef>
+#include <functional>
+#include <string>
+#include <utility>
+
+// Records one finished request for a registered route. Each thread writes
+// its own shard with plain relaxed stores, so this costs a few nanoseconds
+// and never contends; shards are summed when /metrics is scraped.
+void recordRequestMetrics(int route_id, int status, std::chrono::steady_clock::duration latency);
+
+// Records `res` against `tag` (latency measured from `start`) and ends it.
+void endResponse(const RouteTag& tag, crow::response& res, std::chrono::steady_clock::time_point start);
+
+// Same, for answers produced before any real work (rate limit, auth).
+void endResponse(const RouteTag& tag, crow::response& res);
+
+// Values sampled at scrape time. `labels` is either empty or a Prometheus
+// label set without braces, e.g. map="booking_contexts". Series sharing a
+// name must share help text and type.
+void registerMetricGauge(const std::string& name, const std::string& labels, const std::string& help,
+                         std::function<double()> sample);
+void registerMetricCounter(const std::string& name, const std::string& labels, const std::string& help,
+                           std::function<double()> sample);
+
+// Gauge for one of the in-memory session / context maps.
+void registerSessionMapGauge(const char* map, std::function<std::size_t()> size);
+
+// All route histograms, status counts and registered series in the
+// Prometheus text exposition format (version 0.0.4).
+std::string renderMetrics();
+
+// Runs a handler that never touches the DB, with an in-flight ticket, and
+// records its status, latency and stage timings.
+template <typename Handler>
+crow::response respondInline(const RouteTag& tag, Handler&& handler) {
+    const auto start = std::chrono::steady_clock::now();
+    AdmissionTicket ticket(tag);
+    RequestTiming timing(Stage::Handler);
+    crow::response res = handler();
+    timing.finish(tag, res);
+    recordRequestMetrics(tag.id, res.code, std::chrono::steady_clock::now() - start);
+    return res;
+}
+
+// Same, for API handlers whose requests should show up in a traffic capture.
+template <typename Handler>
+crow::response respondInline(const crow::request& req, const RouteTag& tag, Handler&& handler) {
+    captureRequest(req);
+    return respondInline(tag, std::forward<Handler>(handler));
+}
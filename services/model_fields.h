@@ -0,0 +1,169 @@
+#pragma once
+
+#include <crow.h>
+#include <sqlite3.h>
+
+#include "json_writer.h"
+#include "sql_statements.h"
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+// Field descriptors: a model lists its fields once, as (JSON name, member)
+// pairs in SELECT column order, and the serializers and row mappers below are
+// instantiated from that list at compile time.
+//
+//   class Category {
+//   public:
+//       int category_id;
+//       string category_name;
+//       static constexpr auto fields() {
+//           return std::make_tuple(field("category_id", &Category::category_id),
+//                                  field("category_name", &Category::category_name));
+//       }
+//   };
+//
+//   Category c;
+//   readRow(stmt, c);      // column 0 -> category_id, column 1 -> category_name
+//   writeObject(out, c);   // {"category_id":1,"category_name":"..."}
+//
+// Supported member types: int, int64_t, double and std::string. Reading from
+// a registry Query (sql_statements.h) also checks, at compile time, that each
+// member has the type its statement declares for that column.
+
+template <class Model, class Member>
+struct FieldDescriptor {
+    std::string_view name;
+    Member Model::*member;
+};
+
+template <class Model, class Member>
+constexpr FieldDescriptor<Model, Member> field(std::string_view name, Member Model::*member) {
+    return {name, member};
+}
+
+// The descriptor tuple, evaluated once at compile time.
+template <class Model>
+inline constexpr auto kModelFields = Model::fields();
+
+template <class Model>
+inline constexpr std::size_t kFieldCount = std::tuple_size_v<std::decay_t<decltype(kModelFields<Model>)>>;
+
+namespace model_fields_detail {
+
+template <class Model, class Fn, std::size_t... I>
+constexpr void forEachField(Fn&& fn, std::index_sequence<I...>) {
+    (fn(std::get<I>(kModelFields<Model>), std::integral_constant<int, static_cast<int>(I)>()), ...);
+}
+
+inline void readColumn(sqlite3_stmt* stmt, int column, int& out) { out = sqlite3_column_int(stmt, column); }
+inline void readColumn(sqlite3_stmt* stmt, int column, int64_t& out) { out = sqlite3_column_int64(stmt, column); }
+inline void readColumn(sqlite3_stmt* stmt, int column, double& out) { out = sqlite3_column_double(stmt, column); }
+inline void readColumn(sqlite3_stmt* stmt, int column, std::string& out) {
+    const unsigned char* text = sqlite3_column_text(stmt, column);
+    if (text) {
+        out.assign(reinterpret_cast<const char*>(text), static_cast<std::size_t>(sqlite3_column_bytes(stmt, column)));
+    } else {
+        out.clear(); // NULL reads as "", as the hand-written mappers did
+    }
+}
+
+inline void writeColumn(JsonWriter& out, sqlite3_stmt* stmt, int column, const int*) {
+    out.value(sqlite3_column_int(stmt, column));
+}
+inline void writeColumn(JsonWriter& out, sqlite3_stmt* stmt, int column, const int64_t*) {
+    out.value(static_cast<int64_t>(sqlite3_column_int64(stmt, column)));
+}
+inline void writeColumn(JsonWriter& out, sqlite3_stmt* stmt, int column, const double*) {
+    out.value(sqlite3_column_double(stmt, column));
+}
+inline void writeColumn(JsonWriter& out, sqlite3_stmt* stmt, int column, const std::string*) {
+    out.textColumn(stmt, column);
+}
+
+template <class Model, std::size_t I>
+using MemberType = std::decay_t<decltype(std::declval<const Model&>().*(std::get<I>(kModelFields<Model>).member))>;
+
+template <class Model, std::size_t First, class ColumnTuple, std::size_t... I>
+constexpr bool fieldsMatchColumns(std::index_sequence<I...>) {
+    return (std::is_same_v<MemberType<Model, I>, std::tuple_element_t<First + I, ColumnTuple>> && ...);
+}
+
+// True when columns First.. of the statement have the model's member types.
+template <class Model, std::size_t First, class... C>
+constexpr bool fieldsMatchColumns() {
+    if constexpr (First + kFieldCount<Model> > sizeof...(C)) {
+        return false;
+    } else {
+        return fieldsMatchColumns<Model, First, std::tuple<C...>>(std::make_index_sequence<kFieldCount<Model>>());
+    }
+}
+
+} // namespace model_fields_detail
+
+// Calls fn(descriptor, std::integral_constant<int, index>) for each field.
+template <class Model, class Fn>
+constexpr void forEachField(Fn&& fn) {
+    model_fields_detail::forEachField<Model>(std::forward<Fn>(fn), std::make_index_sequence<kFieldCount<Model>>());
+}
+
+// Fills every field of `model` from the current row, field i from column
+// `first_column + i`.
+template <class Model>
+void readRow(sqlite3_stmt* stmt, Model& model, int first_column = 0) {
+    forEachField<Model>([&](const auto& f, auto index) {
+        model_fields_detail::readColumn(stmt, first_column + index, model.*(f.member));
+    });
+}
+
+// Same, from a registry query: field i from column `FirstColumn + i`.
+template <std::size_t FirstColumn = 0, class Model, class... C>
+void readRow(const Query<C...>& query, Model& model) {
+    static_assert(model_fields_detail::fieldsMatchColumns<Model, FirstColumn, C...>(),
+                  "the model's fields do not match the statement's columns");
+    readRow(query.handle(), model, static_cast<int>(FirstColumn));
+}
+
+// Writes the fields as members of the object the caller has open, so extra
+// members can follow.
+template <class Model>
+void writeFields(JsonWriter& out, const Model& model) {
+    forEachField<Model>([&](const auto& f, auto) { out.key(f.name).value(model.*(f.member)); });
+}
+
+template <class Model>
+void writeObject(JsonWriter& out, const Model& model) {
+    out.beginObject();
+    writeFields(out, model);
+    out.endObject();
+}
+
+// Writes the current row as a `Model` object straight from the column
+// buffers, without materializing a Model; columns laid out as for readRow.
+template <class Model>
+void writeRowObject(JsonWriter& out, sqlite3_stmt* stmt, int first_column = 0) {
+    out.beginObject();
+    forEachField<Model>([&](const auto& f, auto index) {
+        using Member = std::decay_t<decltype(std::declval<const Model&>().*(f.member))>;
+        out.key(f.name);
+        model_fields_detail::writeColumn(out, stmt, first_column + index, static_cast<const Member*>(nullptr));
+    });
+    out.endObject();
+}
+
+template <class Model, class... C>
+void writeRowObject(JsonWriter& out, const Query<C...>& query) {
+    static_assert(model_fields_detail::fieldsMatchColumns<Model, 0, C...>(),
+                  "the model's fields do not match the statement's columns");
+    writeRowObject<Model>(out, query.handle());
+}
+
+// Sets the fields on a wvalue object (for the webhook payloads).
+template <class Model>
+void assignFields(crow::json::wvalue& json, const Model& model) {
+    forEachField<Model>([&](const auto& f, auto) { json[std::string(f.name)] = model.*(f.member); });
+}
@@ -0,0 +1,25 @@
+#include "notifications.h"
+#include "../config/n8n_config.h"
+
+#include <atomic>
+#include <thread>
+
+namespace {
+
+std::atomic<long> g_running{0};
+std::atomic<unsigned long long> g_started{0};
+
+} // namespace
+
+void notifyN8NAsync(crow::json::wvalue payload) {
+    g_started.fetch_add(1, std::memory_order_relaxed);
+    g_running.fetch_add(1, std::memory_order_relaxed);
+    std::thread([payload = std::move(payload)]() {
+        sendToN8N(payload);
+        g_running.fetch_sub(1, std::memory_order_relaxed);
+    }).detach();
+}
+
+NotificationStats notificationStats() {
+    return {g_running.load(std::memory_order_relaxed), g_started.load(std::memory_order_relaxed)};
+}
@@ -0,0 +1,14 @@
+#pragma once
+
+#include <crow.h>
+
+// Sends `payload` to the N8N webhook on a detached thread, so a booking or
+// cancellation never waits on the workflow.
+void notifyN8NAsync(crow::json::wvalue payload);
+
+struct NotificationStats {
+    long running;                 // detached threads still talking to N8N
+    unsigned long long started;
+};
+
+NotificationStats notificationStats();
@@ -0,0 +1,115 @@
+#include "profiled_mutex.h"
+
+#include <algorithm>
+
+namespace {
+
+// Function-local so mutexes defined at namespace scope in other translation
+// units can register during static initialization.
+std::vector<ProfiledMutex*>& registry() {
+    static std::vector<ProfiledMutex*> mutexes;
+    return mutexes;
+}
+
+std::mutex& registryMutex() {
+    static std::mutex mutex;
+    return mutex;
+}
+
+// Single writer (the lock holder); readers only need an untorn value.
+inline void bump(std::atomic<uint64_t>& counter, uint64_t by) {
+    counter.store(counter.load(std::memory_order_relaxed) + by, std::memory_order_relaxed);
+}
+
+inline void raise(std::atomic<uint64_t>& counter, uint64_t value) {
+    if (value > counter.load(std::memory_order_relaxed)) {
+        counter.store(value, std::memory_order_relaxed);
+    }
+}
+
+uint64_t nanosBetween(std::chrono::steady_clock::time_point from, std::chrono::steady_clock::time_point to) {
+    const auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(to - from).count();
+    return ns > 0 ? static_cast<uint64_t>(ns) : 0;
+}
+
+// Bucket upper bound, capped at the largest value actually seen.
+unsigned long long quantile(const std::atomic<uint64_t> (&hist)[kLatencyBuckets], double q, uint64_t max) {
+    uint64_t counts[kLatencyBuckets];
+    for (int i = 0; i < kLatencyBuckets; ++i) {
+        counts[i] = hist[i].load(std::memory_order_relaxed);
+    }
+    return std::min(latencyQuantile(counts, q), max);
+}
+
+} // namespace
+
+ProfiledMutex::ProfiledMutex(const char* name) : name_(name) {
+    std::lock_guard<std::mutex> lock(registryMutex());
+    registry().push_back(this);
+}
+
+void ProfiledMutex::lock() {
+    if (mutex_.try_lock()) {
+        acquired(0, Clock::now());
+        return;
+    }
+    const auto start = Clock::now();
+    mutex_.lock();
+    const auto now = Clock::now();
+    bump(contended_, 1);
+    acquired(nanosBetween(start, now), now);
+}
+
+bool ProfiledMutex::try_lock() {
+    if (!mutex_.try_lock()) {
+        return false;
+    }
+    acquired(0, Clock::now());
+    return true;
+}
+
+void ProfiledMutex::unlock() {
+    const uint64_t held = nanosBetween(held_since_, Clock::now());
+    bump(hold_ns_, held);
+    bump(hold_hist_[latencyBucket(held)], 1);
+    raise(hold_max_ns_, held);
+    mutex_.unlock();
+}
+
+void ProfiledMutex::acquired(uint64_t wait_ns, Clock::time_point now) {
+    held_since_ = now;
+    bump(acquisitions_, 1);
+    bump(wait_ns_, wait_ns);
+    bump(wait_hist_[latencyBucket(wait_ns)], 1);
+    raise(wait_max_ns_, wait_ns);
+}
+
+std::vector<const ProfiledMutex*> profiledMutexes() {
+    std::lock_guard<std::mutex> lock(registryMutex());
+    return std::vector<const ProfiledMutex*>(registry().begin(), registry().end());
+}
+
+std::vector<LockStats> lockStats() {
+    std::vector<LockStats> result;
+    {
+        std::lock_guard<std::mutex> lock(registryMutex());
+        for (const ProfiledMutex* m : registry()) {
+            LockStats s;
+            s.name = m->name_;
+            s.acquisitions = m->acquisitions();
+            s.contended = m->contended();
+            s.wait_ns = m->waitNanos();
+            s.wait_max_ns = m->wait_max_ns_.load(std::memory_order_relaxed);
+            s.wait_p50_ns = quantile(m->wait_hist_, 0.50, s.wait_max_ns);
+            s.wait_p99_ns = quantile(m->wait_hist_, 0.99, s.wait_max_ns);
+            s.hold_ns = m->holdNanos();
+            s.hold_max_ns = m->hold_max_ns_.load(std::memory_order_relaxed);
+            s.hold_p50_ns = quantile(m->hold_hist_, 0.50, s.hold_max_ns);
+            s.hold_p99_ns = quantile(m->hold_hist_, 0.99, s.hold_max_ns);
+            result.push_back(std::move(s));
+        }
+    }
+    std::sort(result.begin(), result.end(),
+              [](const LockStats& a, const LockStats& b) { return a.wait_ns > b.wait_ns; });
+    return result;
+}
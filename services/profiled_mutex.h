@@ -0,0 +1,77 @@
+#pragma once
+
+#include "latency_histogram.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// One ProfiledMutex, as reported by lockStats().
+struct LockStats {
+    std::string name;
+    unsigned long long acquisitions;
+    unsigned long long contended; // had to block
+    unsigned long long wait_ns;   // total
+    unsigned long long wait_p50_ns;
+    unsigned long long wait_p99_ns;
+    unsigned long long wait_max_ns;
+    unsigned long long hold_ns;   // total
+    unsigned long long hold_p50_ns;
+    unsigned long long hold_p99_ns;
+    unsigned long long hold_max_ns;
+};
+
+// std::mutex that counts acquisitions and keeps wait-time and hold-time
+// histograms (the latency_histogram.h buckets, in nanoseconds). Drop-in for
+// std::lock_guard / std::unique_lock. Instances register themselves by name
+// and show up in /admin/locks and /metrics.
+//
+// Only the current holder writes the counters, so they need no atomics
+// beyond relaxed load+store (for concurrent readers). An uncontended lock
+// costs one try_lock and two clock reads; a contended one adds a third.
+class ProfiledMutex {
+public:
+    explicit ProfiledMutex(const char* name);
+
+    ProfiledMutex(const ProfiledMutex&) = delete;
+    ProfiledMutex& operator=(const ProfiledMutex&) = delete;
+
+    void lock();
+    bool try_lock();
+    void unlock();
+
+    const char* name() const { return name_; }
+    uint64_t acquisitions() const { return acquisitions_.load(std::memory_order_relaxed); }
+    uint64_t contended() const { return contended_.load(std::memory_order_relaxed); }
+    uint64_t waitNanos() const { return wait_ns_.load(std::memory_order_relaxed); }
+    uint64_t holdNanos() const { return hold_ns_.load(std::memory_order_relaxed); }
+
+private:
+    friend std::vector<LockStats> lockStats();
+
+    using Clock = std::chrono::steady_clock;
+
+    void acquired(uint64_t wait_ns, Clock::time_point now);
+
+    std::mutex mutex_;
+    const char* name_;
+    Clock::time_point held_since_;
+
+    std::atomic<uint64_t> acquisitions_{0};
+    std::atomic<uint64_t> contended_{0};
+    std::atomic<uint64_t> wait_ns_{0};
+    std::atomic<uint64_t> hold_ns_{0};
+    std::atomic<uint64_t> wait_max_ns_{0};
+    std::atomic<uint64_t> hold_max_ns_{0};
+    std::atomic<uint64_t> wait_hist_[kLatencyBuckets] = {};
+    std::atomic<uint64_t> hold_hist_[kLatencyBuckets] = {};
+};
+
+// Every ProfiledMutex constructed so far (they live for the whole process).
+std::vector<const ProfiledMutex*> profiledMutexes();
+
+// Snapshot of every ProfiledMutex, most total wait first.
+std::vector<LockStats> lockStats();
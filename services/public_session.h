@@ -2,8 +2,13 @@
 
 #include <crow.h>
 
+#include <cstddef>
+
 // Issues a short-lived public session cookie for browsing.
 void issuePublicSession(crow::response& res);
 
 // Validates public session from Authorization Bearer or Cookie.
 bool publicSessionValid(const crow::request& req);
+
+// Sessions currently held (including expired ones not yet pruned).
+std::size_t publicSessionCount();
@@ -0,0 +1,152 @@
+#include "rate_limiter.h"
+
+#include <atomic>
+#include <chrono>
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace {
+
+struct BucketConfig {
+    float burst;
+    float refill_per_second;
+};
+
+// Indexed by RateBucket.
+constexpr BucketConfig kBuckets[] = {
+    {20.0f, 0.2f},   // PublicSession: 20 at once, then one every 5 s
+    {5.0f, 0.1f},    // DashboardVerify: 5 attempts, then one every 10 s
+    {30.0f, 5.0f},   // SlotStatus
+    {120.0f, 30.0f}, // Api
+};
+static_assert(sizeof(kBuckets) / sizeof(kBuckets[0]) == static_cast<size_t>(RateBucket::Count),
+              "every RateBucket needs a config");
+
+// 64 shards x 512 slots x 16 bytes = 512 KiB, fixed. Clients are hashed to a
+// shard and linearly probed within a short window; when the window is full the
+// least recently seen entry is evicted. An idle client's bucket has refilled
+// by then anyway, so eviction just means it starts over with a full bucket.
+constexpr size_t kShards = 64;
+constexpr size_t kSlotsPerShard = 512;
+constexpr size_t kProbeWindow = 8;
+
+struct Slot {
+    uint64_t key;
+    float tokens;
+    uint32_t stamp_ms;
+};
+
+struct alignas(64) Shard {
+    std::mutex mutex;
+    Slot slots[kSlotsPerShard];
+};
+
+Shard g_shards[kShards];
+std::atomic<unsigned long long> g_rejected[static_cast<size_t>(RateBucket::Count)];
+
+uint32_t nowMillis() {
+    static const auto start = std::chrono::steady_clock::now();
+    const auto elapsed = std::chrono::steady_clock::now() - start;
+    return static_cast<uint32_t>(std::chrono::duration_cast<std::chrono::milliseconds>(elapsed).count());
+}
+
+uint64_t hashKey(RateBucket bucket, const std::string& client) {
+    uint64_t h = 1469598103934665603ULL; // FNV-1a
+    h = (h ^ static_cast<uint64_t>(bucket)) * 1099511628211ULL;
+    for (unsigned char c : client) {
+        h = (h ^ c) * 1099511628211ULL;
+    }
+    return h == 0 ? 1 : h;
+}
+
+std::string clientKey(const crow::request& req) {
+    if (!req.remote_ip_address.empty()) {
+        return req.remote_ip_address;
+    }
+    return req.get_header_value("Authorization");
+}
+
+float refilled(const Slot& slot, const BucketConfig& cfg, uint32_t now) {
+    const float elapsed = static_cast<float>(now - slot.stamp_ms) / 1000.0f;
+    return std::fmin(cfg.burst, slot.tokens + elapsed * cfg.refill_per_second);
+}
+
+// Returns 0 when a token was taken, otherwise seconds until the next token.
+float take(uint64_t key, const BucketConfig& cfg) {
+    Shard& shard = g_shards[key % kShards];
+    const size_t base = static_cast<size_t>(key / kShards) % kSlotsPerShard;
+    const uint32_t now = nowMillis();
+
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    Slot* victim = nullptr;
+    for (size_t i = 0; i < kProbeWindow; ++i) {
+        Slot& slot = shard.slots[(base + i) % kSlotsPerShard];
+        if (slot.key == key) {
+            slot.tokens = refilled(slot, cfg, now);
+            slot.stamp_ms = now;
+            if (slot.tokens >= 1.0f) {
+                slot.tokens -= 1.0f;
+                return 0.0f;
+            }
+            return (1.0f - slot.tokens) / cfg.refill_per_second;
+        }
+        if (slot.key == 0) {
+            if (!victim || victim->key != 0) {
+                victim = &slot;
+            }
+        } else if (!victim || (victim->key != 0 && now - slot.stamp_ms > now - victim->stamp_ms)) {
+            victim = &slot;
+        }
+    }
+
+    victim->key = key;
+    victim->tokens = cfg.burst - 1.0f;
+    victim->stamp_ms = now;
+    return 0.0f;
+}
+
+// RATE_LIMIT_EXEMPT_IPS: comma-separated client addresses that are never
+// limited, e.g. the host running tools/loadgen.
+bool exempt(const crow::request& req) {
+    static const std::vector<std::string> ips = [] {
+        std::vector<std::string> out;
+        const char* env = std::getenv("RATE_LIMIT_EXEMPT_IPS");
+        std::istringstream list(env ? env : "");
+        std::string ip;
+        while (std::getline(list, ip, ',')) {
+            if (!ip.empty()) {
+                out.push_back(ip);
+            }
+        }
+        return out;
+    }();
+    return !ips.empty() && std::find(ips.begin(), ips.end(), req.remote_ip_address) != ips.end();
+}
+
+} // namespace
+
+bool rateLimitAllow(const crow::request& req, RateBucket bucket, crow::response& res) {
+    if (exempt(req)) {
+        return true;
+    }
+    const BucketConfig& cfg = kBuckets[static_cast<size_t>(bucket)];
+    const float wait = take(hashKey(bucket, clientKey(req)), cfg);
+    if (wait <= 0.0f) {
+        return true;
+    }
+
+    g_rejected[static_cast<size_t>(bucket)].fetch_add(1, std::memory_order_relaxed);
+    res = crow::response(429, "Too many requests. Please slow down and try again shortly.");
+    res.set_header("Retry-After", std::to_string(static_cast<int>(std::ceil(wait))));
+    return false;
+}
+
+unsigned long long rateLimitRejected(RateBucket bucket) {
+    return g_rejected[static_cast<size_t>(bucket)].load(std::memory_order_relaxed);
+}
@@ -0,0 +1,20 @@
+#pragma once
+
+#include <crow.h>
+
+// Per-route token buckets. Each (bucket, client) pair gets its own bucket.
+enum class RateBucket {
+    PublicSession,   // /public_session mints a session per call
+    DashboardVerify, // doctor_name + phone guessing
+    SlotStatus,      // /get_slots_status polling
+    Api,             // every DB-backed API route
+    Count
+};
+
+// Takes one token for the calling client. When the bucket is empty, fills
+// `res` with 429 + Retry-After and returns false. Call before any session
+// or DB work.
+bool rateLimitAllow(const crow::request& req, RateBucket bucket, crow::response& res);
+
+// Requests rejected so far for `bucket`.
+unsigned long long rateLimitRejected(RateBucket bucket);
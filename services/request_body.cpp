@@ -0,0 +1,391 @@
+#include "request_body.h"
+
+#include <cerrno>
+#include <charconv>
+#include <climits>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+
+namespace request_body_detail {
+
+const char* const kMalformedBody = "Please send a valid JSON object.";
+
+namespace {
+
+// Containers inside skipped values may nest this deep.
+constexpr int kMaxSkipDepth = 64;
+
+int hexDigit(char c) {
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+}
+
+bool readHex4(const char* p, const char* end, unsigned& out) {
+    if (end - p < 4) {
+        return false;
+    }
+    out = 0;
+    for (int i = 0; i < 4; ++i) {
+        const int digit = hexDigit(p[i]);
+        if (digit < 0) {
+            return false;
+        }
+        out = out << 4 | static_cast<unsigned>(digit);
+    }
+    return true;
+}
+
+char* appendUtf8(char* out, unsigned code_point) {
+    if (code_point < 0x80) {
+        *out++ = static_cast<char>(code_point);
+    } else if (code_point < 0x800) {
+        *out++ = static_cast<char>(0xC0 | code_point >> 6);
+        *out++ = static_cast<char>(0x80 | (code_point & 0x3F));
+    } else if (code_point < 0x10000) {
+        *out++ = static_cast<char>(0xE0 | code_point >> 12);
+        *out++ = static_cast<char>(0x80 | (code_point >> 6 & 0x3F));
+        *out++ = static_cast<char>(0x80 | (code_point & 0x3F));
+    } else {
+        *out++ = static_cast<char>(0xF0 | code_point >> 18);
+        *out++ = static_cast<char>(0x80 | (code_point >> 12 & 0x3F));
+        *out++ = static_cast<char>(0x80 | (code_point >> 6 & 0x3F));
+        *out++ = static_cast<char>(0x80 | (code_point & 0x3F));
+    }
+    return out;
+}
+
+// The integer in `text`, which must be nothing else.
+Convert parseInteger(std::string_view text, int64_t& out) {
+    const char* first = text.data();
+    const char* last = text.data() + text.size();
+    const std::from_chars_result parsed = std::from_chars(first, last, out);
+    if (parsed.ec == std::errc::result_out_of_range) {
+        return Convert::OutOfRange;
+    }
+    return parsed.ec == std::errc() && parsed.ptr == last && first != last ? Convert::Ok : Convert::WrongType;
+}
+
+} // namespace
+
+ObjectReader::ObjectReader(std::string_view body, std::unique_ptr<char[]>& scratch)
+    : p_(body.data()), end_(body.data() + body.size()), scratch_(scratch), scratch_capacity_(body.size()) {
+    skipSpace();
+    if (p_ == end_ || *p_ != '{') {
+        fail();
+        return;
+    }
+    ++p_;
+}
+
+bool ObjectReader::next(std::string_view& key, JsonToken& value) {
+    if (done_) {
+        return false;
+    }
+    skipSpace();
+    if (p_ == end_) {
+        return fail();
+    }
+    if (*p_ == '}') {
+        ++p_;
+        skipSpace();
+        if (p_ != end_) {
+            return fail(); // trailing bytes after the object
+        }
+        done_ = true;
+        return false;
+    }
+    if (!first_) {
+        if (*p_ != ',') {
+            return fail();
+        }
+        ++p_;
+        skipSpace();
+    }
+    first_ = false;
+
+    if (p_ == end_ || *p_ != '"' || !readString(key)) {
+        return fail();
+    }
+    skipSpace();
+    if (p_ == end_ || *p_ != ':') {
+        return fail();
+    }
+    ++p_;
+    skipSpace();
+    if (p_ == end_) {
+        return fail();
+    }
+
+    const char* start = p_;
+    bool ok;
+    switch (*p_) {
+    case '"':
+        value.kind = JsonKind::String;
+        return readString(value.text) || fail();
+    case '{':
+    case '[':
+        value.kind = JsonKind::Composite;
+        ok = skipComposite();
+        break;
+    case 't':
+        value.kind = JsonKind::Literal;
+        ok = readLiteral("true");
+        break;
+    case 'f':
+        value.kind = JsonKind::Literal;
+        ok = readLiteral("false");
+        break;
+    case 'n':
+        value.kind = JsonKind::Null;
+        ok = readLiteral("null");
+        break;
+    default:
+        value.kind = JsonKind::Number;
+        ok = readNumber();
+    }
+    if (!ok) {
+        return fail();
+    }
+    value.text = std::string_view(start, static_cast<std::size_t>(p_ - start));
+    return true;
+}
+
+bool ObjectReader::fail() {
+    failed_ = true;
+    done_ = true;
+    return false;
+}
+
+void ObjectReader::skipSpace() {
+    while (p_ != end_ && (*p_ == ' ' || *p_ == '\t' || *p_ == '\n' || *p_ == '\r')) {
+        ++p_;
+    }
+}
+
+bool ObjectReader::readString(std::string_view& out) {
+    const char* start = ++p_; // past the opening quote
+    while (p_ != end_ && *p_ != '"' && *p_ != '\\') {
+        if (static_cast<unsigned char>(*p_) < 0x20) {
+            return false;
+        }
+        ++p_;
+    }
+    if (p_ == end_) {
+        return false;
+    }
+    if (*p_ == '"') {
+        out = std::string_view(start, static_cast<std::size_t>(p_ - start));
+        ++p_;
+        return true;
+    }
+
+    // Escapes: decode the whole string into the scratch buffer.
+    if (!scratch_) {
+        scratch_.reset(new char[scratch_capacity_]);
+    }
+    char* const begin = scratch_.get() + scratch_used_;
+    const std::size_t plain = static_cast<std::size_t>(p_ - start);
+    std::memcpy(begin, start, plain);
+    char* dest = begin + plain;
+    while (p_ != end_ && *p_ != '"') {
+        const char c = *p_++;
+        if (static_cast<unsigned char>(c) < 0x20) {
+            return false;
+        }
+        if (c != '\\') {
+            *dest++ = c;
+            continue;
+        }
+        if (p_ == end_) {
+            return false;
+        }
+        switch (*p_++) {
+        case '"': *dest++ = '"'; break;
+        case '\\': *dest++ = '\\'; break;
+        case '/': *dest++ = '/'; break;
+        case 'b': *dest++ = '\b'; break;
+        case 'f': *dest++ = '\f'; break;
+        case 'n': *dest++ = '\n'; break;
+        case 'r': *dest++ = '\r'; break;
+        case 't': *dest++ = '\t'; break;
+        case 'u': {
+            unsigned code_point;
+            if (!readHex4(p_, end_, code_point)) {
+                return false;
+            }
+            p_ += 4;
+            if (code_point >= 0xD800 && code_point <= 0xDBFF) {
+                unsigned low;
+                if (end_ - p_ < 2 || p_[0] != '\\' || p_[1] != 'u' || !readHex4(p_ + 2, end_, low) ||
+                    low < 0xDC00 || low > 0xDFFF) {
+                    return false;
+                }
+                p_ += 6;
+                code_point = 0x10000 + ((code_point - 0xD800) << 10) + (low - 0xDC00);
+            } else if (code_point >= 0xDC00 && code_point <= 0xDFFF) {
+                return false;
+            }
+            dest = appendUtf8(dest, code_point);
+            break;
+        }
+        default:
+            return false;
+        }
+    }
+    if (p_ == end_) {
+        return false;
+    }
+    ++p_;
+    out = std::string_view(begin, static_cast<std::size_t>(dest - begin));
+    scratch_used_ += out.size();
+    return true;
+}
+
+bool ObjectReader::skipString() {
+    ++p_;
+    while (p_ != end_ && *p_ != '"') {
+        if (*p_ == '\\' && ++p_ == end_) {
+            return false;
+        }
+        ++p_;
+    }
+    if (p_ == end_) {
+        return false;
+    }
+    ++p_;
+    return true;
+}
+
+// -?(0|[1-9][0-9]*)(\.[0-9]+)?([eE][+-]?[0-9]+)?
+bool ObjectReader::readNumber() {
+    auto digits = [this] {
+        const char* start = p_;
+        while (p_ != end_ && *p_ >= '0' && *p_ <= '9') {
+            ++p_;
+        }
+        return p_ != start;
+    };
+    if (p_ != end_ && *p_ == '-') {
+        ++p_;
+    }
+    if (p_ != end_ && *p_ == '0') {
+        ++p_;
+    } else if (!digits()) {
+        return false;
+    }
+    if (p_ != end_ && *p_ == '.') {
+        ++p_;
+        if (!digits()) {
+            return false;
+        }
+    }
+    if (p_ != end_ && (*p_ == 'e' || *p_ == 'E')) {
+        ++p_;
+        if (p_ != end_ && (*p_ == '+' || *p_ == '-')) {
+            ++p_;
+        }
+        if (!digits()) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool ObjectReader::readLiteral(std::string_view word) {
+    if (static_cast<std::size_t>(end_ - p_) < word.size() || std::string_view(p_, word.size()) != word) {
+        return false;
+    }
+    p_ += word.size();
+    return true;
+}
+
+// Skips a nested object or array without looking inside beyond what it
+// takes to find its end.
+bool ObjectReader::skipComposite() {
+    char closers[kMaxSkipDepth];
+    int depth = 0;
+    while (p_ != end_) {
+        switch (*p_) {
+        case '"':
+            if (!skipString()) {
+                return false;
+            }
+            continue;
+        case '{':
+        case '[':
+            if (depth == kMaxSkipDepth) {
+                return false;
+            }
+            closers[depth++] = *p_ == '{' ? '}' : ']';
+            break;
+        case '}':
+        case ']':
+            if (depth == 0 || closers[depth - 1] != *p_) {
+                return false;
+            }
+            if (--depth == 0) {
+                ++p_;
+                return true;
+            }
+            break;
+        }
+        ++p_;
+    }
+    return false;
+}
+
+Convert convert(const JsonToken& token, int64_t& out) {
+    if (token.kind != JsonKind::Number && token.kind != JsonKind::String) {
+        return Convert::WrongType;
+    }
+    return parseInteger(token.text, out);
+}
+
+Convert convert(const JsonToken& token, int& out) {
+    int64_t wide;
+    const Convert converted = convert(token, wide);
+    if (converted != Convert::Ok) {
+        return converted;
+    }
+    if (wide < INT_MIN || wide > INT_MAX) {
+        return Convert::OutOfRange;
+    }
+    out = static_cast<int>(wide);
+    return Convert::Ok;
+}
+
+Convert convert(const JsonToken& token, double& out) {
+    if ((token.kind != JsonKind::Number && token.kind != JsonKind::String) || token.text.empty()) {
+        return Convert::WrongType;
+    }
+    char digits[64];
+    if (token.text.size() >= sizeof(digits)) {
+        return Convert::WrongType;
+    }
+    std::memcpy(digits, token.text.data(), token.text.size());
+    digits[token.text.size()] = '\0';
+    char* end = nullptr;
+    errno = 0;
+    const double parsed = std::strtod(digits, &end);
+    if (end != digits + token.text.size()) {
+        return Convert::WrongType;
+    }
+    if (errno == ERANGE || !std::isfinite(parsed)) {
+        return Convert::OutOfRange;
+    }
+    out = parsed;
+    return Convert::Ok;
+}
+
+Convert convert(const JsonToken& token, std::string_view& out) {
+    if (token.kind != JsonKind::String) {
+        return Convert::WrongType;
+    }
+    out = token.text;
+    return Convert::Ok;
+}
+
+} // namespace request_body_detail
@@ -0,0 +1,207 @@
+#pragma once
+
+#include <crow.h>
+
+#include "stage_timing.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <utility>
+
+// Typed request bodies. A DTO lists its members once; parseBody() walks the
+// JSON object a single time, converting each member straight into the DTO,
+// and reports the first problem as a 400-ready message instead of throwing.
+// String members are string_views into the request body (or into the
+// RequestBody's own buffer when the JSON string had escapes), so they live
+// as long as both the request and the RequestBody.
+//
+//   struct CancelRequest {
+//       int appointment_id = 0;
+//       std::string_view email;
+//
+//       static constexpr auto fields() {
+//           return std::make_tuple(requiredField("appointment_id", &CancelRequest::appointment_id),
+//                                  requiredField("email", &CancelRequest::email));
+//       }
+//   };
+//
+//   const auto body = parseBody<CancelRequest>(req);
+//   if (!body) {
+//       return crow::response(400, body.error());
+//   }
+//   use(body->appointment_id);
+//
+// Member types: int, int64_t and double take a JSON number, or a string
+// holding one (crow's .i() and .d() accepted both); std::string_view takes a
+// JSON string. Unknown members are skipped and null counts as absent.
+
+template <class Dto, class Member>
+struct BodyField {
+    std::string_view name;
+    Member Dto::*member;
+    bool required;
+};
+
+template <class Dto, class Member>
+constexpr BodyField<Dto, Member> requiredField(std::string_view name, Member Dto::*member) {
+    return {name, member, true};
+}
+
+template <class Dto, class Member>
+constexpr BodyField<Dto, Member> optionalField(std::string_view name, Member Dto::*member) {
+    return {name, member, false};
+}
+
+namespace request_body_detail {
+
+enum class JsonKind { String, Number, Literal, Null, Composite };
+
+struct JsonToken {
+    JsonKind kind;
+    std::string_view text; // decoded contents for String, the raw token otherwise
+};
+
+// Cursor over the members of one JSON object. Escaped strings are decoded
+// into `scratch`, allocated on first use at the size of the body (decoding
+// never grows a string, so views into it stay put).
+class ObjectReader {
+public:
+    ObjectReader(std::string_view body, std::unique_ptr<char[]>& scratch);
+
+    // The next member; false at the end of the object or on malformed input.
+    bool next(std::string_view& key, JsonToken& value);
+    bool failed() const { return failed_; }
+
+private:
+    bool fail();
+    void skipSpace();
+    bool readString(std::string_view& out);
+    bool skipString();
+    bool readNumber();
+    bool readLiteral(std::string_view word);
+    bool skipComposite();
+
+    const char* p_;
+    const char* end_;
+    std::unique_ptr<char[]>& scratch_;
+    std::size_t scratch_capacity_;
+    std::size_t scratch_used_ = 0;
+    bool first_ = true;
+    bool done_ = false;
+    bool failed_ = false;
+};
+
+enum class Convert { Ok, WrongType, OutOfRange };
+
+Convert convert(const JsonToken& token, int& out);
+Convert convert(const JsonToken& token, int64_t& out);
+Convert convert(const JsonToken& token, double& out);
+Convert convert(const JsonToken& token, std::string_view& out);
+
+constexpr const char* wrongType(const int*) { return " must be a whole number."; }
+constexpr const char* wrongType(const int64_t*) { return " must be a whole number."; }
+constexpr const char* wrongType(const double*) { return " must be a number."; }
+constexpr const char* wrongType(const std::string_view*) { return " must be text."; }
+
+extern const char* const kMalformedBody;
+
+template <class Fields, class Fn, std::size_t... I>
+constexpr void forEachBodyField(const Fields& fields, Fn&& fn, std::index_sequence<I...>) {
+    (fn(std::get<I>(fields), uint64_t{1} << I), ...);
+}
+
+template <class Fields, class Fn>
+constexpr void forEachBodyField(const Fields& fields, Fn&& fn) {
+    forEachBodyField(fields, std::forward<Fn>(fn), std::make_index_sequence<std::tuple_size_v<Fields>>());
+}
+
+} // namespace request_body_detail
+
+template <class Dto>
+class RequestBody {
+public:
+    RequestBody(RequestBody&&) = default;
+    RequestBody& operator=(RequestBody&&) = default;
+
+    // False when the body was rejected; error() then says why.
+    explicit operator bool() const { return error_.empty(); }
+    const std::string& error() const { return error_; }
+
+    const Dto& operator*() const { return dto_; }
+    const Dto* operator->() const { return &dto_; }
+
+private:
+    RequestBody() = default;
+
+    template <class D>
+    friend RequestBody<D> parseBody(std::string_view body);
+
+    Dto dto_{};
+    std::string error_;
+    std::unique_ptr<char[]> scratch_; // heap, so moving keeps the views valid
+};
+
+// Parses `body`, a JSON object, into a Dto.
+template <class Dto>
+RequestBody<Dto> parseBody(std::string_view body) {
+    using namespace request_body_detail;
+    constexpr auto fields = Dto::fields();
+    constexpr std::size_t count = std::tuple_size_v<decltype(fields)>;
+    static_assert(count <= 64, "one bit per field");
+
+    RequestBody<Dto> result;
+    ObjectReader reader(body, result.scratch_);
+    uint64_t seen = 0;
+    std::string_view key;
+    JsonToken value;
+    while (result.error_.empty() && reader.next(key, value)) {
+        if (value.kind == JsonKind::Null) {
+            continue;
+        }
+        forEachBodyField(fields, [&](const auto& f, uint64_t bit) {
+            if (f.name != key) {
+                return;
+            }
+            seen |= bit;
+            auto& member = result.dto_.*(f.member);
+            switch (convert(value, member)) {
+            case Convert::Ok:
+                break;
+            case Convert::WrongType:
+                result.error_.assign(f.name).append(wrongType(&member));
+                break;
+            case Convert::OutOfRange:
+                result.error_.assign(f.name).append(" is out of range.");
+                break;
+            }
+        });
+    }
+    if (reader.failed()) {
+        result.error_ = kMalformedBody;
+    }
+    if (!result.error_.empty()) {
+        return result;
+    }
+
+    // Names every missing required field, in declaration order.
+    forEachBodyField(fields, [&](const auto& f, uint64_t bit) {
+        if (f.required && !(seen & bit)) {
+            result.error_.append(result.error_.empty() ? "Please provide " : ", ").append(f.name);
+        }
+    });
+    if (!result.error_.empty()) {
+        result.error_ += '.';
+    }
+    return result;
+}
+
+// The request body, with the time charged to Stage::Parse.
+template <class Dto>
+RequestBody<Dto> parseBody(const crow::request& req) {
+    StageTimer timer(Stage::Parse);
+    return parseBody<Dto>(std::string_view(req.body));
+}
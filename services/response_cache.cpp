@@ -0,0 +1,86 @@
+#include "response_cache.h"
+
+#include "metrics.h"
+#include "single_flight.h"
+#include "traffic_capture.h"
+
+#include <utility>
+
+ResponseCache::ResponseCache(const char* name, std::chrono::seconds ttl) : name_(name), ttl_(ttl) {}
+
+std::shared_ptr<const CachedBody> ResponseCache::get() const {
+    std::shared_ptr<const CachedBody> body;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (body_ && body_version_ == version_.load(std::memory_order_acquire) &&
+            std::chrono::steady_clock::now() - filled_ < ttl_) {
+            body = body_;
+        }
+    }
+    (body ? hits_ : misses_).fetch_add(1, std::memory_order_relaxed);
+    return body;
+}
+
+void ResponseCache::put(uint64_t version, std::string body) {
+    const std::string etag = bodyEtag(body);
+    auto shared = std::make_shared<const CachedBody>(CachedBody{std::move(body), etag});
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (version != version_.load(std::memory_order_acquire)) {
+        return;
+    }
+    body_ = std::move(shared);
+    body_version_ = version;
+    filled_ = std::chrono::steady_clock::now();
+}
+
+void ResponseCache::invalidate() {
+    version_.fetch_add(1, std::memory_order_acq_rel);
+}
+
+void registerResponseCacheMetrics(const ResponseCache& cache) {
+    const std::string label = std::string("cache=\"") + cache.name() + "\"";
+    registerMetricCounter("response_cache_hits_total", label, "Reads answered from a pre-serialized response.",
+                          [&cache] { return static_cast<double>(cache.hits()); });
+    registerMetricCounter("response_cache_misses_total", label, "Reads that had to query the database.",
+                          [&cache] { return static_cast<double>(cache.misses()); });
+}
+
+void respondWithCachedBody(const crow::request& req, crow::response& res, const RouteTag& tag,
+                           const std::string& body, const std::string& etag) {
+    if (etagMatches(req, etag)) {
+        respondNotModified(req, res, tag, etag);
+        return;
+    }
+    // Hits are captured like the DB path; the caller has already rate-limited.
+    captureRequest(req);
+    const auto start = std::chrono::steady_clock::now();
+    res.code = 200;
+    // crow::response owns its body as a std::string, so every hit copies the
+    // cached bytes; what a hit saves is the query and the serialization.
+    res.body = body;
+    res.set_header("Content-Type", "application/json");
+    res.set_header("ETag", etag);
+    endResponse(tag, res, start);
+}
+
+void respondFromCache(const crow::request& req, crow::response& res, const RouteTag& tag, ResponseCache& cache,
+                      DbWork work) {
+    if (std::shared_ptr<const CachedBody> body = cache.get()) {
+        respondWithCachedBody(req, res, tag, body->json, body->etag);
+        return;
+    }
+
+    // Read before the query runs: a write committed after this point bumps
+    // the version and the stale result is dropped by put().
+    const uint64_t version = cache.version();
+    respondFromDbCoalesced(req, res, tag, cache.name(),
+                           [&cache, version, work = std::move(work)](const crow::request& req, sqlite3* db) {
+        crow::response out = work(req, db);
+        if (out.code == 200 && !dbTaskTimedOut()) {
+            // No 304 here: coalesced waiters get a copy of this response.
+            out.set_header("ETag", bodyEtag(out.body));
+            cache.put(version, out.body);
+        }
+        return out;
+    });
+}
@@ -0,0 +1,68 @@
+#pragma once
+
+#include "db_executor.h"
+#include "etag.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+
+// One pre-serialized JSON response body that only changes when the rows
+// behind it do. Writers call invalidate() after committing; every fill is
+// stamped with the version it started from, so a read that raced a write
+// is never stored. Entries also expire after `ttl`, which bounds how long a
+// change made outside the server (e.g. the sqlite3 shell) goes unseen.
+class ResponseCache {
+public:
+    ResponseCache(const char* name, std::chrono::seconds ttl);
+
+    ResponseCache(const ResponseCache&) = delete;
+    ResponseCache& operator=(const ResponseCache&) = delete;
+
+    // The cached body, or null when empty, invalidated or expired.
+    std::shared_ptr<const CachedBody> get() const;
+
+    uint64_t version() const { return version_.load(std::memory_order_acquire); }
+
+    // Stores `body` unless the cache was invalidated since `version` was read.
+    void put(uint64_t version, std::string body);
+
+    void invalidate();
+
+    const char* name() const { return name_; }
+    unsigned long long hits() const { return hits_.load(std::memory_order_relaxed); }
+    unsigned long long misses() const { return misses_.load(std::memory_order_relaxed); }
+
+private:
+    const char* name_;
+    const std::chrono::steady_clock::duration ttl_;
+    std::atomic<uint64_t> version_{1};
+    mutable std::atomic<unsigned long long> hits_{0};
+    mutable std::atomic<unsigned long long> misses_{0};
+
+    mutable std::mutex mutex_;
+    std::shared_ptr<const CachedBody> body_;
+    uint64_t body_version_ = 0;
+    std::chrono::steady_clock::time_point filled_;
+};
+
+// Hit / miss counters for `cache` in /metrics.
+void registerResponseCacheMetrics(const ResponseCache& cache);
+
+// Completes `res` with a pre-serialized JSON body: 200 application/json
+// with its ETag, or 304 when the client already holds it. Captures the
+// request but leaves RateBucket::Api to the caller, like
+// respondFromDbCoalesced().
+void respondWithCachedBody(const crow::request& req, crow::response& res, const RouteTag& tag,
+                           const std::string& body, const std::string& etag);
+
+// Answers a read from `cache` when it holds a body: 200 application/json (or
+// 304 on a matching If-None-Match) with no DB work and no JSON building. Otherwise behaves like
+// respondFromDbCoalesced() and stores a 200 answer from `work` for the next
+// request. Per-client checks (the Api rate limit, then the session) belong
+// before this call.
+void respondFromCache(const crow::request& req, crow::response& res, const RouteTag& tag, ResponseCache& cache,
+                      DbWork work);
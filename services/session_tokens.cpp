@@ -0,0 +1,49 @@
+#include "session_tokens.h"
+
+#include <cstdio>
+#include <random>
+#include <string_view>
+
+std::string generateToken() {
+    // One generator per thread: tokens are minted on every DB worker.
+    thread_local std::mt19937_64 gen(std::random_device{}());
+    std::uniform_int_distribution<unsigned long long> dis;
+
+    char buf[33];
+    const int n = std::snprintf(buf, sizeof(buf), "%llx%llx", dis(gen), dis(gen));
+    return std::string(buf, n > 0 ? static_cast<std::size_t>(n) : 0);
+}
+
+std::string cookieValue(const std::string& cookie_header, const std::string& name) {
+    const std::string_view cookie(cookie_header);
+    std::size_t start = 0;
+    while (start < cookie.size()) {
+        std::size_t end = cookie.find(';', start);
+        if (end == std::string_view::npos) {
+            end = cookie.size();
+        }
+
+        const std::size_t eq = cookie.find('=', start);
+        if (eq != std::string_view::npos && eq < end) {
+            std::size_t key_start = start;
+            while (key_start < eq && cookie[key_start] == ' ') {
+                ++key_start;
+            }
+            if (cookie.substr(key_start, eq - key_start) == name) {
+                return std::string(cookie.substr(eq + 1, end - (eq + 1)));
+            }
+        }
+
+        start = end + 1;
+    }
+    return "";
+}
+
+std::string bearerOrCookieToken(const crow::request& req, const std::string& name) {
+    const std::string& auth = req.get_header_value("Authorization");
+    constexpr std::string_view prefix = "Bearer ";
+    if (std::string_view(auth).substr(0, prefix.size()) == prefix) {
+        return auth.substr(prefix.size());
+    }
+    return cookieValue(req.get_header_value("Cookie"), name);
+}
@@ -0,0 +1,14 @@
+#pragma once
+
+#include <crow.h>
+
+#include <string>
+
+// Random 128-bit token, hex encoded, for session and context cookies.
+std::string generateToken();
+
+// Value of cookie `name` in a Cookie header ("a=1; b=2"), or "" if absent.
+std::string cookieValue(const std::string& cookie_header, const std::string& name);
+
+// Token from "Authorization: Bearer <token>", otherwise from cookie `name`.
+std::string bearerOrCookieToken(const crow::request& req, const std::string& name);
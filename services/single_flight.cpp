@@ -0,0 +1,69 @@
+#include "single_flight.h"
+#include "metrics.h"
+#include "traffic_capture.h"
+
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+namespace {
+
+struct Waiter {
+    crow::response* res;
+    std::chrono::steady_clock::time_point arrived;
+};
+
+// Key -> requests waiting on the in-flight computation for that key.
+std::unordered_map<std::string, std::vector<Waiter>> g_flights;
+std::mutex g_flights_mutex;
+std::atomic<unsigned long long> g_coalesced{0};
+
+// Removes the flight so new requests start a fresh computation, and returns
+// everyone who joined it.
+std::vector<Waiter> land(const std::string& key) {
+    std::lock_guard<std::mutex> lock(g_flights_mutex);
+    auto it = g_flights.find(key);
+    if (it == g_flights.end()) {
+        return {};
+    }
+    std::vector<Waiter> waiters = std::move(it->second);
+    g_flights.erase(it);
+    return waiters;
+}
+
+} // namespace
+
+void respondFromDbCoalesced(const crow::request& req, crow::response& res, const RouteTag& tag,
+                            const std::string& key, DbWork work) {
+    captureRequest(req);
+
+    {
+        std::lock_guard<std::mutex> lock(g_flights_mutex);
+        auto it = g_flights.find(key);
+        if (it != g_flights.end()) {
+            it->second.push_back({&res, std::chrono::steady_clock::now()});
+            g_coalesced.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+        g_flights.emplace(key, std::vector<Waiter>());
+    }
+
+    // The leader's final response, whatever became of `work` (it may have
+    // expired in the queue and never run), is copied to everyone who joined.
+    // The body was built and serialized once; waiters get copies of it.
+    submitDbWork(req, res, tag, std::move(work), /*cancel_on_disconnect=*/false,
+                 [tag, key](const crow::response& leader) {
+        for (const Waiter& waiter : land(key)) {
+            waiter.res->code = leader.code;
+            waiter.res->body = leader.body;
+            waiter.res->headers = leader.headers;
+            endResponse(tag, *waiter.res, waiter.arrived);
+        }
+    });
+}
+
+unsigned long long coalescedRequests() {
+    return g_coalesced.load(std::memory_order_relaxed);
+}
@@ -0,0 +1,17 @@
+#pragma once
+
+#include "db_executor.h"
+
+#include <string>
+
+// Like respondFromDb(), but concurrent requests with the same `key` share one
+// execution: the first request queues `work`, later ones wait for it and are
+// answered with a copy of its status, headers and serialized body.
+// Only for idempotent reads whose result depends on nothing but `key`. Unlike
+// respondFromDb() this does not charge RateBucket::Api: the caller does that,
+// then its other per-client checks (session), before calling this.
+void respondFromDbCoalesced(const crow::request& req, crow::response& res, const RouteTag& tag,
+                            const std::string& key, DbWork work);
+
+// Requests answered from another request's in-flight computation.
+unsigned long long coalescedRequests();
@@ -0,0 +1,194 @@
+#include "slot_catalogue.h"
+
+#include "logger.h"
+#include "sql_statements.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <mutex>
+#include <utility>
+
+namespace {
+
+std::shared_ptr<const SlotCatalogue> g_catalogue; // std::atomic_load / atomic_store only
+std::mutex g_load_mutex;
+
+// Bumped by every invalidation; a load only publishes if it is unchanged.
+std::atomic<uint64_t> g_version{1};
+
+uint64_t seededHash(uint64_t seed, std::string_view key) {
+    uint64_t h = 1469598103934665603ULL ^ (seed * 0x9E3779B97F4A7C15ULL); // FNV-1a
+    for (unsigned char c : key) {
+        h ^= c;
+        h *= 1099511628211ULL;
+    }
+    return h ^ (h >> 29);
+}
+
+bool queryCatalogue(sqlite3* db, std::vector<CatalogueSlot>& slots) {
+    auto rows = query(db, sql::kSlotsAll);
+    while (rows.step()) {
+        CatalogueSlot& slot = slots.emplace_back();
+        readRow(rows, static_cast<DoctorSchedule&>(slot));
+        slot.minute_of_day = parseMinuteOfDay(slot.time_slot);
+    }
+    if (!rows.done()) {
+        LOG_ERROR("Loading slot catalogue failed", "error", sqlite3_errmsg(db));
+        return false;
+    }
+    return true;
+}
+
+} // namespace
+
+int parseMinuteOfDay(std::string_view time_slot) {
+    std::size_t i = 0;
+    auto number = [&](int max_digits) {
+        int value = -1;
+        for (int d = 0; d < max_digits && i < time_slot.size() && std::isdigit(static_cast<unsigned char>(time_slot[i]));
+             ++d, ++i) {
+            value = (value < 0 ? 0 : value * 10) + (time_slot[i] - '0');
+        }
+        return value;
+    };
+
+    while (i < time_slot.size() && time_slot[i] == ' ') {
+        ++i;
+    }
+    int hour = number(2);
+    if (hour < 0 || i >= time_slot.size() || time_slot[i] != ':') {
+        return -1;
+    }
+    ++i;
+    const std::size_t minute_start = i;
+    const int minute = number(2);
+    if (minute < 0 || i - minute_start != 2 || minute > 59) {
+        return -1;
+    }
+    while (i < time_slot.size() && time_slot[i] == ' ') {
+        ++i;
+    }
+
+    if (i < time_slot.size()) {
+        const std::string_view rest = time_slot.substr(i);
+        const bool am = rest == "AM" || rest == "am";
+        const bool pm = rest == "PM" || rest == "pm";
+        if ((!am && !pm) || hour < 1 || hour > 12) {
+            return -1;
+        }
+        hour = hour % 12 + (pm ? 12 : 0);
+    }
+    return hour < 24 ? hour * 60 + minute : -1;
+}
+
+SlotCatalogue::SlotCatalogue(std::vector<CatalogueSlot> slots) : slots_(std::move(slots)) {
+    std::stable_sort(slots_.begin(), slots_.end(), [](const CatalogueSlot& a, const CatalogueSlot& b) {
+        if ((a.minute_of_day < 0) != (b.minute_of_day < 0)) {
+            return b.minute_of_day < 0;
+        }
+        if (a.minute_of_day != b.minute_of_day) {
+            return a.minute_of_day < b.minute_of_day;
+        }
+        return a.schedule_id < b.schedule_id;
+    });
+    for (std::size_t i = 0; i < slots_.size(); ++i) {
+        positions_.emplace(slots_[i].schedule_id, static_cast<int>(i));
+    }
+
+    // Labels are UNIQUE in the table, so some seed separates them; at load
+    // factor <= 1/4 one is usually found within a few tries. (A repeated
+    // label keeps its first slot, like the old LIMIT 1 query.)
+    std::size_t size = 4;
+    while (size < slots_.size() * 4) {
+        size <<= 1;
+    }
+    for (uint64_t seed = 1;; ++seed) {
+        std::vector<int> table(size, -1);
+        bool collision = false;
+        for (std::size_t i = 0; i < slots_.size() && !collision; ++i) {
+            int& cell = table[seededHash(seed, slots_[i].time_slot) & (size - 1)];
+            if (cell >= 0 && slots_[cell].time_slot != slots_[i].time_slot) {
+                collision = true;
+            } else if (cell < 0) {
+                cell = static_cast<int>(i);
+            }
+        }
+        if (!collision) {
+            seed_ = seed;
+            table_ = std::move(table);
+            break;
+        }
+        if (seed % 16 == 0) {
+            size <<= 1;
+        }
+    }
+}
+
+int SlotCatalogue::idFor(std::string_view time_slot) const {
+    const int position = table_[seededHash(seed_, time_slot) & (table_.size() - 1)];
+    if (position < 0 || slots_[position].time_slot != time_slot) {
+        return -1;
+    }
+    return slots_[position].schedule_id;
+}
+
+int SlotCatalogue::positionOf(int schedule_id) const {
+    auto it = positions_.find(schedule_id);
+    return it == positions_.end() ? -1 : it->second;
+}
+
+std::shared_ptr<const SlotCatalogue> currentSlotCatalogue() {
+    return std::atomic_load(&g_catalogue);
+}
+
+std::shared_ptr<const SlotCatalogue> slotCatalogue(sqlite3* db) {
+    if (auto catalogue = currentSlotCatalogue()) {
+        return catalogue;
+    }
+    std::lock_guard<std::mutex> lock(g_load_mutex);
+    if (auto catalogue = currentSlotCatalogue()) {
+        return catalogue;
+    }
+    const uint64_t version = g_version.load(std::memory_order_acquire);
+    std::vector<CatalogueSlot> slots;
+    if (!queryCatalogue(db, slots)) {
+        return nullptr;
+    }
+    auto catalogue = std::make_shared<const SlotCatalogue>(std::move(slots));
+    if (version == g_version.load(std::memory_order_acquire)) {
+        std::atomic_store(&g_catalogue, catalogue);
+        LOG_INFO("Slot catalogue loaded", "slots", catalogue->slots().size());
+    }
+    return catalogue;
+}
+
+void invalidateSlotCatalogue() {
+    g_version.fetch_add(1, std::memory_order_acq_rel);
+    std::atomic_store(&g_catalogue, std::shared_ptr<const SlotCatalogue>());
+}
+
+const char* slotStatusName(SlotStatus status) {
+    switch (status) {
+    case SlotStatus::Booked:
+        return "BOOKED";
+    case SlotStatus::Blocked:
+        return "BLOCKED";
+    default:
+        return "AVAILABLE";
+    }
+}
+
+bool querySlotStatuses(sqlite3* db, const SlotCatalogue& catalogue, int doctor_id, const std::string& date,
+                       std::vector<SlotStatus>& statuses) {
+    auto rows = query(db, sql::kSlotsTaken, doctor_id, date, doctor_id, date);
+    statuses.assign(catalogue.slots().size(), SlotStatus::Available);
+    while (rows.step()) {
+        const int position = catalogue.positionOf(rows.get<0>());
+        if (position >= 0) {
+            const SlotStatus status = rows.get<1>() ? SlotStatus::Booked : SlotStatus::Blocked;
+            statuses[position] = std::max(statuses[position], status);
+        }
+    }
+    return rows.done();
+}
@@ -0,0 +1,71 @@
+#pragma once
+
+#include <sqlite3.h>
+
+#include "../models/schedule.h"
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+struct CatalogueSlot : DoctorSchedule {
+    int minute_of_day; // -1 when time_slot is not a recognizable time
+};
+
+// Immutable copy of Doctor_Schedule, sorted by real time of day ("9:30 AM"
+// before "10:00", unparseable labels last, ties in schedule_id order), with
+// a collision-free hash from time_slot to schedule_id built for exactly this
+// set of labels.
+class SlotCatalogue {
+public:
+    explicit SlotCatalogue(std::vector<CatalogueSlot> slots);
+
+    const std::vector<CatalogueSlot>& slots() const { return slots_; }
+
+    // schedule_id for an exact time_slot label, or -1.
+    int idFor(std::string_view time_slot) const;
+
+    // Index into slots() for a schedule_id, or -1.
+    int positionOf(int schedule_id) const;
+
+    const CatalogueSlot* byId(int schedule_id) const {
+        const int position = positionOf(schedule_id);
+        return position < 0 ? nullptr : &slots_[position];
+    }
+
+private:
+    std::vector<CatalogueSlot> slots_;
+    std::unordered_map<int, int> positions_;
+
+    // Power-of-two table; each label's seeded hash lands in its own cell.
+    uint64_t seed_ = 0;
+    std::vector<int> table_; // position in slots_, -1 for empty cells
+};
+
+enum class SlotStatus : char { Available, Blocked, Booked };
+
+// "AVAILABLE", "BLOCKED" or "BOOKED".
+const char* slotStatusName(SlotStatus status);
+
+// Status of every slot of `catalogue` for a doctor on a date, in catalogue
+// order. A slot both booked and blocked is BOOKED.
+bool querySlotStatuses(sqlite3* db, const SlotCatalogue& catalogue, int doctor_id, const std::string& date,
+                       std::vector<SlotStatus>& statuses);
+
+// Minutes since midnight for "HH:MM" (24 h) or "H:MM AM/PM", or -1.
+int parseMinuteOfDay(std::string_view time_slot);
+
+// The loaded catalogue, or null before the first load; never touches the
+// database.
+std::shared_ptr<const SlotCatalogue> currentSlotCatalogue();
+
+// The catalogue, loading it through `db` on first use (DB executor threads
+// only). Null if the load failed.
+std::shared_ptr<const SlotCatalogue> slotCatalogue(sqlite3* db);
+
+// Drops the catalogue after a committed change to Doctor_Schedule; the next
+// slotCatalogue() call reloads it. Never touches the database.
+void invalidateSlotCatalogue();
@@ -0,0 +1,242 @@
+#include "slot_push.h"
+
+#include "db_executor.h"
+#include "json_writer.h"
+#include "logger.h"
+#include "slot_catalogue.h"
+#include "slot_versions.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <map>
+#include <mutex>
+#include <set>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+
+namespace {
+
+using SlotSetKey = std::pair<int, std::string>; // (doctor_id, date)
+
+struct WatchedSet {
+    std::vector<crow::websocket::connection*> sockets;
+    std::vector<crow::websocket::connection*> awaiting_snapshot;
+    // What the sockets were last told; deltas are taken against it.
+    std::shared_ptr<const SlotCatalogue> catalogue;
+    std::vector<SlotStatus> statuses;
+};
+
+// Guards everything below. Sends only queue the frame on the socket's IO
+// thread, so they happen under the lock; that also keeps a socket from being
+// freed (close handler -> slotPushDisconnect) while a frame is handed to it.
+std::mutex g_push_mutex;
+std::condition_variable g_push_cv;
+std::map<SlotSetKey, WatchedSet> g_sets;
+std::unordered_map<crow::websocket::connection*, SlotSetKey> g_socket_keys;
+std::set<SlotSetKey> g_dirty;
+bool g_all_dirty = false;
+bool g_push_stop = false;
+
+std::thread g_push_thread;
+sqlite3* g_push_db = nullptr;
+
+std::atomic<unsigned long long> g_messages{0};
+
+void removeSocket(std::vector<crow::websocket::connection*>& sockets, crow::websocket::connection* conn) {
+    for (auto it = sockets.begin(); it != sockets.end(); ++it) {
+        if (*it == conn) {
+            *it = sockets.back();
+            sockets.pop_back();
+            return;
+        }
+    }
+}
+
+std::string renderMessage(const SlotSetKey& key, const char* type, const SlotCatalogue& catalogue,
+                          const std::vector<SlotStatus>& statuses, const std::vector<std::size_t>& positions) {
+    JsonWriter out(64 * positions.size() + 64);
+    out.beginObject().key("type").value(type).key("doctor_id").value(key.first).key("date").value(key.second);
+    out.key("slots").beginArray();
+    for (std::size_t position : positions) {
+        out.beginObject();
+        writeFields<DoctorSchedule>(out, catalogue.slots()[position]);
+        out.key("status").value(slotStatusName(statuses[position])).endObject();
+    }
+    out.endArray().endObject();
+    return out.take();
+}
+
+void sendAll(const std::vector<crow::websocket::connection*>& sockets, const std::string& message) {
+    for (crow::websocket::connection* conn : sockets) {
+        conn->send_text(message);
+    }
+    g_messages.fetch_add(sockets.size(), std::memory_order_relaxed);
+}
+
+// Re-reads one watched set and tells its sockets what changed.
+void pushSet(const SlotSetKey& key) {
+    std::shared_ptr<const SlotCatalogue> catalogue = slotCatalogue(g_push_db);
+    std::vector<SlotStatus> statuses;
+    if (!catalogue || !querySlotStatuses(g_push_db, *catalogue, key.first, key.second, statuses)) {
+        LOG_WARN("Slot push query failed", "doctor_id", key.first, "date", key.second);
+        return;
+    }
+
+    std::vector<std::size_t> all(statuses.size());
+    for (std::size_t i = 0; i < all.size(); ++i) {
+        all[i] = i;
+    }
+
+    std::lock_guard<std::mutex> lock(g_push_mutex);
+    auto it = g_sets.find(key);
+    if (it == g_sets.end()) {
+        return; // everyone left while we queried
+    }
+    WatchedSet& set = it->second;
+
+    if (set.catalogue != catalogue) {
+        // First look, or the slot list itself changed: everyone starts over.
+        const std::string snapshot = renderMessage(key, "snapshot", *catalogue, statuses, all);
+        sendAll(set.sockets, snapshot);
+        sendAll(set.awaiting_snapshot, snapshot);
+    } else {
+        std::vector<std::size_t> changed;
+        for (std::size_t i = 0; i < statuses.size(); ++i) {
+            if (statuses[i] != set.statuses[i]) {
+                changed.push_back(i);
+            }
+        }
+        if (!changed.empty()) {
+            sendAll(set.sockets, renderMessage(key, "delta", *catalogue, statuses, changed));
+        }
+        if (!set.awaiting_snapshot.empty()) {
+            sendAll(set.awaiting_snapshot, renderMessage(key, "snapshot", *catalogue, statuses, all));
+        }
+    }
+
+    set.sockets.insert(set.sockets.end(), set.awaiting_snapshot.begin(), set.awaiting_snapshot.end());
+    set.awaiting_snapshot.clear();
+    set.catalogue = std::move(catalogue);
+    set.statuses = std::move(statuses);
+}
+
+void pushLoop() {
+    for (;;) {
+        std::vector<SlotSetKey> keys;
+        {
+            std::unique_lock<std::mutex> lock(g_push_mutex);
+            g_push_cv.wait(lock, [] { return g_push_stop || g_all_dirty || !g_dirty.empty(); });
+            if (g_push_stop) {
+                return;
+            }
+            if (g_all_dirty) {
+                for (const auto& entry : g_sets) {
+                    keys.push_back(entry.first);
+                }
+            } else {
+                keys.assign(g_dirty.begin(), g_dirty.end());
+            }
+            g_dirty.clear();
+            g_all_dirty = false;
+        }
+        for (const SlotSetKey& key : keys) {
+            pushSet(key);
+        }
+    }
+}
+
+} // namespace
+
+bool startSlotPush(const std::string& path) {
+    g_push_db = openDatabase(path);
+    if (!g_push_db) {
+        return false;
+    }
+    g_push_stop = false;
+    g_push_thread = std::thread(pushLoop);
+    return true;
+}
+
+void stopSlotPush() {
+    {
+        std::lock_guard<std::mutex> lock(g_push_mutex);
+        g_push_stop = true;
+    }
+    g_push_cv.notify_all();
+    if (g_push_thread.joinable()) {
+        g_push_thread.join();
+    }
+    closeDatabase(g_push_db);
+    g_push_db = nullptr;
+}
+
+void slotPushSubscribe(crow::websocket::connection& conn, int doctor_id, const std::string& date) {
+    SlotSetKey key(doctor_id, date);
+    {
+        std::lock_guard<std::mutex> lock(g_push_mutex);
+        auto previous = g_socket_keys.find(&conn);
+        if (previous != g_socket_keys.end()) {
+            if (previous->second == key) {
+                return;
+            }
+            auto set = g_sets.find(previous->second);
+            removeSocket(set->second.sockets, &conn);
+            removeSocket(set->second.awaiting_snapshot, &conn);
+            if (set->second.sockets.empty() && set->second.awaiting_snapshot.empty()) {
+                g_sets.erase(set);
+            }
+        }
+        g_socket_keys[&conn] = key;
+        g_sets[key].awaiting_snapshot.push_back(&conn);
+        g_dirty.insert(std::move(key));
+    }
+    g_push_cv.notify_one();
+}
+
+void slotPushDisconnect(crow::websocket::connection& conn) {
+    std::lock_guard<std::mutex> lock(g_push_mutex);
+    auto it = g_socket_keys.find(&conn);
+    if (it == g_socket_keys.end()) {
+        return;
+    }
+    auto set = g_sets.find(it->second);
+    removeSocket(set->second.sockets, &conn);
+    removeSocket(set->second.awaiting_snapshot, &conn);
+    if (set->second.sockets.empty() && set->second.awaiting_snapshot.empty()) {
+        g_sets.erase(set);
+    }
+    g_socket_keys.erase(it);
+}
+
+void slotPushTablesChanged(const std::vector<RowChange>& changes) {
+    bool slot_rows_only = true;
+    for (const RowChange& change : changes) {
+        if (sqlite3_stricmp(change.table.c_str(), "Doctor_Schedule") == 0) {
+            slot_rows_only = false;
+            break;
+        }
+    }
+    const SlotWriteScope* scope = SlotWriteScope::current();
+    {
+        std::lock_guard<std::mutex> lock(g_push_mutex);
+        if (g_sets.empty()) {
+            return;
+        }
+        if (slot_rows_only && scope) {
+            SlotSetKey key(scope->doctorId(), scope->date());
+            if (g_sets.find(key) == g_sets.end()) {
+                return; // nobody is watching that day
+            }
+            g_dirty.insert(std::move(key));
+        } else {
+            g_all_dirty = true; // cannot tell which set; re-check them all
+        }
+    }
+    g_push_cv.notify_one();
+}
+
+SlotPushStats slotPushStats() {
+    std::lock_guard<std::mutex> lock(g_push_mutex);
+    return {g_socket_keys.size(), g_sets.size(), g_messages.load(std::memory_order_relaxed)};
+}
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <crow.h>
+
+#include "change_feed.h"
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+// Live slot status for open schedule pages. A WebSocket subscribes to one
+// (doctor, date); it first gets a "snapshot" with every slot, then a "delta"
+// with just the slots that changed after each committed booking,
+// cancellation, block or unblock:
+//
+//   {"type":"delta","doctor_id":4,"date":"2030-01-07",
+//    "slots":[{"schedule_id":3,"time_slot":"09:30","status":"BOOKED"}]}
+//
+// Idle sockets cost no work: only changes to a watched (doctor, date) are
+// queried, once per change however many sockets watch it, and the message is
+// serialized once for all of them.
+
+// Starts the push thread with its own connection to `path`.
+bool startSlotPush(const std::string& path);
+
+// Stops the push thread and closes its connection.
+void stopSlotPush();
+
+// Points `conn` at (doctor_id, date), replacing its previous subscription.
+void slotPushSubscribe(crow::websocket::connection& conn, int doctor_id, const std::string& date);
+
+// Forgets `conn`; call from the close handler, before Crow frees it.
+void slotPushDisconnect(crow::websocket::connection& conn);
+
+// Change-feed subscriber for Appointment, Doctor_Blocked_Slots and
+// Doctor_Schedule. Register it after the slot catalogue's own subscriber.
+void slotPushTablesChanged(const std::vector<RowChange>& changes);
+
+struct SlotPushStats {
+    std::size_t connections;  // subscribed sockets
+    std::size_t watched_sets; // distinct (doctor, date) among them
+    unsigned long long messages;
+};
+
+SlotPushStats slotPushStats();
@@ -0,0 +1,72 @@
+#include "slot_versions.h"
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cinttypes>
+#include <cstdio>
+
+namespace {
+
+// Versions are kept per stripe rather than per (doctor, date), so memory
+// stays fixed; two sets sharing a stripe only cost each other a 200 now and
+// then, never a stale 304.
+constexpr unsigned kStripes = 4096;
+
+std::array<std::atomic<uint64_t>, kStripes> g_stripes{};
+
+// Bumped by writes that cannot be pinned to one slot set.
+std::atomic<uint64_t> g_epoch{0};
+
+// Counters restart at zero, so tags from before a restart must not match.
+const uint64_t g_boot = static_cast<uint64_t>(std::chrono::system_clock::now().time_since_epoch().count());
+
+thread_local SlotWriteScope* t_scope = nullptr;
+
+unsigned stripeOf(int doctor_id, const std::string& date) {
+    uint64_t h = 1469598103934665603ULL ^ static_cast<uint32_t>(doctor_id); // FNV-1a
+    h *= 1099511628211ULL;
+    for (unsigned char c : date) {
+        h ^= c;
+        h *= 1099511628211ULL;
+    }
+    return static_cast<unsigned>(h ^ (h >> 32)) % kStripes;
+}
+
+} // namespace
+
+std::string slotSetEtag(int doctor_id, const std::string& date) {
+    const uint64_t epoch = g_epoch.load(std::memory_order_acquire);
+    const uint64_t version = g_stripes[stripeOf(doctor_id, date)].load(std::memory_order_acquire);
+    char tag[64];
+    std::snprintf(tag, sizeof(tag), "\"s%" PRIx64 ".%" PRIu64 ".%" PRIu64 "\"", g_boot, epoch, version);
+    return tag;
+}
+
+SlotWriteScope::SlotWriteScope(int doctor_id, const std::string& date)
+    : doctor_id_(doctor_id), date_(date), stripe_(stripeOf(doctor_id, date)), previous_(t_scope) {
+    t_scope = this;
+}
+
+SlotWriteScope::~SlotWriteScope() {
+    t_scope = previous_;
+}
+
+const SlotWriteScope* SlotWriteScope::current() {
+    return t_scope;
+}
+
+void slotTablesChanged(const std::vector<RowChange>& changes) {
+    bool slot_rows_only = true;
+    for (const RowChange& change : changes) {
+        if (sqlite3_stricmp(change.table.c_str(), "Doctor_Schedule") == 0) {
+            slot_rows_only = false; // the slot list itself changed
+            break;
+        }
+    }
+    if (slot_rows_only && t_scope) {
+        g_stripes[t_scope->stripe_].fetch_add(1, std::memory_order_acq_rel);
+    } else {
+        g_epoch.fetch_add(1, std::memory_order_acq_rel);
+    }
+}
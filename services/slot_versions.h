@@ -0,0 +1,44 @@
+#pragma once
+
+#include "change_feed.h"
+
+#include <string>
+#include <vector>
+
+// Strong ETag for the slot set of (doctor, date): the Appointment and
+// Doctor_Blocked_Slots rows behind /get_slots_status and
+// /get_available_slots. It changes whenever a committed write may have
+// touched them; read it before querying, so the tag never claims newer data
+// than the body carries.
+std::string slotSetEtag(int doctor_id, const std::string& date);
+
+// Declares which slot set the DB work on this thread writes. Changes
+// committed inside the scope bump only that set's version; changes committed
+// outside any scope (cancellations, cascades, foreign tools) bump every set.
+class SlotWriteScope {
+public:
+    SlotWriteScope(int doctor_id, const std::string& date);
+    ~SlotWriteScope();
+
+    SlotWriteScope(const SlotWriteScope&) = delete;
+    SlotWriteScope& operator=(const SlotWriteScope&) = delete;
+
+    int doctorId() const { return doctor_id_; }
+    const std::string& date() const { return date_; }
+
+    // The innermost scope on this thread, or null. Change-feed subscribers
+    // run on the committing thread, so they see the writer's scope.
+    static const SlotWriteScope* current();
+
+private:
+    friend void slotTablesChanged(const std::vector<RowChange>& changes);
+
+    int doctor_id_;
+    std::string date_;
+    unsigned stripe_;
+    SlotWriteScope* previous_;
+};
+
+// Change-feed subscriber for Appointment, Doctor_Blocked_Slots and
+// Doctor_Schedule.
+void slotTablesChanged(const std::vector<RowChange>& changes);
@@ -0,0 +1,165 @@
+#include "sql_statements.h"
+
+#include "logger.h"
+
+#include <algorithm>
+#include <array>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace {
+
+struct StatementInfo {
+    std::size_t id;
+    const char* name;
+    const char* sql;
+    int params;
+    int columns;
+};
+
+template <class... P, class... C>
+constexpr StatementInfo describe(const Statement<Params<P...>, Columns<C...>>& statement) {
+    return {statement.id, statement.name, statement.sql, static_cast<int>(sizeof...(P)),
+            static_cast<int>(sizeof...(C))};
+}
+
+// Every statement in sql_statements.h, in id order.
+constexpr StatementInfo kStatements[] = {
+    describe(sql::kSlotsAll),
+    describe(sql::kSlotInsert),
+    describe(sql::kSlotBooked),
+    describe(sql::kSlotBlocked),
+    describe(sql::kSlotBlock),
+    describe(sql::kSlotUnblock),
+    describe(sql::kSlotsTaken),
+    describe(sql::kSlotsAvailable),
+    describe(sql::kDoctorInsert),
+    describe(sql::kDoctorDelete),
+    describe(sql::kDoctorsAll),
+    describe(sql::kDoctorsByCategory),
+    describe(sql::kDoctorDirectory),
+    describe(sql::kDoctorVerify),
+    describe(sql::kCategoryInsert),
+    describe(sql::kCategoryDelete),
+    describe(sql::kCategoriesAll),
+    describe(sql::kCategoryName),
+    describe(sql::kPatientInsert),
+    describe(sql::kPatientExists),
+    describe(sql::kPatientDelete),
+    describe(sql::kPatientForCancellation),
+    describe(sql::kPatientMarkCancelled),
+    describe(sql::kAppointmentExists),
+    describe(sql::kAppointmentInsert),
+    describe(sql::kAppointmentRebook),
+    describe(sql::kAppointmentCancel),
+    describe(sql::kAppointmentsForDoctorDay),
+    describe(sql::kConfirmationDetails),
+};
+
+constexpr bool idsMatchPositions() {
+    for (std::size_t i = 0; i < std::size(kStatements); ++i) {
+        if (kStatements[i].id != i) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static_assert(std::size(kStatements) == sql::kStatementCount, "list every statement in kStatements");
+static_assert(idsMatchPositions(), "statement ids must match their position in kStatements");
+
+// Blocks live in their own table, not Appointment (which has a unique
+// constraint on doctor+slot+date). Older databases predate it, and the
+// statements above need it to prepare.
+const char* const kCreateBlockedSlots =
+    "CREATE TABLE IF NOT EXISTS Doctor_Blocked_Slots ("
+    "  doctor_id INTEGER NOT NULL,"
+    "  schedule_id INTEGER NOT NULL,"
+    "  appointment_date TEXT NOT NULL,"
+    "  created_at TEXT NOT NULL DEFAULT (datetime('now','localtime')),"
+    "  PRIMARY KEY (doctor_id, schedule_id, appointment_date),"
+    "  FOREIGN KEY (doctor_id) REFERENCES Doctor(doctor_id) ON DELETE CASCADE,"
+    "  FOREIGN KEY (schedule_id) REFERENCES Doctor_Schedule(schedule_id) ON DELETE CASCADE"
+    ");";
+
+struct PreparedSet {
+    sqlite3* db;
+    std::array<sqlite3_stmt*, sql::kStatementCount> statements{};
+};
+
+std::mutex g_sets_mutex;
+std::vector<std::unique_ptr<PreparedSet>> g_sets;
+
+// Each executor thread sticks to one connection, so the last set it used is
+// almost always the one it wants.
+thread_local const PreparedSet* t_last_set = nullptr;
+
+void finalizeAll(PreparedSet& set) {
+    for (sqlite3_stmt*& stmt : set.statements) {
+        sqlite3_finalize(stmt);
+        stmt = nullptr;
+    }
+}
+
+} // namespace
+
+bool prepareStatements(sqlite3* db) {
+    char* err = nullptr;
+    if (sqlite3_exec(db, kCreateBlockedSlots, nullptr, nullptr, &err) != SQLITE_OK) {
+        LOG_ERROR("Failed to ensure Doctor_Blocked_Slots table", "error", err ? err : sqlite3_errmsg(db));
+        sqlite3_free(err);
+        return false;
+    }
+
+    auto set = std::make_unique<PreparedSet>();
+    set->db = db;
+    for (const StatementInfo& info : kStatements) {
+        sqlite3_stmt*& stmt = set->statements[info.id];
+        if (sqlite3_prepare_v3(db, info.sql, -1, SQLITE_PREPARE_PERSISTENT, &stmt, nullptr) != SQLITE_OK) {
+            LOG_ERROR("Preparing statement failed", "statement", info.name, "error", sqlite3_errmsg(db));
+            finalizeAll(*set);
+            return false;
+        }
+        const int params = sqlite3_bind_parameter_count(stmt);
+        const int columns = sqlite3_column_count(stmt);
+        if (params != info.params || columns != info.columns) {
+            LOG_ERROR("Statement does not match its declaration", "statement", info.name, "params", params,
+                      "declared_params", info.params, "columns", columns, "declared_columns", info.columns);
+            finalizeAll(*set);
+            return false;
+        }
+    }
+
+    std::lock_guard<std::mutex> lock(g_sets_mutex);
+    g_sets.push_back(std::move(set));
+    return true;
+}
+
+void finalizeStatements(sqlite3* db) {
+    std::lock_guard<std::mutex> lock(g_sets_mutex);
+    auto it = std::find_if(g_sets.begin(), g_sets.end(), [db](const auto& set) { return set->db == db; });
+    if (it == g_sets.end()) {
+        return;
+    }
+    if (t_last_set == it->get()) {
+        t_last_set = nullptr;
+    }
+    finalizeAll(**it);
+    g_sets.erase(it);
+}
+
+sqlite3_stmt* preparedStatement(sqlite3* db, std::size_t id) {
+    const PreparedSet* set = t_last_set;
+    if (!set || set->db != db) {
+        std::lock_guard<std::mutex> lock(g_sets_mutex);
+        auto it = std::find_if(g_sets.begin(), g_sets.end(), [db](const auto& s) { return s->db == db; });
+        if (it == g_sets.end()) {
+            LOG_ERROR("No prepared statements for this connection", "statement", kStatements[id].name);
+            return nullptr;
+        }
+        set = it->get();
+        t_last_set = set;
+    }
+    return set->statements[id];
+}
@@ -0,0 +1,384 @@
+#pragma once
+
+#include <sqlite3.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+// Every SQL statement the server runs, by name, with its parameter and
+// result column types. openDatabase() prepares all of them on each
+// connection and refuses to start when one no longer matches the schema, so
+// a renamed column is a startup error instead of a failed booking.
+//
+//   auto taken = query(db, sql::kSlotBooked, doctor_id, schedule_id, date);
+//   if (taken.step()) ...                    // parameters bound by type
+//
+//   auto rows = query(db, sql::kCategoryName, category_id);
+//   while (rows.step()) {
+//       std::string name = rows.get<0>();    // column type from the declaration
+//   }
+//
+// Parameter types: int, int64_t, double, std::string_view. Column types:
+// int, int64_t, double, std::string, and std::string_view (valid until the
+// next step). NULL text reads as "".
+//
+// A statement is a single prepared handle per connection: finish with one
+// Query before running the same statement again on that connection. A Query
+// left on a row holds its read transaction until it goes away, so keep it in
+// a scope that ends before the caller writes.
+
+template <class... T>
+struct Params {};
+
+template <class... T>
+struct Columns {};
+
+template <class P, class C>
+struct Statement;
+
+template <class... P, class... C>
+struct Statement<Params<P...>, Columns<C...>> {
+    std::size_t id; // position in the registry (sql_statements.cpp)
+    const char* name;
+    const char* sql;
+};
+
+namespace sql {
+
+// ---- Slots ----------------------------------------------------------------
+
+inline constexpr Statement<Params<>, Columns<int, std::string>> kSlotsAll{
+    0, "slots_all", "SELECT schedule_id, time_slot FROM Doctor_Schedule ORDER BY time_slot;"};
+
+inline constexpr Statement<Params<std::string_view>, Columns<>> kSlotInsert{
+    1, "slot_insert", "INSERT INTO Doctor_Schedule (time_slot) VALUES (?);"};
+
+inline constexpr Statement<Params<int, int, std::string_view>, Columns<int>> kSlotBooked{
+    2, "slot_booked",
+    "SELECT 1 FROM Appointment "
+    "WHERE doctor_id = ? AND schedule_id = ? AND appointment_date = ? AND status = 'BOOKED' "
+    "LIMIT 1;"};
+
+inline constexpr Statement<Params<int, int, std::string_view>, Columns<int>> kSlotBlocked{
+    3, "slot_blocked",
+    "SELECT 1 FROM Doctor_Blocked_Slots "
+    "WHERE doctor_id = ? AND schedule_id = ? AND appointment_date = ? "
+    "LIMIT 1;"};
+
+inline constexpr Statement<Params<int, int, std::string_view>, Columns<>> kSlotBlock{
+    4, "slot_block",
+    "INSERT OR IGNORE INTO Doctor_Blocked_Slots (doctor_id, schedule_id, appointment_date) "
+    "VALUES (?, ?, ?);"};
+
+inline constexpr Statement<Params<int, int, std::string_view>, Columns<>> kSlotUnblock{
+    5, "slot_unblock",
+    "DELETE FROM Doctor_Blocked_Slots "
+    "WHERE doctor_id = ? AND schedule_id = ? AND appointment_date = ?;"};
+
+// Only the taken slots of a day (1 = booked, 0 = blocked); every other
+// catalogue slot is available. Parameters: doctor_id, date, doctor_id, date.
+inline constexpr Statement<Params<int, std::string_view, int, std::string_view>, Columns<int, int>> kSlotsTaken{
+    6, "slots_taken",
+    "SELECT schedule_id, 1 FROM Appointment "
+    "WHERE doctor_id = ? AND appointment_date = ? AND status = 'BOOKED' "
+    "UNION ALL "
+    "SELECT schedule_id, 0 FROM Doctor_Blocked_Slots "
+    "WHERE doctor_id = ? AND appointment_date = ?;"};
+
+// Parameters: doctor_id, date, doctor_id, date.
+inline constexpr Statement<Params<int, std::string_view, int, std::string_view>, Columns<int, std::string>>
+    kSlotsAvailable{7, "slots_available",
+                    "SELECT ds.schedule_id, ds.time_slot "
+                    "FROM Doctor_Schedule ds "
+                    "WHERE NOT EXISTS ("
+                    "    SELECT 1 FROM Appointment a "
+                    "    WHERE a.doctor_id = ? "
+                    "      AND a.schedule_id = ds.schedule_id "
+                    "      AND a.appointment_date = ? "
+                    "      AND a.status = 'BOOKED'"
+                    ") "
+                    "AND NOT EXISTS ("
+                    "    SELECT 1 FROM Doctor_Blocked_Slots b "
+                    "    WHERE b.doctor_id = ? "
+                    "      AND b.schedule_id = ds.schedule_id "
+                    "      AND b.appointment_date = ?"
+                    ") "
+                    "ORDER BY ds.time_slot;"};
+
+// ---- Doctors --------------------------------------------------------------
+
+inline constexpr Statement<
+    Params<std::string_view, std::string_view, std::string_view, std::string_view, double, int>, Columns<>>
+    kDoctorInsert{8, "doctor_insert",
+                  "INSERT INTO Doctor (doctor_name, phone, experience_years, qualification, ratings, category_id) "
+                  "VALUES (?, ?, ?, ?, ?, ?);"};
+
+inline constexpr Statement<Params<int>, Columns<>> kDoctorDelete{
+    9, "doctor_delete", "DELETE FROM Doctor WHERE doctor_id = ?;"};
+
+inline constexpr Statement<Params<>, Columns<int, std::string, std::string, std::string, double, int>> kDoctorsAll{
+    10, "doctors_all",
+    "SELECT doctor_id, doctor_name, experience_years, qualification, ratings, category_id FROM Doctor;"};
+
+inline constexpr Statement<Params<int>, Columns<int, std::string, std::string, std::string, double, int>>
+    kDoctorsByCategory{11, "doctors_by_category",
+                       "SELECT doctor_id, doctor_name, experience_years, qualification, ratings, category_id "
+                       "FROM Doctor WHERE category_id = ?;"};
+
+// The doctor directory: every doctor with its category name.
+inline constexpr Statement<Params<>,
+                           Columns<int, std::string, std::string, std::string, double, int, std::string>>
+    kDoctorDirectory{12, "doctor_directory",
+                     "SELECT d.doctor_id, d.doctor_name, d.experience_years, d.qualification, d.ratings, "
+                     "       d.category_id, c.category_name "
+                     "FROM Doctor d LEFT JOIN Category c ON c.category_id = d.category_id "
+                     "ORDER BY d.doctor_id;"};
+
+// Dashboard sign-in. Parameters: doctor_name, phone.
+inline constexpr Statement<Params<std::string_view, std::string_view>, Columns<int, std::string>> kDoctorVerify{
+    13, "doctor_verify",
+    "SELECT doctor_id, doctor_name "
+    "FROM Doctor "
+    "WHERE lower(trim(doctor_name)) = lower(trim(?)) "
+    "  AND trim(phone) = trim(?) "
+    "LIMIT 1;"};
+
+// ---- Categories -----------------------------------------------------------
+
+inline constexpr Statement<Params<std::string_view, std::string_view>, Columns<>> kCategoryInsert{
+    14, "category_insert", "INSERT INTO Category (category_name, description) VALUES (?, ?);"};
+
+inline constexpr Statement<Params<int>, Columns<>> kCategoryDelete{
+    15, "category_delete", "DELETE FROM Category WHERE category_id = ?;"};
+
+inline constexpr Statement<Params<>, Columns<int, std::string, std::string>> kCategoriesAll{
+    16, "categories_all", "SELECT category_id, category_name, description FROM Category;"};
+
+inline constexpr Statement<Params<int>, Columns<std::string>> kCategoryName{
+    17, "category_name", "SELECT category_name FROM Category WHERE category_id = ? LIMIT 1;"};
+
+// ---- Patients -------------------------------------------------------------
+
+// Parameters: patient_id, name, age, email, gender, request.
+inline constexpr Statement<
+    Params<int, std::string_view, int, std::string_view, std::string_view, std::string_view>, Columns<>>
+    kPatientInsert{18, "patient_insert",
+                   "INSERT INTO Patient (patient_id, name, age, email, gender, request) "
+                   "VALUES (?, ?, ?, ?, ?, ?);"};
+
+inline constexpr Statement<Params<int>, Columns<int>> kPatientExists{
+    19, "patient_exists", "SELECT 1 FROM Patient WHERE patient_id = ?;"};
+
+inline constexpr Statement<Params<int>, Columns<>> kPatientDelete{
+    20, "patient_delete", "DELETE FROM Patient WHERE patient_id = ?;"};
+
+// Identity check before a cancellation. Parameters: patient_id, name, email, age.
+inline constexpr Statement<Params<int, std::string_view, std::string_view, int>,
+                           Columns<int, std::string, int, std::string, std::string>>
+    kPatientForCancellation{21, "patient_for_cancellation",
+                            "SELECT patient_id, name, age, email, request FROM Patient "
+                            "WHERE patient_id = ? AND name = ? AND email = ? AND age = ?;"};
+
+inline constexpr Statement<Params<int>, Columns<>> kPatientMarkCancelled{
+    22, "patient_mark_cancelled", "UPDATE Patient SET request = 'Cancelled the booking' WHERE patient_id = ?;"};
+
+// ---- Appointments ---------------------------------------------------------
+
+inline constexpr Statement<Params<int>, Columns<int>> kAppointmentExists{
+    23, "appointment_exists", "SELECT 1 FROM Appointment WHERE appointment_id = ?;"};
+
+// Parameters: appointment_id, patient_id, doctor_id, schedule_id, date.
+inline constexpr Statement<Params<int, int, int, int, std::string_view>, Columns<>> kAppointmentInsert{
+    24, "appointment_insert",
+    "INSERT INTO Appointment(appointment_id, patient_id, doctor_id, schedule_id, appointment_date, status, "
+    "created_at) "
+    "VALUES (?, ?, ?, ?, ?, 'BOOKED', datetime('now','localtime'));"};
+
+// Takes over a cancelled row for the same slot. Parameters: appointment_id,
+// patient_id, doctor_id, schedule_id, date.
+inline constexpr Statement<Params<int, int, int, int, std::string_view>, Columns<>> kAppointmentRebook{
+    25, "appointment_rebook",
+    "UPDATE Appointment "
+    "SET appointment_id = ?, patient_id = ?, status = 'BOOKED', created_at = datetime('now','localtime') "
+    "WHERE doctor_id = ? AND schedule_id = ? AND appointment_date = ? AND status != 'BOOKED';"};
+
+// Parameters: appointment_id, patient_id.
+inline constexpr Statement<Params<int, int>, Columns<>> kAppointmentCancel{
+    26, "appointment_cancel",
+    "UPDATE Appointment SET status = 'Cancelled' WHERE appointment_id = ? AND patient_id = ?;"};
+
+inline constexpr Statement<Params<int, std::string_view>,
+                           Columns<int, int, int, int, std::string, std::string, std::string>>
+    kAppointmentsForDoctorDay{27, "appointments_for_doctor_day",
+                              "SELECT appointment_id, patient_id, doctor_id, schedule_id, appointment_date, "
+                              "       status, created_at "
+                              "FROM Appointment "
+                              "WHERE doctor_id = ? AND appointment_date = ? "
+                              "ORDER BY schedule_id;"};
+
+// Parameters: appointment_id, patient_id.
+inline constexpr Statement<Params<int, int>,
+                           Columns<int, int, std::string, std::string, std::string, int>>
+    kConfirmationDetails{28, "confirmation_details",
+                         "SELECT a.appointment_id, a.patient_id, p.name, d.doctor_name, "
+                         "       a.appointment_date, a.schedule_id "
+                         "FROM Appointment a "
+                         "JOIN Patient p ON p.patient_id = a.patient_id "
+                         "JOIN Doctor d ON d.doctor_id = a.doctor_id "
+                         "WHERE a.appointment_id = ? AND a.patient_id = ? "
+                         "LIMIT 1;"};
+
+inline constexpr std::size_t kStatementCount = 29;
+
+} // namespace sql
+
+// Creates the tables the server owns, then prepares every statement above on
+// `db`. False (and logged) when a statement fails to prepare or its
+// parameter or column count differs from its declaration.
+bool prepareStatements(sqlite3* db);
+
+// Finalizes `db`'s statements. Call before sqlite3_close(), once every
+// thread that ran queries on the connection is done with it.
+void finalizeStatements(sqlite3* db);
+
+// The prepared handle of statement `id` on `db`, or null (logged) when the
+// connection was not opened through prepareStatements().
+sqlite3_stmt* preparedStatement(sqlite3* db, std::size_t id);
+
+namespace sql_detail {
+
+template <class T>
+struct Identity {
+    using type = T;
+};
+
+inline int bind(sqlite3_stmt* stmt, int index, int value) { return sqlite3_bind_int(stmt, index, value); }
+inline int bind(sqlite3_stmt* stmt, int index, int64_t value) { return sqlite3_bind_int64(stmt, index, value); }
+inline int bind(sqlite3_stmt* stmt, int index, double value) { return sqlite3_bind_double(stmt, index, value); }
+inline int bind(sqlite3_stmt* stmt, int index, std::string_view value) {
+    // A default-constructed view has no data pointer, which SQLite would bind as NULL.
+    return sqlite3_bind_text(stmt, index, value.data() ? value.data() : "", static_cast<int>(value.size()),
+                             SQLITE_TRANSIENT);
+}
+
+template <class T>
+struct ColumnReader;
+
+template <>
+struct ColumnReader<int> {
+    static int read(sqlite3_stmt* stmt, int column) { return sqlite3_column_int(stmt, column); }
+};
+
+template <>
+struct ColumnReader<int64_t> {
+    static int64_t read(sqlite3_stmt* stmt, int column) { return sqlite3_column_int64(stmt, column); }
+};
+
+template <>
+struct ColumnReader<double> {
+    static double read(sqlite3_stmt* stmt, int column) { return sqlite3_column_double(stmt, column); }
+};
+
+template <>
+struct ColumnReader<std::string_view> {
+    static std::string_view read(sqlite3_stmt* stmt, int column) {
+        const unsigned char* text = sqlite3_column_text(stmt, column);
+        if (!text) {
+            return {};
+        }
+        return {reinterpret_cast<const char*>(text), static_cast<std::size_t>(sqlite3_column_bytes(stmt, column))};
+    }
+};
+
+template <>
+struct ColumnReader<std::string> {
+    static std::string read(sqlite3_stmt* stmt, int column) {
+        return std::string(ColumnReader<std::string_view>::read(stmt, column));
+    }
+};
+
+} // namespace sql_detail
+
+// One run of a registered statement, with parameters bound. Resets the
+// statement when it goes away.
+template <class... C>
+class Query {
+public:
+    Query(sqlite3_stmt* stmt, int rc) : stmt_(stmt), rc_(rc) {}
+    Query(Query&& other) noexcept : stmt_(other.stmt_), rc_(other.rc_) { other.stmt_ = nullptr; }
+    Query(const Query&) = delete;
+    Query& operator=(const Query&) = delete;
+    Query& operator=(Query&&) = delete;
+
+    ~Query() {
+        if (stmt_) {
+            sqlite3_reset(stmt_);
+            sqlite3_clear_bindings(stmt_);
+        }
+    }
+
+    // Advances to the next row; false when there are no more rows or the
+    // step failed (see rc()).
+    bool step() {
+        if (!stmt_ || (rc_ != SQLITE_OK && rc_ != SQLITE_ROW)) {
+            return false;
+        }
+        rc_ = sqlite3_step(stmt_);
+        return rc_ == SQLITE_ROW;
+    }
+
+    // SQLITE_OK before the first step, then the result of the last step.
+    int rc() const { return rc_; }
+    bool done() const { return rc_ == SQLITE_DONE; }
+
+    template <std::size_t I>
+    std::tuple_element_t<I, std::tuple<C...>> get() const {
+        return sql_detail::ColumnReader<std::tuple_element_t<I, std::tuple<C...>>>::read(stmt_, static_cast<int>(I));
+    }
+
+    std::tuple<C...> row() const { return rowAt(std::index_sequence_for<C...>()); }
+
+    // For the row mappers in model_fields.h.
+    sqlite3_stmt* handle() const { return stmt_; }
+
+private:
+    template <std::size_t... I>
+    std::tuple<C...> rowAt(std::index_sequence<I...>) const {
+        return std::tuple<C...>(get<I>()...);
+    }
+
+    sqlite3_stmt* stmt_;
+    int rc_;
+};
+
+// Binds `args` to `statement` on `db`, ready to step.
+template <class... P, class... C>
+Query<C...> query(sqlite3* db, const Statement<Params<P...>, Columns<C...>>& statement,
+                  typename sql_detail::Identity<P>::type... args) {
+    sqlite3_stmt* stmt = preparedStatement(db, statement.id);
+    if (!stmt) {
+        return Query<C...>(nullptr, SQLITE_ERROR);
+    }
+    int rc = SQLITE_OK;
+    int index = 0;
+    ((rc = rc == SQLITE_OK ? sql_detail::bind(stmt, ++index, args) : rc), ...);
+    if (rc != SQLITE_OK) {
+        sqlite3_clear_bindings(stmt);
+        return Query<C...>(nullptr, rc);
+    }
+    return Query<C...>(stmt, SQLITE_OK);
+}
+
+// Runs a statement that returns no rows; SQLITE_DONE on success.
+template <class... P>
+int execute(sqlite3* db, const Statement<Params<P...>, Columns<>>& statement,
+            typename sql_detail::Identity<P>::type... args) {
+    Query<> run = query(db, statement, args...);
+    run.step();
+    return run.rc();
+}
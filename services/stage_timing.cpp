@@ -0,0 +1,166 @@
+#include "stage_timing.h"
+
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+#include <string>
+
+namespace {
+
+constexpr int kStages = static_cast<int>(Stage::Count);
+
+struct RouteTotals {
+    std::atomic<uint64_t> requests;
+    std::atomic<uint64_t> ns[kStages];
+};
+
+// Same layout idea as the route metrics: one shard per thread, single writer.
+struct ThreadTotals {
+    RouteTotals routes[kMaxTrackedRoutes];
+};
+
+std::vector<ThreadTotals*> g_totals;
+std::mutex g_totals_mutex;
+thread_local ThreadTotals* t_totals = nullptr;
+thread_local RequestTiming* t_timing = nullptr;
+
+ThreadTotals& localTotals() {
+    if (!t_totals) {
+        t_totals = new ThreadTotals();
+        std::lock_guard<std::mutex> lock(g_totals_mutex);
+        g_totals.push_back(t_totals);
+    }
+    return *t_totals;
+}
+
+void bump(std::atomic<uint64_t>& counter, uint64_t by) {
+    counter.store(counter.load(std::memory_order_relaxed) + by, std::memory_order_relaxed);
+}
+
+bool serverTimingHeaderEnabled() {
+    static const bool enabled = [] {
+        const char* env = std::getenv("SERVER_TIMING");
+        return env && std::strcmp(env, "1") == 0;
+    }();
+    return enabled;
+}
+
+} // namespace
+
+const char* stageName(Stage stage) {
+    switch (stage) {
+    case Stage::Queue: return "queue";
+    case Stage::Handler: return "handler";
+    case Stage::Parse: return "parse";
+    case Stage::Session: return "session";
+    case Stage::Context: return "context";
+    case Stage::Db: return "db";
+    case Stage::Serialize: return "serialize";
+    case Stage::Count: break;
+    }
+    return "other";
+}
+
+RequestTiming::RequestTiming(Stage initial)
+    : active_(initial), since_(std::chrono::steady_clock::now()), outer_(t_timing) {
+    t_timing = this;
+}
+
+RequestTiming::~RequestTiming() {
+    t_timing = outer_;
+}
+
+void RequestTiming::add(Stage stage, std::chrono::steady_clock::duration elapsed) {
+    ns_[static_cast<int>(stage)] += std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count();
+}
+
+void RequestTiming::enter(Stage stage) {
+    const auto now = std::chrono::steady_clock::now();
+    add(active_, now - since_);
+    since_ = now;
+    active_ = stage;
+}
+
+void RequestTiming::finish(const RouteTag& tag, crow::response& res) {
+    if (finished_) {
+        return;
+    }
+    enter(active_);
+    finished_ = true;
+
+    if (tag.id >= 0 && tag.id < kMaxTrackedRoutes) {
+        RouteTotals& totals = localTotals().routes[tag.id];
+        bump(totals.requests, 1);
+        for (int i = 0; i < kStages; ++i) {
+            bump(totals.ns[i], static_cast<uint64_t>(ns_[i]));
+        }
+    }
+
+    if (!serverTimingHeaderEnabled()) {
+        return;
+    }
+    std::string header;
+    int64_t total = 0;
+    char entry[48];
+    for (int i = 0; i < kStages; ++i) {
+        total += ns_[i];
+        if (ns_[i] == 0) {
+            continue;
+        }
+        std::snprintf(entry, sizeof(entry), "%s;dur=%.3f, ", stageName(static_cast<Stage>(i)), ns_[i] / 1e6);
+        header += entry;
+    }
+    std::snprintf(entry, sizeof(entry), "total;dur=%.3f", total / 1e6);
+    header += entry;
+    res.set_header("Server-Timing", header);
+}
+
+StageTimer::StageTimer(Stage stage) : timing_(t_timing), previous_(stage) {
+    if (timing_) {
+        previous_ = timing_->active_;
+        timing_->enter(stage);
+    }
+}
+
+StageTimer::~StageTimer() {
+    if (timing_) {
+        timing_->enter(previous_);
+    }
+}
+
+crow::response jsonResponse(int code, const crow::json::wvalue& body) {
+    StageTimer timer(Stage::Serialize);
+    return crow::response(code, body);
+}
+
+std::vector<RouteTimingStats> routeTimingStats() {
+    const int routes = std::min<int>(kMaxTrackedRoutes, static_cast<int>(routeCount()));
+    std::vector<unsigned long long> requests(routes, 0);
+    std::vector<double> ns(static_cast<std::size_t>(routes) * kStages, 0.0);
+    {
+        std::lock_guard<std::mutex> lock(g_totals_mutex);
+        for (const ThreadTotals* shard : g_totals) {
+            for (int r = 0; r < routes; ++r) {
+                requests[r] += shard->routes[r].requests.load(std::memory_order_relaxed);
+                for (int i = 0; i < kStages; ++i) {
+                    ns[r * kStages + i] += shard->routes[r].ns[i].load(std::memory_order_relaxed);
+                }
+            }
+        }
+    }
+
+    std::vector<RouteTimingStats> out;
+    for (int r = 0; r < routes; ++r) {
+        if (requests[r] == 0) {
+            continue;
+        }
+        RouteTimingStats stats{r, requests[r], {}};
+        for (int i = 0; i < kStages; ++i) {
+            stats.avg_ms[i] = ns[r * kStages + i] / 1e6 / requests[r];
+        }
+        out.push_back(stats);
+    }
+    return out;
+}
@@ -0,0 +1,78 @@
+#pragma once
+
+#include <crow.h>
+
+#include "admission.h"
+
+#include <chrono>
+#include <cstdint>
+#include <vector>
+
+// Phases a request's time is split into. Time is charged exclusively: while a
+// nested StageTimer runs, the enclosing stage's clock is paused.
+enum class Stage {
+    Queue,     // admitted, waiting for a DB executor thread
+    Handler,   // handler code not covered by another stage
+    Parse,     // JSON request bodies
+    Session,   // public session checks and issuing
+    Context,   // in-memory session / context maps
+    Db,        // SQLite work (the default stage of DB executor tasks)
+    Serialize, // JSON response bodies
+    Count
+};
+
+// Per-request accumulator, installed as the current thread's while the
+// handler runs. The dispatch helpers (submitDbWork, respondInline) own it;
+// handlers only open StageTimers.
+class RequestTiming {
+public:
+    explicit RequestTiming(Stage initial);
+    ~RequestTiming();
+
+    RequestTiming(const RequestTiming&) = delete;
+    RequestTiming& operator=(const RequestTiming&) = delete;
+
+    void add(Stage stage, std::chrono::steady_clock::duration elapsed);
+
+    // Stops the clock, adds the stages to the per-route aggregates, and sets
+    // a Server-Timing header on `res` when SERVER_TIMING=1.
+    void finish(const RouteTag& tag, crow::response& res);
+
+private:
+    friend class StageTimer;
+    void enter(Stage stage);
+
+    int64_t ns_[static_cast<int>(Stage::Count)] = {};
+    Stage active_;
+    std::chrono::steady_clock::time_point since_;
+    RequestTiming* outer_;
+    bool finished_ = false;
+};
+
+// Charges the enclosing scope to `stage` on the current request, if any.
+class StageTimer {
+public:
+    explicit StageTimer(Stage stage);
+    ~StageTimer();
+
+    StageTimer(const StageTimer&) = delete;
+    StageTimer& operator=(const StageTimer&) = delete;
+
+private:
+    RequestTiming* timing_;
+    Stage previous_;
+};
+
+// crow::response(code, body), with the JSON dump charged to Stage::Serialize.
+crow::response jsonResponse(int code, const crow::json::wvalue& body);
+
+const char* stageName(Stage stage);
+
+struct RouteTimingStats {
+    int route_id;
+    unsigned long long requests;
+    double avg_ms[static_cast<int>(Stage::Count)];
+};
+
+// Per-route mean time spent in each stage, for routes seen so far.
+std::vector<RouteTimingStats> routeTimingStats();
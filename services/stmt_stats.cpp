@@ -0,0 +1,166 @@
+#include "stmt_stats.h"
+#include "latency_histogram.h"
+#include "logger.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cctype>
+#include <cstdlib>
+#include <functional>
+#include <mutex>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+
+namespace {
+
+constexpr long long kDefaultSlowQueryMillis = 200;
+
+// Statements finish on every executor thread; sharding keeps them from
+// serializing on one registry lock.
+constexpr std::size_t kShards = 16;
+
+// A statement that is stepped but never reset or finalized never reports
+// back; beyond this many open starts the oldest are dropped.
+constexpr std::size_t kMaxRunningPerThread = 32;
+
+struct Entry {
+    std::string sql;
+    uint64_t count = 0;
+    uint64_t total_us = 0;
+    uint64_t max_us = 0;
+    uint64_t fullscan_steps = 0;
+    uint64_t sorts = 0;
+    uint64_t autoindexes = 0;
+    uint64_t vm_steps = 0;
+    uint64_t latency[kLatencyBuckets] = {};
+};
+
+struct Shard {
+    std::mutex mutex;
+    // Keyed by the statement's original text: the same literal always maps
+    // to the same entry, whatever values are bound to it.
+    std::unordered_map<std::string, Entry> entries;
+};
+
+Shard g_shards[kShards];
+
+// SQLite's own profile time comes from the VFS clock, which is usually only
+// millisecond-accurate; statements are timed from SQLITE_TRACE_STMT instead.
+// Each connection is used by one thread at a time, and only a handful of
+// statements are ever active on it at once.
+thread_local std::vector<std::pair<sqlite3_stmt*, std::chrono::steady_clock::time_point>> t_running;
+
+long long slowQueryThresholdMicros() {
+    static const long long threshold = [] {
+        const char* env = std::getenv("SLOW_QUERY_MS");
+        const long long ms = env ? std::atoll(env) : kDefaultSlowQueryMillis;
+        return ms * 1000;
+    }();
+    return threshold;
+}
+
+std::string collapseWhitespace(std::string_view sql) {
+    std::string out;
+    out.reserve(sql.size());
+    bool space = false;
+    for (char c : sql) {
+        if (std::isspace(static_cast<unsigned char>(c))) {
+            space = !out.empty();
+            continue;
+        }
+        if (space) {
+            out += ' ';
+            space = false;
+        }
+        out += c;
+    }
+    return out;
+}
+
+uint64_t elapsedMicros(sqlite3_stmt* stmt, sqlite3_int64 sqlite_ns) {
+    for (auto it = t_running.begin(); it != t_running.end(); ++it) {
+        if (it->first == stmt) {
+            const auto elapsed = std::chrono::steady_clock::now() - it->second;
+            t_running.erase(it);
+            return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(elapsed).count());
+        }
+    }
+    return static_cast<uint64_t>(sqlite_ns) / 1000;
+}
+
+int traceCallback(unsigned type, void*, void* p, void* x) {
+    sqlite3_stmt* stmt = static_cast<sqlite3_stmt*>(p);
+    if (type == SQLITE_TRACE_STMT) {
+        // Also fires for each trigger program; only the first start counts.
+        for (const auto& running : t_running) {
+            if (running.first == stmt) {
+                return 0;
+            }
+        }
+        if (t_running.size() >= kMaxRunningPerThread) {
+            t_running.erase(t_running.begin());
+        }
+        t_running.emplace_back(stmt, std::chrono::steady_clock::now());
+        return 0;
+    }
+
+    const uint64_t us = elapsedMicros(stmt, *static_cast<sqlite3_int64*>(x));
+    const char* sql = sqlite3_sql(stmt);
+    if (!sql) {
+        return 0;
+    }
+
+    // Reset so every profile event sees only its own run.
+    const uint64_t fullscan = sqlite3_stmt_status(stmt, SQLITE_STMTSTATUS_FULLSCAN_STEP, 1);
+    const uint64_t sorts = sqlite3_stmt_status(stmt, SQLITE_STMTSTATUS_SORT, 1);
+    const uint64_t autoindexes = sqlite3_stmt_status(stmt, SQLITE_STMTSTATUS_AUTOINDEX, 1);
+    const uint64_t vm_steps = sqlite3_stmt_status(stmt, SQLITE_STMTSTATUS_VM_STEP, 1);
+
+    const std::string_view text(sql);
+    Shard& shard = g_shards[std::hash<std::string_view>()(text) % kShards];
+    {
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        auto it = shard.entries.find(std::string(text));
+        if (it == shard.entries.end()) {
+            it = shard.entries.emplace(std::string(text), Entry()).first;
+            it->second.sql = collapseWhitespace(text);
+        }
+        Entry& entry = it->second;
+        ++entry.count;
+        entry.total_us += us;
+        entry.max_us = std::max(entry.max_us, us);
+        entry.fullscan_steps += fullscan;
+        entry.sorts += sorts;
+        entry.autoindexes += autoindexes;
+        entry.vm_steps += vm_steps;
+        ++entry.latency[latencyBucket(us)];
+    }
+
+    if (static_cast<long long>(us) >= slowQueryThresholdMicros()) {
+        // Template text only: bound values may be patient details.
+        LOG_WARN("Slow query", "ms", us / 1000.0, "vm_steps", vm_steps, "fullscan_steps", fullscan,
+                 "sorts", sorts, "autoindex", autoindexes, "sql", collapseWhitespace(text));
+    }
+    return 0;
+}
+
+} // namespace
+
+void installStatementStats(sqlite3* db) {
+    sqlite3_trace_v2(db, SQLITE_TRACE_STMT | SQLITE_TRACE_PROFILE, traceCallback, nullptr);
+}
+
+std::vector<StatementStats> statementStats() {
+    std::vector<StatementStats> out;
+    for (Shard& shard : g_shards) {
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        for (const auto& [text, e] : shard.entries) {
+            out.push_back({e.sql, e.count, e.total_us, e.max_us, latencyQuantile(e.latency, 0.99),
+                           e.fullscan_steps, e.sorts, e.autoindexes, e.vm_steps});
+        }
+    }
+    std::sort(out.begin(), out.end(),
+              [](const StatementStats& a, const StatementStats& b) { return a.total_us > b.total_us; });
+    return out;
+}
@@ -0,0 +1,28 @@
+#pragma once
+
+#include <sqlite3.h>
+
+#include <string>
+#include <vector>
+
+// Hooks SQLITE_TRACE_STMT / SQLITE_TRACE_PROFILE on `db`. Every statement
+// that finishes on the connection is folded into a registry keyed by its SQL
+// text, together with its sqlite3_stmt_status() counters. Statements slower
+// than SLOW_QUERY_MS (default 200; time includes waiting on locks) are logged
+// as "Slow query" warnings.
+void installStatementStats(sqlite3* db);
+
+struct StatementStats {
+    std::string sql; // whitespace collapsed
+    unsigned long long count;
+    unsigned long long total_us;
+    unsigned long long max_us;
+    unsigned long long p99_us;
+    unsigned long long fullscan_steps; // rows stepped through full table scans
+    unsigned long long sorts;
+    unsigned long long autoindexes; // rows inserted into automatic indexes
+    unsigned long long vm_steps;
+};
+
+// Snapshot of every statement seen so far, largest total time first.
+std::vector<StatementStats> statementStats();
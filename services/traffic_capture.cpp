@@ -0,0 +1,274 @@
+#include "traffic_capture.h"
+
+#include "capture_format.h"
+#include "logger.h"
+
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+#include <random>
+#include <string>
+
+namespace {
+
+// Headers worth replaying; everything else (User-Agent, Host, ...) is noise.
+const char* const kCapturedHeaders[] = {
+    "Content-Type", "Accept-Encoding", "If-None-Match", "Cookie", "Authorization",
+};
+
+std::atomic<bool> g_capture_on{false};
+std::atomic<unsigned long long> g_captured{0};
+std::mutex g_capture_mutex;
+FILE* g_capture_file = nullptr;
+unsigned long long g_capture_bytes = 0;
+unsigned long long g_capture_limit = 0;
+std::chrono::steady_clock::time_point g_last_record;
+uint64_t g_salt = 0;
+
+// Salted FNV-1a, so the same token maps to the same pseudonym for the whole
+// capture but cannot be looked up afterwards.
+std::string pseudonym(const std::string& value) {
+    uint64_t h = 1469598103934665603ULL ^ g_salt;
+    for (unsigned char c : value) {
+        h ^= c;
+        h *= 1099511628211ULL;
+    }
+    char buf[17];
+    std::snprintf(buf, sizeof(buf), "%016llx", static_cast<unsigned long long>(h));
+    return buf;
+}
+
+// Numeric ids get a positive int pseudonym, so a replayed body still parses.
+int numericPseudonym(int64_t value) {
+    const std::string hashed = pseudonym(std::to_string(value));
+    return static_cast<int>(std::strtoull(hashed.c_str(), nullptr, 16) % 2147483647ULL) + 1;
+}
+
+bool parseWholeNumber(const std::string& text, int64_t& out) {
+    if (text.empty()) {
+        return false;
+    }
+    char* end = nullptr;
+    errno = 0;
+    const long long parsed = std::strtoll(text.c_str(), &end, 10);
+    if (*end != '\0' || errno == ERANGE) {
+        return false;
+    }
+    out = parsed;
+    return true;
+}
+
+// "a=1; b=2" -> "a=<pseudonym>; b=<pseudonym>"
+std::string pseudonymizeCookies(const std::string& header) {
+    std::string out;
+    std::size_t start = 0;
+    while (start < header.size()) {
+        std::size_t end = header.find(';', start);
+        if (end == std::string::npos) {
+            end = header.size();
+        }
+        const std::size_t eq = header.find('=', start);
+        if (!out.empty()) {
+            out += "; ";
+        }
+        std::size_t name_start = start;
+        while (name_start < end && header[name_start] == ' ') {
+            ++name_start;
+        }
+        if (eq != std::string::npos && eq < end) {
+            out.append(header, name_start, eq + 1 - name_start);
+            out += pseudonym(header.substr(eq + 1, end - eq - 1));
+        } else {
+            out.append(header, name_start, end - name_start);
+        }
+        start = end + 1;
+    }
+    return out;
+}
+
+std::string pseudonymizeAuthorization(const std::string& header) {
+    const std::string prefix = "Bearer ";
+    if (header.rfind(prefix, 0) == 0) {
+        return prefix + pseudonym(header.substr(prefix.size()));
+    }
+    return pseudonym(header);
+}
+
+// The doctor dashboard accepts its token in the query string.
+std::string pseudonymizeUrl(const std::string& url) {
+    const std::size_t query = url.find('?');
+    if (query == std::string::npos) {
+        return url;
+    }
+    std::string out = url.substr(0, query + 1);
+    std::size_t start = query + 1;
+    while (start <= url.size()) {
+        std::size_t end = url.find('&', start);
+        if (end == std::string::npos) {
+            end = url.size();
+        }
+        if (url.compare(start, 6, "token=") == 0) {
+            out += "token=" + pseudonym(url.substr(start + 6, end - start - 6));
+        } else {
+            out.append(url, start, end - start);
+        }
+        if (end < url.size()) {
+            out += '&';
+        }
+        start = end + 1;
+    }
+    return out;
+}
+
+// Overwrites personal fields in a JSON object body. Non-JSON bodies are
+// dropped rather than risk writing something unredacted.
+std::string redactBody(const std::string& body) {
+    if (body.empty()) {
+        return body;
+    }
+    auto parsed = crow::json::load(body);
+    if (!parsed || parsed.t() != crow::json::type::Object) {
+        return "";
+    }
+    crow::json::wvalue redacted(parsed);
+    if (parsed.has("name")) {
+        redacted["name"] = "Redacted";
+    }
+    if (parsed.has("email")) {
+        redacted["email"] = "redacted@example.com";
+    }
+    if (parsed.has("phone")) {
+        redacted["phone"] = "00000000000";
+    }
+    if (parsed.has("age")) {
+        redacted["age"] = 30;
+    }
+    if (parsed.has("gender")) {
+        redacted["gender"] = "Redacted";
+    }
+    if (parsed.has("request")) {
+        redacted["request"] = "";
+    }
+    if (parsed.has("patient_id")) {
+        const crow::json::rvalue& id = parsed["patient_id"];
+        int64_t number = 0;
+        if (id.t() == crow::json::type::Number) {
+            redacted["patient_id"] = numericPseudonym(id.i());
+        } else if (id.t() == crow::json::type::String && parseWholeNumber(std::string(id.s()), number)) {
+            // The DTO parser accepts "42" as well as 42; keep it a numeric string.
+            redacted["patient_id"] = std::to_string(numericPseudonym(number));
+        } else {
+            redacted["patient_id"] = nullptr;
+        }
+    }
+    if (parsed.has("token") && parsed["token"].t() == crow::json::type::String) {
+        redacted["token"] = pseudonym(std::string(parsed["token"].s()));
+    }
+    return redacted.dump();
+}
+
+bool skipped(const std::string& url) {
+    return url.rfind("/admin", 0) == 0 || url.rfind("/metrics", 0) == 0;
+}
+
+} // namespace
+
+bool startTrafficCapture() {
+    const char* path = std::getenv("TRAFFIC_CAPTURE");
+    if (!path || !*path) {
+        return true;
+    }
+
+    const char* max_mb_env = std::getenv("TRAFFIC_CAPTURE_MAX_MB");
+    const long max_mb = max_mb_env ? std::atol(max_mb_env) : 512;
+
+    std::lock_guard<std::mutex> lock(g_capture_mutex);
+    g_capture_file = std::fopen(path, "wb");
+    if (!g_capture_file) {
+        LOG_ERROR("Failed to open traffic capture file", "path", path);
+        return false;
+    }
+    std::setvbuf(g_capture_file, nullptr, _IOFBF, 1 << 20);
+    std::fwrite(kCaptureMagic, 1, kCaptureMagicSize, g_capture_file);
+
+    g_capture_bytes = kCaptureMagicSize;
+    g_capture_limit = static_cast<unsigned long long>(max_mb > 0 ? max_mb : 512) << 20;
+    g_salt = (static_cast<uint64_t>(std::random_device{}()) << 32) ^ std::random_device{}();
+    g_last_record = std::chrono::steady_clock::now();
+    g_capture_on.store(true, std::memory_order_release);
+    LOG_INFO("Capturing traffic", "path", path, "max_mb", max_mb > 0 ? max_mb : 512);
+    return true;
+}
+
+void stopTrafficCapture() {
+    std::lock_guard<std::mutex> lock(g_capture_mutex);
+    g_capture_on.store(false, std::memory_order_relaxed);
+    if (g_capture_file) {
+        std::fclose(g_capture_file);
+        g_capture_file = nullptr;
+        LOG_INFO("Traffic capture closed", "requests", g_captured.load(std::memory_order_relaxed),
+                 "bytes", g_capture_bytes);
+    }
+}
+
+void captureRequest(const crow::request& req) {
+    if (!g_capture_on.load(std::memory_order_relaxed) || skipped(req.raw_url)) {
+        return;
+    }
+
+    // Everything but the timestamp is encoded outside the lock.
+    std::string record;
+    appendCaptureString(record, crow::method_name(req.method));
+    appendCaptureString(record, pseudonymizeUrl(req.raw_url));
+
+    std::string headers;
+    unsigned header_count = 0;
+    for (const char* name : kCapturedHeaders) {
+        std::string value = req.get_header_value(name);
+        if (value.empty()) {
+            continue;
+        }
+        if (std::strcmp(name, "Cookie") == 0) {
+            value = pseudonymizeCookies(value);
+        } else if (std::strcmp(name, "Authorization") == 0) {
+            value = pseudonymizeAuthorization(value);
+        }
+        appendCaptureString(headers, name);
+        appendCaptureString(headers, value);
+        ++header_count;
+    }
+    appendVarint(record, header_count);
+    record += headers;
+    appendCaptureString(record, redactBody(req.body));
+
+    std::lock_guard<std::mutex> lock(g_capture_mutex);
+    if (!g_capture_file) {
+        return;
+    }
+    const auto now = std::chrono::steady_clock::now();
+    std::string delta;
+    appendVarint(delta, static_cast<uint64_t>(
+                            std::chrono::duration_cast<std::chrono::microseconds>(now - g_last_record).count()));
+    g_last_record = now;
+
+    if (g_capture_bytes + delta.size() + record.size() > g_capture_limit) {
+        g_capture_on.store(false, std::memory_order_relaxed);
+        std::fclose(g_capture_file);
+        g_capture_file = nullptr;
+        LOG_WARN("Traffic capture size limit reached", "requests", g_captured.load(std::memory_order_relaxed),
+                 "bytes", g_capture_bytes);
+        return;
+    }
+    std::fwrite(delta.data(), 1, delta.size(), g_capture_file);
+    std::fwrite(record.data(), 1, record.size(), g_capture_file);
+    g_capture_bytes += delta.size() + record.size();
+    g_captured.fetch_add(1, std::memory_order_relaxed);
+}
+
+unsigned long long capturedRequests() {
+    return g_captured.load(std::memory_order_relaxed);
+}
@@ -0,0 +1,27 @@
+#pragma once
+
+#include <crow.h>
+
+// Opt-in request capture for replay testing (tools/replay). With
+// TRAFFIC_CAPTURE=<file> set, every API request that reaches a handler is
+// appended to <file> (format in capture_format.h): method, URL, relative
+// arrival time, a handful of headers and the body. Personal data never
+// reaches the file: cookie, bearer and ?token= values are replaced by salted
+// pseudonyms (stable within one capture, so replay can tell clients apart);
+// in JSON bodies the name, email, phone, age, gender and request fields are
+// overwritten and token and patient_id are pseudonymized the same way.
+// Requests answered before dispatch (static files, a route's own rate limit
+// or session check) are not captured. Capture stops once the file reaches
+// TRAFFIC_CAPTURE_MAX_MB (default 512).
+
+// Opens the capture file when TRAFFIC_CAPTURE is set. False when it is set
+// but cannot be opened.
+bool startTrafficCapture();
+
+// Flushes and closes the capture file.
+void stopTrafficCapture();
+
+// Records `req` if capture is on; a relaxed load otherwise.
+void captureRequest(const crow::request& req);
+
+unsigned long long capturedRequests();
@@ -0,0 +1,409 @@
+// Microbenchmarks for the hot helpers behind the public booking flow: model
+// queries, session validation, cookie parsing, token generation and JSON
+// building.
+//
+// Every benchmark is warmed up, calibrated so one repetition runs for at
+// least --min-ms, then repeated --reps times; the table shows ns per
+// operation. --json writes the same numbers for keeping next to a commit,
+// and --baseline compares this run's medians against such a file.
+//
+//   bench --json before.json
+//   (change something, rebuild)
+//   bench --baseline before.json --filter session
+//
+// DB benchmarks use a scratch database (--db, deleted first) with the
+// server's pragmas and schema.
+
+#include "tool_support.h"
+#include "schema.h"
+
+#include "../models/appointment.h"
+#include "../models/doctor.h"
+#include "../models/schedule.h"
+#include "../services/json_writer.h"
+#include "../services/public_session.h"
+#include "../services/session_tokens.h"
+#include "../services/sql_statements.h"
+
+#include <crow.h>
+#include <sqlite3.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <functional>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace {
+
+// Keeps the compiler from discarding a result it can prove unused.
+template <typename T>
+void keep(const T& value) {
+#if defined(__GNUC__)
+    asm volatile("" : : "g"(&value) : "memory");
+#else
+    static volatile const void* sink;
+    sink = &value;
+#endif
+}
+
+struct BenchOptions {
+    int reps = 10;
+    double min_ms = 20.0;
+    double warmup_ms = 50.0;
+    std::string filter;
+    std::string json_path;
+    std::string baseline_path;
+    std::string label;
+    std::string db_path = "bench.db";
+};
+
+struct BenchResult {
+    std::string name;
+    uint64_t ops_per_rep = 0;
+    double min_ns = 0;
+    double median_ns = 0;
+    double mean_ns = 0;
+    double stddev_ns = 0;
+};
+
+class BenchRunner {
+public:
+    explicit BenchRunner(const BenchOptions& options) : options_(options) {}
+
+    // `op(i)` is one operation; i counts up across warmup and repetitions so
+    // writes can use fresh keys.
+    void run(const std::string& name, const std::function<void(uint64_t)>& op) {
+        if (!options_.filter.empty() && name.find(options_.filter) == std::string::npos) {
+            return;
+        }
+
+        // Warmup doubles the batch until one batch takes --min-ms.
+        uint64_t batch = 1;
+        const auto warmup_end =
+            std::chrono::steady_clock::now() + std::chrono::duration<double, std::milli>(options_.warmup_ms);
+        for (;;) {
+            const double ms = timeBatch(op, batch) / 1e6;
+            if (ms >= options_.min_ms && std::chrono::steady_clock::now() >= warmup_end) {
+                break;
+            }
+            if (ms < options_.min_ms) {
+                batch *= 2;
+            }
+        }
+
+        std::vector<double> per_op;
+        for (int r = 0; r < options_.reps; ++r) {
+            per_op.push_back(timeBatch(op, batch) / static_cast<double>(batch));
+        }
+        std::sort(per_op.begin(), per_op.end());
+
+        BenchResult result;
+        result.name = name;
+        result.ops_per_rep = batch;
+        result.min_ns = per_op.front();
+        result.median_ns = per_op[per_op.size() / 2];
+        double sum = 0;
+        for (double v : per_op) {
+            sum += v;
+        }
+        result.mean_ns = sum / static_cast<double>(per_op.size());
+        double sq = 0;
+        for (double v : per_op) {
+            sq += (v - result.mean_ns) * (v - result.mean_ns);
+        }
+        result.stddev_ns = std::sqrt(sq / static_cast<double>(per_op.size()));
+
+        std::printf("%-48s %12llu %12.1f %12.1f %12.1f %8.1f%%\n", name.c_str(),
+                    static_cast<unsigned long long>(batch), result.min_ns, result.median_ns, result.mean_ns,
+                    result.mean_ns > 0 ? 100.0 * result.stddev_ns / result.mean_ns : 0.0);
+        std::fflush(stdout);
+        results_.push_back(result);
+    }
+
+    const std::vector<BenchResult>& results() const { return results_; }
+
+private:
+    double timeBatch(const std::function<void(uint64_t)>& op, uint64_t batch) {
+        const auto start = std::chrono::steady_clock::now();
+        for (uint64_t i = 0; i < batch; ++i) {
+            op(next_++);
+        }
+        return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    const BenchOptions& options_;
+    std::vector<BenchResult> results_;
+    uint64_t next_ = 0;
+};
+
+// --------------------------------------------------
+// Session / cookie / token helpers
+// --------------------------------------------------
+void benchTokens(BenchRunner& runner) {
+    runner.run("tokens/generateToken", [](uint64_t) { keep(generateToken()); });
+
+    const std::string cookie = "theme=dark; public_token=" + generateToken() + "; category_token=" +
+                               generateToken() + "; schedule_token=" + generateToken() +
+                               "; booking_token=" + generateToken();
+    runner.run("cookies/cookieValue first of 5", [&](uint64_t) { keep(cookieValue(cookie, "theme")); });
+    runner.run("cookies/cookieValue last of 5", [&](uint64_t) { keep(cookieValue(cookie, "booking_token")); });
+    runner.run("cookies/cookieValue missing", [&](uint64_t) { keep(cookieValue(cookie, "confirmation_token")); });
+
+    crow::request req;
+    req.headers.emplace("Cookie", cookie);
+    runner.run("cookies/bearerOrCookieToken", [&](uint64_t) { keep(bearerOrCookieToken(req, "booking_token")); });
+}
+
+// publicSessionValid() for a known token while the session map holds
+// `sessions` entries.
+void benchPublicSessions(BenchRunner& runner) {
+    std::string token;
+    for (std::size_t sessions : {std::size_t{10}, std::size_t{1000}, std::size_t{100000}}) {
+        while (publicSessionCount() < sessions) {
+            crow::response res;
+            issuePublicSession(res);
+            if (token.empty()) {
+                token = cookieValue(res.get_header_value("Set-Cookie"), "public_token");
+            }
+        }
+        crow::request req;
+        req.headers.emplace("Cookie", "public_token=" + token);
+        crow::request unknown;
+        unknown.headers.emplace("Cookie", "public_token=" + generateToken());
+
+        const std::string size = std::to_string(sessions);
+        runner.run("session/publicSessionValid hit, " + size + " sessions",
+                   [&](uint64_t) { keep(publicSessionValid(req)); });
+        runner.run("session/publicSessionValid miss, " + size + " sessions",
+                   [&](uint64_t) { keep(publicSessionValid(unknown)); });
+    }
+}
+
+// --------------------------------------------------
+// JSON: the slot list GET /get_slots_status builds and serializes
+// --------------------------------------------------
+void benchJson(BenchRunner& runner) {
+    for (int slots : {16, 48}) {
+        std::vector<std::string> times;
+        for (int i = 0; i < slots; ++i) {
+            char buf[16];
+            std::snprintf(buf, sizeof(buf), "%02d:%02d", 8 + i * 15 / 60, i * 15 % 60);
+            times.push_back(buf);
+        }
+        runner.run("json/slot list wvalue + dump, " + std::to_string(slots) + " slots", [&](uint64_t) {
+            crow::json::wvalue result;
+            for (int i = 0; i < slots; ++i) {
+                result[i]["schedule_id"] = i + 1;
+                result[i]["time_slot"] = times[static_cast<std::size_t>(i)];
+                result[i]["status"] = std::string(i % 4 ? "AVAILABLE" : "BOOKED");
+            }
+            keep(result.dump());
+        });
+        runner.run("json/slot list JsonWriter, " + std::to_string(slots) + " slots", [&](uint64_t) {
+            JsonWriter out(64 * static_cast<std::size_t>(slots) + 2);
+            out.beginArray();
+            for (int i = 0; i < slots; ++i) {
+                out.beginObject()
+                    .key("schedule_id").value(i + 1)
+                    .key("time_slot").value(times[static_cast<std::size_t>(i)])
+                    .key("status").value(i % 4 ? "AVAILABLE" : "BOOKED")
+                    .endObject();
+            }
+            out.endArray();
+            keep(out.take());
+        });
+    }
+}
+
+// --------------------------------------------------
+// Models against a scratch database
+// --------------------------------------------------
+constexpr int kCategories = 10;
+constexpr int kDoctorsPerCategory = 20;
+constexpr int kSlots = 16;
+
+bool exec(sqlite3* db, const std::string& sql) {
+    char* err = nullptr;
+    if (sqlite3_exec(db, sql.c_str(), nullptr, nullptr, &err) != SQLITE_OK) {
+        std::fprintf(stderr, "%s: %s\n", sql.c_str(), err ? err : "");
+        sqlite3_free(err);
+        return false;
+    }
+    return true;
+}
+
+sqlite3* openScratchDb(const std::string& path) {
+    for (const char* suffix : {"", "-wal", "-shm"}) {
+        std::remove((path + suffix).c_str());
+    }
+    sqlite3* db = nullptr;
+    if (sqlite3_open(path.c_str(), &db) != SQLITE_OK) {
+        std::fprintf(stderr, "Cannot open %s: %s\n", path.c_str(), sqlite3_errmsg(db));
+        sqlite3_close(db);
+        return nullptr;
+    }
+    // Same pragmas as openDatabase().
+    if (!exec(db, "PRAGMA journal_mode=WAL; PRAGMA synchronous=NORMAL; PRAGMA foreign_keys=ON;") ||
+        !createSchema(db)) {
+        sqlite3_close(db);
+        return nullptr;
+    }
+
+    std::ostringstream seed;
+    seed << "BEGIN;";
+    for (int c = 1; c <= kCategories; ++c) {
+        seed << "INSERT INTO Category(category_name, description) VALUES ('Category " << c << "', 'Bench');";
+        for (int d = 0; d < kDoctorsPerCategory; ++d) {
+            seed << "INSERT INTO Doctor(doctor_name, phone, experience_years, qualification, ratings, category_id) "
+                 << "VALUES ('Dr Bench " << c << "-" << d << "', '0300', '10', 'MBBS', 4.5, " << c << ");";
+        }
+    }
+    for (int s = 0; s < kSlots; ++s) {
+        char slot[16];
+        std::snprintf(slot, sizeof(slot), "%02d:%02d", 9 + s / 2, s % 2 * 30);
+        seed << "INSERT INTO Doctor_Schedule(time_slot) VALUES ('" << slot << "');";
+    }
+    seed << "INSERT INTO Patient(patient_id, name, age, email, gender, request) "
+         << "VALUES (1, 'Bench Patient', 30, 'bench@example.com', 'Female', '');";
+    // Doctor 1 on 2030-01-01: a quarter of the day booked, two slots blocked.
+    for (int s = 1; s <= kSlots; s += 4) {
+        seed << "INSERT INTO Appointment(appointment_id, patient_id, doctor_id, schedule_id, appointment_date) "
+             << "VALUES (" << s << ", 1, 1, " << s << ", '2030-01-01');";
+    }
+    seed << "INSERT INTO Doctor_Blocked_Slots(doctor_id, schedule_id, appointment_date) VALUES (1, 2, '2030-01-01');"
+         << "INSERT INTO Doctor_Blocked_Slots(doctor_id, schedule_id, appointment_date) VALUES (1, 3, '2030-01-01');"
+         << "COMMIT;";
+    // The models run registry statements, prepared as openDatabase() does.
+    if (!exec(db, seed.str()) || !prepareStatements(db)) {
+        sqlite3_close(db);
+        return nullptr;
+    }
+    return db;
+}
+
+void benchModels(BenchRunner& runner, const BenchOptions& options) {
+    sqlite3* db = openScratchDb(options.db_path);
+    if (!db) {
+        return;
+    }
+
+    const int doctors = kCategories * kDoctorsPerCategory;
+    runner.run("db/Doctor::fetchByCategory (20 rows)",
+               [&](uint64_t i) { keep(Doctor::fetchByCategory(db, 1 + static_cast<int>(i % kCategories))); });
+    runner.run("db/DoctorSchedule::fetchAvailableSlots (16 slots)",
+               [&](uint64_t) { keep(DoctorSchedule::fetchAvailableSlots(db, 1, "2030-01-01")); });
+
+    // Every insert is a fresh (doctor, slot, date); autocommit, as in the
+    // booking route.
+    std::vector<std::string> dates;
+    for (int day = 0; day < 3650; ++day) {
+        dates.push_back(localDatePlusDays(day + 3650));
+    }
+    runner.run("db/Appointment::insert", [&](uint64_t i) {
+        const uint64_t key = i;
+        const int doctor = 1 + static_cast<int>(key % doctors);
+        const int slot = 1 + static_cast<int>(key / doctors % kSlots);
+        const std::string& date = dates[key / (static_cast<uint64_t>(doctors) * kSlots) % dates.size()];
+        keep(Appointment::insert(db, static_cast<int>(1000 + i), 1, doctor, slot, date));
+    });
+
+    finalizeStatements(db);
+    sqlite3_close(db);
+    for (const char* suffix : {"", "-wal", "-shm"}) {
+        std::remove((options.db_path + suffix).c_str());
+    }
+}
+
+// --------------------------------------------------
+// Output
+// --------------------------------------------------
+bool writeJson(const BenchOptions& options, const std::vector<BenchResult>& results) {
+    std::ofstream out(options.json_path);
+    if (!out) {
+        std::fprintf(stderr, "Cannot write %s\n", options.json_path.c_str());
+        return false;
+    }
+    out << "{\n  \"label\": \"" << jsonEscape(options.label) << "\",\n  \"reps\": " << options.reps
+        << ",\n  \"benchmarks\": [\n";
+    for (std::size_t i = 0; i < results.size(); ++i) {
+        const BenchResult& r = results[i];
+        out << "    {\"name\": \"" << jsonEscape(r.name) << "\", \"ops_per_rep\": " << r.ops_per_rep
+            << ", \"min_ns\": " << r.min_ns << ", \"median_ns\": " << r.median_ns << ", \"mean_ns\": " << r.mean_ns
+            << ", \"stddev_ns\": " << r.stddev_ns << "}" << (i + 1 < results.size() ? "," : "") << "\n";
+    }
+    out << "  ]\n}\n";
+    return true;
+}
+
+// Median change against a file written by --json.
+bool compareBaseline(const BenchOptions& options, const std::vector<BenchResult>& results) {
+    std::ifstream in(options.baseline_path);
+    std::stringstream text;
+    text << in.rdbuf();
+    const std::string body = text.str();
+    const std::size_t list = body.find('[');
+    std::vector<JsonFields> baseline;
+    if (!in || list == std::string::npos || !parseJsonArray(body.substr(list), baseline)) {
+        std::fprintf(stderr, "Cannot read baseline %s\n", options.baseline_path.c_str());
+        return false;
+    }
+
+    std::printf("\n%-48s %12s %12s %9s\n", "vs baseline", "before ns", "after ns", "change");
+    for (const BenchResult& r : results) {
+        for (JsonFields& old : baseline) {
+            if (old["name"] != r.name) {
+                continue;
+            }
+            const double before = std::strtod(old["median_ns"].c_str(), nullptr);
+            std::printf("%-48s %12.1f %12.1f %+8.1f%%\n", r.name.c_str(), before, r.median_ns,
+                        before > 0 ? 100.0 * (r.median_ns - before) / before : 0.0);
+        }
+    }
+    return true;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    const ToolArgs args(argc, argv);
+    if (args.has("--help")) {
+        std::printf("usage: bench [--filter TEXT] [--reps N] [--min-ms MS] [--warmup-ms MS]\n"
+                    "             [--json OUT.json] [--label TEXT] [--baseline OLD.json] [--db PATH]\n");
+        return 0;
+    }
+
+    BenchOptions options;
+    options.reps = std::max(1, static_cast<int>(args.getInt("--reps", options.reps)));
+    options.min_ms = args.getDouble("--min-ms", options.min_ms);
+    options.warmup_ms = args.getDouble("--warmup-ms", options.warmup_ms);
+    options.filter = args.get("--filter", "");
+    options.json_path = args.get("--json", "");
+    options.baseline_path = args.get("--baseline", "");
+    options.label = args.get("--label", "");
+    options.db_path = args.get("--db", options.db_path);
+
+    // Model code logs failures; keep the table readable.
+    setLogLevel(LogLevel::Error);
+
+    std::printf("%-48s %12s %12s %12s %12s %9s\n", "benchmark", "ops/rep", "min ns", "median ns", "mean ns",
+                "stddev");
+    BenchRunner runner(options);
+    benchTokens(runner);
+    benchPublicSessions(runner);
+    benchJson(runner);
+    benchModels(runner, options);
+
+    bool ok = true;
+    if (!options.json_path.empty()) {
+        ok = writeJson(options, runner.results()) && ok;
+    }
+    if (!options.baseline_path.empty()) {
+        ok = compareBaseline(options, runner.results()) && ok;
+    }
+    return ok ? 0 : 1;
+}
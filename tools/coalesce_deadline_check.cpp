@@ -0,0 +1,117 @@
+// Coalesced reads that expire in the DB queue must still answer everyone.
+//
+// One executor worker is held by a slow write while a coalesced read and a
+// request joining it wait past the read's deadline. The leader's work never
+// runs; both must be answered 504, and the key must be free again, so the
+// next request for it runs a fresh computation instead of joining a flight
+// nobody will land.
+//
+//   coalesce_deadline_check [--db PATH]
+//
+// --db is a scratch file (default coalesce_check.db), created and removed.
+
+#include "tool_support.h"
+#include "schema.h"
+#include "../services/admission.h"
+#include "../services/db_executor.h"
+#include "../services/logger.h"
+#include "../services/single_flight.h"
+#include <crow.h>
+#include <sqlite3.h>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <future>
+#include <string>
+#include <thread>
+
+namespace {
+
+constexpr int kReadDeadlineMs = 100;
+constexpr int kBlockerMs = 300;
+
+bool createScratchDb(const std::string& path) {
+    for (const char* suffix : {"", "-wal", "-shm"}) {
+        std::remove((path + suffix).c_str());
+    }
+    sqlite3* db = nullptr;
+    if (sqlite3_open(path.c_str(), &db) != SQLITE_OK) {
+        std::fprintf(stderr, "Cannot open %s: %s\n", path.c_str(), sqlite3_errmsg(db));
+        sqlite3_close(db);
+        return false;
+    }
+    const bool ok = createSchema(db);
+    sqlite3_close(db);
+    return ok;
+}
+
+// Waits until every read queued so far has been answered: reads are taken in
+// order, so a no-op read queued now is answered after them.
+void waitForQueuedReads(const crow::request& req, const RouteTag& tag) {
+    crow::response res;
+    std::promise<void> answered;
+    submitDbWork(req, res, tag, [](const crow::request&, sqlite3*) { return crow::response(200); },
+                 /*cancel_on_disconnect=*/false, [&answered](const crow::response&) { answered.set_value(); });
+    answered.get_future().wait();
+}
+
+bool expect(bool ok, const char* what) {
+    std::printf("%-60s %s\n", what, ok ? "ok" : "FAILED");
+    return ok;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    const ToolArgs args(argc, argv);
+    if (args.has("--help")) {
+        std::printf("usage: coalesce_deadline_check [--db PATH]\n");
+        return 0;
+    }
+    const std::string db_path = args.get("--db", "coalesce_check.db");
+
+    setLogLevel(LogLevel::Error);
+    if (!createScratchDb(db_path) || !startDbExecutor(db_path, 1)) {
+        return 1;
+    }
+
+    const RouteTag blocker = routeTag("check/blocker", RouteClass::WriteApi, RoutePriority::Normal, 0);
+    const RouteTag read = routeTag("check/read", RouteClass::ReadApi, RoutePriority::Normal, kReadDeadlineMs);
+    const RouteTag sync = routeTag("check/sync", RouteClass::ReadApi, RoutePriority::Normal, 0);
+    const std::string key = "check/slots/1/2030-01-01";
+
+    std::atomic<int> runs{0};
+    auto counted = [&runs](const crow::request&, sqlite3*) {
+        runs.fetch_add(1);
+        return crow::response(200, "fresh");
+    };
+
+    const crow::request req{};
+    crow::response blocker_res;
+    crow::response leader;
+    crow::response follower;
+    submitDbWork(req, blocker_res, blocker, [](const crow::request&, sqlite3*) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(kBlockerMs));
+        return crow::response(200);
+    });
+    respondFromDbCoalesced(req, leader, read, key, counted);
+    respondFromDbCoalesced(req, follower, read, key, counted);
+    waitForQueuedReads(req, sync);
+
+    bool ok = true;
+    ok = expect(runs.load() == 0, "expired leader work is skipped") && ok;
+    ok = expect(leader.code == 504, "leader answered 504") && ok;
+    ok = expect(follower.code == 504, "follower answered 504") && ok;
+
+    crow::response later;
+    respondFromDbCoalesced(req, later, read, key, counted);
+    waitForQueuedReads(req, sync);
+    ok = expect(runs.load() == 1 && later.code == 200 && later.body == "fresh",
+                "next request for the key runs a fresh computation") && ok;
+
+    stopDbExecutor();
+    for (const char* suffix : {"", "-wal", "-shm"}) {
+        std::remove((db_path + suffix).c_str());
+    }
+    return ok ? 0 : 1;
+}
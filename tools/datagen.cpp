@@ -0,0 +1,417 @@
+// Synthetic data generator: creates the schema and bulk-loads a database at
+// production-like scale, so slot queries, booking checks and caches can be
+// measured locally against realistic volumes.
+//
+//   datagen --db ../db/scale.db --doctors 2000 --patients 500000 --appointments 3000000
+//
+// Volumes and shape:
+//   - categories and doctors, with Zipf-skewed category sizes and doctor
+//     popularity (a few doctors carry most of the bookings);
+//   - the slot catalogue (--day-start .. --day-end every --slot-minutes);
+//   - patients, one per historic appointment until --patients is reached;
+//   - appointments spread over --days-back in the past and --days-ahead in
+//     the future, denser towards today, with a realistic status mix (past
+//     ones mostly kept, a share Cancelled; future ones mostly BOOKED);
+//   - blocked slots on future days that are not booked.
+//
+// Rows go in through prepared statements in transactions of --batch rows,
+// with journaling relaxed during the load; the file is switched to WAL and
+// ANALYZEd at the end, as the server expects.
+//
+// Generated patient and appointment ids start at 10,000,000, above the
+// 6-digit range the booking path draws from, so new bookings never collide
+// with them.
+
+#include "tool_support.h"
+#include "schema.h"
+
+#include <sqlite3.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace {
+
+struct GenOptions {
+    std::string db_path = "datagen.db";
+    bool force = false;
+    int categories = 20;
+    int doctors = 2000;
+    int day_start = 9 * 60;
+    int day_end = 17 * 60;
+    int slot_minutes = 30;
+    long long patients = 500000;
+    long long appointments = 2000000;
+    long long blocked = 50000;
+    int days_back = 730;
+    int days_ahead = 60;
+    double cancelled_past = 0.12;
+    double cancelled_future = 0.05;
+    double doctor_skew = 0.8;
+    long long batch = 20000;
+    unsigned seed = 42;
+};
+
+constexpr long long kFirstGeneratedId = 10000000;
+
+const char* const kSpecialties[] = {
+    "Cardiology", "Dermatology", "Neurology", "Orthopedics", "Pediatrics", "Psychiatry", "Gynecology",
+    "Ophthalmology", "ENT", "Urology", "Gastroenterology", "Endocrinology", "Pulmonology", "Nephrology",
+    "Oncology", "Rheumatology", "General Medicine", "General Surgery", "Dentistry", "Physiotherapy",
+};
+const char* const kFirstNames[] = {
+    "Ayesha", "Ali", "Fatima", "Hassan", "Sara", "Usman", "Zainab", "Bilal", "Maryam", "Omar",
+    "Hina", "Imran", "Sana", "Kamran", "Nida", "Tariq", "Amna", "Farhan", "Rabia", "Saad",
+};
+const char* const kLastNames[] = {
+    "Khan", "Ahmed", "Malik", "Hussain", "Raza", "Iqbal", "Sheikh", "Qureshi", "Butt", "Chaudhry",
+    "Siddiqui", "Mirza", "Javed", "Aslam", "Farooq", "Anwar", "Latif", "Nawaz", "Abbasi", "Rana",
+};
+const char* const kQualifications[] = {
+    "MBBS", "MBBS, FCPS", "MBBS, MRCP", "MBBS, FRCS", "MBBS, MD", "BDS", "DPT", "MBBS, MCPS",
+};
+const char* const kRequests[] = {
+    "", "", "", "", "", "", "First visit", "Follow-up", "Please call before the appointment",
+    "Need a report review",
+};
+
+template <typename T, std::size_t N>
+const T& pick(const T (&items)[N], std::mt19937_64& rng) {
+    return items[std::uniform_int_distribution<std::size_t>(0, N - 1)(rng)];
+}
+
+bool exec(sqlite3* db, const char* sql) {
+    char* err = nullptr;
+    if (sqlite3_exec(db, sql, nullptr, nullptr, &err) != SQLITE_OK) {
+        std::fprintf(stderr, "%s: %s\n", sql, err ? err : sqlite3_errmsg(db));
+        sqlite3_free(err);
+        return false;
+    }
+    return true;
+}
+
+// Prepared statement reused for every row, committed every `batch` rows.
+class BulkInsert {
+public:
+    BulkInsert(sqlite3* db, const char* sql, long long batch, const char* what)
+        : db_(db), batch_(batch), what_(what), started_(std::chrono::steady_clock::now()) {
+        if (sqlite3_prepare_v2(db, sql, -1, &stmt_, nullptr) != SQLITE_OK) {
+            std::fprintf(stderr, "Prepare failed for %s: %s\n", what, sqlite3_errmsg(db));
+            stmt_ = nullptr;
+        }
+        ok_ = stmt_ && exec(db_, "BEGIN;");
+    }
+
+    ~BulkInsert() { sqlite3_finalize(stmt_); }
+
+    bool ok() const { return ok_; }
+    sqlite3_stmt* stmt() { return stmt_; }
+
+    // Runs the bound statement; true when a row was inserted (OR IGNORE
+    // statements skip duplicates).
+    bool step() {
+        const int rc = sqlite3_step(stmt_);
+        sqlite3_reset(stmt_);
+        sqlite3_clear_bindings(stmt_);
+        if (rc != SQLITE_DONE) {
+            std::fprintf(stderr, "Insert into %s failed: %s\n", what_, sqlite3_errmsg(db_));
+            ok_ = false;
+            return false;
+        }
+        if (sqlite3_changes(db_) == 0) {
+            return false;
+        }
+        if (++rows_ % batch_ == 0) {
+            ok_ = exec(db_, "COMMIT;") && exec(db_, "BEGIN;");
+            progress(false);
+        }
+        return true;
+    }
+
+    long long rows() const { return rows_; }
+
+    bool finish() {
+        ok_ = ok_ && exec(db_, "COMMIT;");
+        progress(true);
+        return ok_;
+    }
+
+private:
+    void progress(bool done) {
+        const double s = std::chrono::duration<double>(std::chrono::steady_clock::now() - started_).count();
+        std::printf("\r  %-22s %12lld rows %10.0f rows/s%s", what_, rows_, s > 0 ? static_cast<double>(rows_) / s : 0.0,
+                    done ? "\n" : "");
+        std::fflush(stdout);
+    }
+
+    sqlite3* db_;
+    sqlite3_stmt* stmt_ = nullptr;
+    long long batch_;
+    const char* what_;
+    long long rows_ = 0;
+    bool ok_ = false;
+    std::chrono::steady_clock::time_point started_;
+};
+
+void bindText(sqlite3_stmt* stmt, int index, const std::string& value) {
+    sqlite3_bind_text(stmt, index, value.c_str(), static_cast<int>(value.size()), SQLITE_TRANSIENT);
+}
+
+std::string personName(std::mt19937_64& rng) {
+    return std::string(pick(kFirstNames, rng)) + " " + pick(kLastNames, rng);
+}
+
+bool generateCategories(sqlite3* db, const GenOptions& options) {
+    BulkInsert insert(db, "INSERT INTO Category(category_id, category_name, description) VALUES (?, ?, ?);",
+                      options.batch, "Category");
+    constexpr int kNamed = static_cast<int>(sizeof(kSpecialties) / sizeof(kSpecialties[0]));
+    for (int c = 1; insert.ok() && c <= options.categories; ++c) {
+        const std::string name = c <= kNamed ? kSpecialties[c - 1] : "Specialty " + std::to_string(c);
+        sqlite3_bind_int(insert.stmt(), 1, c);
+        bindText(insert.stmt(), 2, name);
+        bindText(insert.stmt(), 3, name + " consultations and follow-ups");
+        insert.step();
+    }
+    return insert.finish();
+}
+
+bool generateDoctors(sqlite3* db, const GenOptions& options, std::mt19937_64& rng) {
+    BulkInsert insert(db,
+                      "INSERT INTO Doctor(doctor_id, doctor_name, phone, experience_years, qualification, "
+                      "ratings, category_id) VALUES (?, ?, ?, ?, ?, ?, ?);",
+                      options.batch, "Doctor");
+    // Big specialties (low ids) get more doctors.
+    const ZipfSampler category(static_cast<std::size_t>(options.categories), 0.7);
+    for (int d = 1; insert.ok() && d <= options.doctors; ++d) {
+        // Every category gets at least one doctor.
+        const int category_id = d <= options.categories ? d : 1 + static_cast<int>(category(rng));
+        char phone[24];
+        std::snprintf(phone, sizeof(phone), "03%09d", d);
+        sqlite3_stmt* stmt = insert.stmt();
+        sqlite3_bind_int(stmt, 1, d);
+        bindText(stmt, 2, "Dr. " + personName(rng));
+        bindText(stmt, 3, phone);
+        bindText(stmt, 4, std::to_string(std::uniform_int_distribution<int>(1, 35)(rng)));
+        bindText(stmt, 5, pick(kQualifications, rng));
+        sqlite3_bind_double(stmt, 6, std::round(std::uniform_real_distribution<double>(3.0, 5.0)(rng) * 10) / 10);
+        sqlite3_bind_int(stmt, 7, category_id);
+        insert.step();
+    }
+    return insert.finish();
+}
+
+int generateSlots(sqlite3* db, const GenOptions& options) {
+    BulkInsert insert(db, "INSERT INTO Doctor_Schedule(schedule_id, time_slot) VALUES (?, ?);", options.batch,
+                      "Doctor_Schedule");
+    int slots = 0;
+    for (int minute = options.day_start; insert.ok() && minute + options.slot_minutes <= options.day_end;
+         minute += options.slot_minutes) {
+        char slot[16];
+        std::snprintf(slot, sizeof(slot), "%02d:%02d", minute / 60, minute % 60);
+        sqlite3_bind_int(insert.stmt(), 1, ++slots);
+        bindText(insert.stmt(), 2, slot);
+        insert.step();
+    }
+    return insert.finish() ? slots : 0;
+}
+
+bool generatePatients(sqlite3* db, const GenOptions& options, std::mt19937_64& rng) {
+    BulkInsert insert(db,
+                      "INSERT INTO Patient(patient_id, name, age, email, gender, request) VALUES (?, ?, ?, ?, ?, ?);",
+                      options.batch, "Patient");
+    for (long long p = 0; insert.ok() && p < options.patients; ++p) {
+        const std::string name = personName(rng);
+        std::string email = name + "." + std::to_string(p) + "@example.com";
+        std::replace(email.begin(), email.end(), ' ', '.');
+        sqlite3_stmt* stmt = insert.stmt();
+        sqlite3_bind_int64(stmt, 1, kFirstGeneratedId + p);
+        bindText(stmt, 2, name);
+        sqlite3_bind_int(stmt, 3, std::uniform_int_distribution<int>(1, 90)(rng));
+        bindText(stmt, 4, email);
+        bindText(stmt, 5, rng() % 2 ? "Male" : "Female");
+        bindText(stmt, 6, pick(kRequests, rng));
+        insert.step();
+    }
+    return insert.finish();
+}
+
+// Day offsets relative to today, weighted towards the present: a booking
+// system accumulates history, but recent months are busiest.
+class DayPicker {
+public:
+    explicit DayPicker(const GenOptions& options) : back_(options.days_back), ahead_(options.days_ahead) {
+        for (int offset = -back_; offset <= ahead_; ++offset) {
+            dates_.push_back(localDatePlusDays(offset));
+        }
+    }
+
+    int operator()(std::mt19937_64& rng) const {
+        // 85% in the past (exponential back from today), 15% in the booking
+        // window ahead.
+        if (ahead_ > 0 && std::uniform_real_distribution<double>(0.0, 1.0)(rng) < 0.15) {
+            return std::uniform_int_distribution<int>(0, ahead_)(rng);
+        }
+        const double mean = std::max(1.0, back_ / 3.0);
+        const int back = static_cast<int>(std::exponential_distribution<double>(1.0 / mean)(rng));
+        return -std::min(back, back_);
+    }
+
+    const std::string& date(int offset) const { return dates_[static_cast<std::size_t>(offset + back_)]; }
+
+private:
+    int back_;
+    int ahead_;
+    std::vector<std::string> dates_;
+};
+
+bool generateAppointments(sqlite3* db, const GenOptions& options, int slots, const DayPicker& days,
+                          std::mt19937_64& rng) {
+    // OR IGNORE: a (doctor, slot, date) that is already taken is simply
+    // drawn again, like a patient picking another slot.
+    BulkInsert insert(db,
+                      "INSERT OR IGNORE INTO Appointment(appointment_id, patient_id, doctor_id, schedule_id, "
+                      "appointment_date, status, created_at) VALUES (?, ?, ?, ?, ?, ?, ?);",
+                      options.batch, "Appointment");
+    const ZipfSampler doctor(static_cast<std::size_t>(options.doctors), options.doctor_skew);
+    const long long max_attempts = options.appointments * 4 + 1000;
+    long long attempts = 0;
+    while (insert.ok() && insert.rows() < options.appointments && attempts++ < max_attempts) {
+        const int offset = days(rng);
+        const bool past = offset < 0;
+        const double cancel = past ? options.cancelled_past : options.cancelled_future;
+        const bool cancelled = std::uniform_real_distribution<double>(0.0, 1.0)(rng) < cancel;
+        // Booked 0-30 days before the appointment, during opening hours.
+        const int lead = std::uniform_int_distribution<int>(0, 30)(rng);
+        char created_at[40];
+        std::snprintf(created_at, sizeof(created_at), "%s %02d:%02d:%02d",
+                      days.date(std::max(offset - lead, -options.days_back)).c_str(),
+                      std::uniform_int_distribution<int>(8, 20)(rng), std::uniform_int_distribution<int>(0, 59)(rng),
+                      std::uniform_int_distribution<int>(0, 59)(rng));
+
+        const long long n = insert.rows();
+        sqlite3_stmt* stmt = insert.stmt();
+        sqlite3_bind_int64(stmt, 1, kFirstGeneratedId + n);
+        // Returning patients: ids wrap around once every patient has a visit.
+        sqlite3_bind_int64(stmt, 2, kFirstGeneratedId + (options.patients > 0 ? n % options.patients : 0));
+        sqlite3_bind_int(stmt, 3, 1 + static_cast<int>(doctor(rng)));
+        sqlite3_bind_int(stmt, 4, std::uniform_int_distribution<int>(1, slots)(rng));
+        bindText(stmt, 5, days.date(offset));
+        bindText(stmt, 6, cancelled ? "Cancelled" : "BOOKED");
+        bindText(stmt, 7, created_at);
+        insert.step();
+    }
+    if (insert.ok() && insert.rows() < options.appointments) {
+        std::fprintf(stderr, "\nOnly %lld appointments fit; the (doctor, slot, date) space is too crowded\n",
+                     insert.rows());
+    }
+    return insert.finish();
+}
+
+bool generateBlockedSlots(sqlite3* db, const GenOptions& options, int slots, const DayPicker& days,
+                          std::mt19937_64& rng) {
+    // Doctors can only block slots nobody has booked.
+    BulkInsert insert(db,
+                      "INSERT OR IGNORE INTO Doctor_Blocked_Slots(doctor_id, schedule_id, appointment_date) "
+                      "SELECT ?1, ?2, ?3 WHERE NOT EXISTS (SELECT 1 FROM Appointment "
+                      "WHERE doctor_id = ?1 AND schedule_id = ?2 AND appointment_date = ?3 AND status = 'BOOKED');",
+                      options.batch, "Doctor_Blocked_Slots");
+    const long long max_attempts = options.blocked * 4 + 1000;
+    long long attempts = 0;
+    while (insert.ok() && insert.rows() < options.blocked && attempts++ < max_attempts) {
+        sqlite3_stmt* stmt = insert.stmt();
+        sqlite3_bind_int(stmt, 1, std::uniform_int_distribution<int>(1, options.doctors)(rng));
+        sqlite3_bind_int(stmt, 2, std::uniform_int_distribution<int>(1, slots)(rng));
+        bindText(stmt, 3, days.date(std::uniform_int_distribution<int>(0, std::max(0, options.days_ahead))(rng)));
+        insert.step();
+    }
+    return insert.finish();
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    const ToolArgs args(argc, argv);
+    if (args.has("--help")) {
+        std::printf(
+            "usage: datagen [--db PATH] [--force] [--categories N] [--doctors N] [--patients N]\n"
+            "               [--appointments N] [--blocked N] [--days-back N] [--days-ahead N]\n"
+            "               [--day-start HH] [--day-end HH] [--slot-minutes N] [--cancelled-past P]\n"
+            "               [--cancelled-future P] [--doctor-skew S] [--batch N] [--seed N]\n");
+        return 0;
+    }
+
+    GenOptions options;
+    options.db_path = args.get("--db", options.db_path);
+    options.force = args.has("--force");
+    options.categories = static_cast<int>(args.getInt("--categories", options.categories));
+    options.doctors = static_cast<int>(args.getInt("--doctors", options.doctors));
+    options.patients = args.getInt("--patients", options.patients);
+    options.appointments = args.getInt("--appointments", options.appointments);
+    options.blocked = args.getInt("--blocked", options.blocked);
+    options.days_back = static_cast<int>(args.getInt("--days-back", options.days_back));
+    options.days_ahead = static_cast<int>(args.getInt("--days-ahead", options.days_ahead));
+    options.day_start = static_cast<int>(args.getInt("--day-start", options.day_start / 60)) * 60;
+    options.day_end = static_cast<int>(args.getInt("--day-end", options.day_end / 60)) * 60;
+    options.slot_minutes = static_cast<int>(args.getInt("--slot-minutes", options.slot_minutes));
+    options.cancelled_past = args.getDouble("--cancelled-past", options.cancelled_past);
+    options.cancelled_future = args.getDouble("--cancelled-future", options.cancelled_future);
+    options.doctor_skew = args.getDouble("--doctor-skew", options.doctor_skew);
+    options.batch = std::max(1LL, args.getInt("--batch", options.batch));
+    options.seed = static_cast<unsigned>(args.getInt("--seed", options.seed));
+
+    if (options.categories <= 0 || options.doctors < options.categories || options.slot_minutes <= 0 ||
+        options.day_end <= options.day_start || options.days_back < 0 || options.days_ahead < 0 ||
+        (options.appointments > 0 && options.patients <= 0)) {
+        std::fprintf(stderr, "Invalid volumes: need categories > 0, doctors >= categories, a non-empty "
+                             "working day, and patients when generating appointments\n");
+        return 1;
+    }
+
+    if (std::FILE* existing = std::fopen(options.db_path.c_str(), "rb")) {
+        std::fclose(existing);
+        if (!options.force) {
+            std::fprintf(stderr, "%s exists; pass --force to replace it\n", options.db_path.c_str());
+            return 1;
+        }
+    }
+    for (const char* suffix : {"", "-wal", "-shm", "-journal"}) {
+        std::remove((options.db_path + suffix).c_str());
+    }
+
+    sqlite3* db = nullptr;
+    if (sqlite3_open(options.db_path.c_str(), &db) != SQLITE_OK) {
+        std::fprintf(stderr, "Cannot open %s: %s\n", options.db_path.c_str(), sqlite3_errmsg(db));
+        sqlite3_close(db);
+        return 1;
+    }
+
+    // Bulk-load settings: a crash mid-load just means running it again.
+    const auto started = std::chrono::steady_clock::now();
+    std::mt19937_64 rng(options.seed);
+    const DayPicker days(options);
+    bool ok = exec(db, "PRAGMA journal_mode=MEMORY; PRAGMA synchronous=OFF; PRAGMA cache_size=-262144;") &&
+              createSchema(db);
+    std::printf("Generating %s\n", options.db_path.c_str());
+    ok = ok && generateCategories(db, options) && generateDoctors(db, options, rng);
+    const int slots = ok ? generateSlots(db, options) : 0;
+    ok = ok && slots > 0 && generatePatients(db, options, rng) &&
+         generateAppointments(db, options, slots, days, rng) && generateBlockedSlots(db, options, slots, days, rng);
+
+    if (ok) {
+        std::printf("  ANALYZE and switching to WAL...\n");
+        ok = exec(db, "ANALYZE; PRAGMA journal_mode=WAL; PRAGMA synchronous=NORMAL;");
+    }
+    sqlite3_close(db);
+
+    const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count();
+    if (!ok) {
+        std::fprintf(stderr, "Generation failed after %.1f s\n", seconds);
+        return 1;
+    }
+    std::printf("Done in %.1f s\n", seconds);
+    return 0;
+}
@@ -0,0 +1,362 @@
+// Full-funnel load generator for the public booking flow.
+//
+// Each virtual patient is a thread with its own keep-alive connection and
+// cookie jar that walks the same requests the pages make:
+//
+//   /public_session -> /get_categories -> /category_context (POST, GET)
+//   -> /get_doctors -> /schedule_context (POST, GET) -> /get_slots_status
+//   -> /booking_context (POST, GET) -> /book_appointment
+//   -> /confirmation_details
+//
+// with exponentially distributed think time between pages. Doctors and dates
+// are picked with a Zipf skew so a few of them are hot, which is what makes
+// bookings collide (409) the way they do in production.
+//
+//   loadgen --url https://localhost:8443 --patients 32 --duration 60
+//
+// Start the server with RATE_LIMIT_EXEMPT_IPS=127.0.0.1 (or the loadgen
+// host), otherwise /public_session and /get_slots_status are rate limited per
+// client IP and most of the run measures 429s.
+
+#include "tool_support.h"
+
+#include <atomic>
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+enum class Step {
+    PublicSession,
+    Categories,
+    CategoryContextPost,
+    CategoryContextGet,
+    Doctors,
+    ScheduleContextPost,
+    ScheduleContextGet,
+    SlotsStatus,
+    BookingContextPost,
+    BookingContextGet,
+    BookAppointment,
+    ConfirmationDetails,
+    Count
+};
+
+constexpr int kStepCount = static_cast<int>(Step::Count);
+
+const char* const kStepNames[kStepCount] = {
+    "GET /public_session",
+    "GET /get_categories",
+    "POST /category_context",
+    "GET /category_context",
+    "GET /get_doctors",
+    "POST /schedule_context",
+    "GET /schedule_context",
+    "GET /get_slots_status",
+    "POST /booking_context",
+    "GET /booking_context",
+    "POST /book_appointment",
+    "GET /confirmation_details",
+};
+
+struct Options {
+    std::string url = "https://localhost:8443";
+    int patients = 16;
+    int duration_s = 30;
+    double think_ms = 500.0;
+    double doctor_skew = 1.0;
+    double date_skew = 1.0;
+    int days = 14;
+    unsigned seed = 1;
+};
+
+struct Doctor {
+    std::string id;
+    std::string category_id;
+};
+
+// Outcome of the whole funnel for one virtual patient visit.
+struct FunnelStats {
+    uint64_t started = 0;
+    uint64_t booked = 0;
+    uint64_t no_slot = 0;  // every slot on the chosen day was taken
+    uint64_t conflict = 0; // lost the race for a slot (409 on booking)
+    uint64_t aborted = 0;  // any other failed step
+};
+
+struct PatientStats {
+    LatencyStats steps[kStepCount];
+    FunnelStats funnel;
+};
+
+std::unique_ptr<httplib::Client> makeClient(const std::string& url) {
+    auto client = std::make_unique<httplib::Client>(url);
+    client->set_keep_alive(true);
+    client->set_connection_timeout(5);
+    client->set_read_timeout(30);
+#ifdef CPPHTTPLIB_OPENSSL_SUPPORT
+    // The server ships a self-signed certificate.
+    client->enable_server_certificate_verification(false);
+#endif
+    return client;
+}
+
+class VirtualPatient {
+public:
+    VirtualPatient(const Options& options, const std::vector<Doctor>& doctors, const ZipfSampler& pick_doctor,
+                   const ZipfSampler& pick_day, unsigned seed, const std::atomic<bool>& stop, PatientStats& stats)
+        : options_(options), doctors_(doctors), pick_doctor_(pick_doctor), pick_day_(pick_day), rng_(seed),
+          stop_(stop), stats_(stats), client_(makeClient(options.url)) {}
+
+    void run() {
+        while (!stop_.load(std::memory_order_relaxed)) {
+            ++stats_.funnel.started;
+            cookies_.clear();
+            visit();
+        }
+    }
+
+private:
+    // One pass through the funnel; returns early on the first failed step.
+    void visit() {
+        const Doctor& doctor = doctors_[pick_doctor_(rng_)];
+        const std::string date = localDatePlusDays(1 + static_cast<int>(pick_day_(rng_)));
+
+        if (!get(Step::PublicSession, "/public_session") || !get(Step::Categories, "/get_categories")) {
+            return abort();
+        }
+        think();
+        if (!post(Step::CategoryContextPost, "/category_context", "{\"category_id\":" + doctor.category_id + "}") ||
+            !get(Step::CategoryContextGet, "/category_context") ||
+            !get(Step::Doctors, "/get_doctors?category_id=" + doctor.category_id)) {
+            return abort();
+        }
+        think();
+        JsonFields schedule;
+        if (!post(Step::ScheduleContextPost, "/schedule_context", "{\"doctor_id\":" + doctor.id + "}") ||
+            !get(Step::ScheduleContextGet, "/schedule_context") || !parseJsonObject(body_, schedule)) {
+            return abort();
+        }
+
+        std::vector<JsonFields> slots;
+        if (!get(Step::SlotsStatus, "/get_slots_status/" + doctor.id + "/" + date) ||
+            !parseJsonArray(body_, slots)) {
+            return abort();
+        }
+        std::vector<std::string> available;
+        for (const JsonFields& slot : slots) {
+            auto status = slot.find("status");
+            auto time_slot = slot.find("time_slot");
+            if (status != slot.end() && status->second == "AVAILABLE" && time_slot != slot.end()) {
+                available.push_back(time_slot->second);
+            }
+        }
+        if (available.empty()) {
+            ++stats_.funnel.no_slot;
+            return;
+        }
+        const std::string& time_slot =
+            available[std::uniform_int_distribution<std::size_t>(0, available.size() - 1)(rng_)];
+        think();
+
+        const std::string booking =
+            "{\"doctor_id\":" + doctor.id + ",\"doctor_name\":\"" + jsonEscape(schedule["doctor_name"]) +
+            "\",\"category_name\":\"" + jsonEscape(schedule["category_name"]) + "\",\"date\":\"" + date +
+            "\",\"time_slot\":\"" + jsonEscape(time_slot) + "\"}";
+        if (!post(Step::BookingContextPost, "/booking_context", booking)) {
+            return status_ == 409 ? conflict() : abort();
+        }
+        if (!get(Step::BookingContextGet, "/booking_context")) {
+            return abort();
+        }
+        think();
+
+        const unsigned n = static_cast<unsigned>(stats_.funnel.started);
+        const std::string patient =
+            "{\"name\":\"Load Patient " + std::to_string(n) + "\",\"age\":" + std::to_string(20 + n % 60) +
+            ",\"email\":\"loadgen+" + std::to_string(n) + "@example.com\",\"gender\":\"" +
+            (n % 2 ? "Male" : "Female") + "\",\"request\":\"\"}";
+        if (!post(Step::BookAppointment, "/book_appointment", patient)) {
+            return status_ == 409 ? conflict() : abort();
+        }
+        if (!get(Step::ConfirmationDetails, "/confirmation_details")) {
+            return abort();
+        }
+        ++stats_.funnel.booked;
+    }
+
+    bool get(Step step, const std::string& path) {
+        const auto start = std::chrono::steady_clock::now();
+        httplib::Result result = client_->Get(path, cookies_.headers());
+        return finish(step, result, start);
+    }
+
+    bool post(Step step, const std::string& path, const std::string& body) {
+        const auto start = std::chrono::steady_clock::now();
+        httplib::Result result = client_->Post(path, cookies_.headers(), body, "application/json");
+        return finish(step, result, start);
+    }
+
+    bool finish(Step step, const httplib::Result& result, std::chrono::steady_clock::time_point start) {
+        status_ = result ? result->status : 0;
+        stats_.steps[static_cast<int>(step)].record(std::chrono::steady_clock::now() - start, status_);
+        if (!result) {
+            body_.clear();
+            return false;
+        }
+        cookies_.absorb(result->headers);
+        body_ = result->body;
+        return status_ >= 200 && status_ < 300;
+    }
+
+    void think() {
+        if (options_.think_ms <= 0) {
+            return;
+        }
+        const double ms = std::exponential_distribution<double>(1.0 / options_.think_ms)(rng_);
+        auto remaining = std::chrono::duration<double, std::milli>(ms);
+        // Sleep in slices so the run ends on time.
+        while (remaining.count() > 0 && !stop_.load(std::memory_order_relaxed)) {
+            const auto slice = std::min(remaining, std::chrono::duration<double, std::milli>(100));
+            std::this_thread::sleep_for(slice);
+            remaining -= slice;
+        }
+    }
+
+    void abort() { ++stats_.funnel.aborted; }
+    void conflict() { ++stats_.funnel.conflict; }
+
+    const Options& options_;
+    const std::vector<Doctor>& doctors_;
+    const ZipfSampler& pick_doctor_;
+    const ZipfSampler& pick_day_;
+    std::mt19937_64 rng_;
+    const std::atomic<bool>& stop_;
+    PatientStats& stats_;
+    std::unique_ptr<httplib::Client> client_;
+    CookieJar cookies_;
+    std::string body_;
+    int status_ = 0;
+};
+
+// Doctors in the order /get_doctors returns them; the first ones get the most
+// traffic when skewed.
+bool loadDoctors(const Options& options, std::vector<Doctor>& doctors) {
+    auto client = makeClient(options.url);
+    if (!client->is_valid()) {
+        std::fprintf(stderr, "Cannot use %s (https needs a build with CPPHTTPLIB_OPENSSL_SUPPORT)\n",
+                     options.url.c_str());
+        return false;
+    }
+    CookieJar cookies;
+    httplib::Result session = client->Get("/public_session");
+    if (!session || session->status >= 300) {
+        std::fprintf(stderr, "GET /public_session failed (%s)\n",
+                     session ? std::to_string(session->status).c_str() : httplib::to_string(session.error()).c_str());
+        return false;
+    }
+    cookies.absorb(session->headers);
+
+    httplib::Result list = client->Get("/get_doctors", cookies.headers());
+    std::vector<JsonFields> rows;
+    if (!list || list->status != 200 || !parseJsonArray(list->body, rows)) {
+        std::fprintf(stderr, "GET /get_doctors failed\n");
+        return false;
+    }
+    for (JsonFields& row : rows) {
+        if (!row["doctor_id"].empty() && !row["category_id"].empty()) {
+            doctors.push_back({row["doctor_id"], row["category_id"]});
+        }
+    }
+    if (doctors.empty()) {
+        std::fprintf(stderr, "No doctors to book with\n");
+        return false;
+    }
+    return true;
+}
+
+void printReport(const Options& options, const std::vector<PatientStats>& per_patient, double seconds) {
+    PatientStats total;
+    for (const PatientStats& patient : per_patient) {
+        for (int s = 0; s < kStepCount; ++s) {
+            total.steps[s].merge(patient.steps[s]);
+        }
+        total.funnel.started += patient.funnel.started;
+        total.funnel.booked += patient.funnel.booked;
+        total.funnel.no_slot += patient.funnel.no_slot;
+        total.funnel.conflict += patient.funnel.conflict;
+        total.funnel.aborted += patient.funnel.aborted;
+    }
+
+    std::printf("\n%d patients, %.1f s, think %.0f ms, doctor skew %.2f, date skew %.2f over %d days\n\n",
+                options.patients, seconds, options.think_ms, options.doctor_skew, options.date_skew, options.days);
+    printStatsHeader();
+    for (int s = 0; s < kStepCount; ++s) {
+        printStatsRow(kStepNames[s], total.steps[s], seconds);
+    }
+
+    const FunnelStats& f = total.funnel;
+    std::printf("\nfunnel: %llu visits, %llu booked (%.1f/s), %llu lost a slot race (409), "
+                "%llu found no free slot, %llu aborted\n",
+                static_cast<unsigned long long>(f.started), static_cast<unsigned long long>(f.booked),
+                seconds > 0 ? static_cast<double>(f.booked) / seconds : 0.0,
+                static_cast<unsigned long long>(f.conflict), static_cast<unsigned long long>(f.no_slot),
+                static_cast<unsigned long long>(f.aborted));
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    const ToolArgs args(argc, argv);
+    if (args.has("--help")) {
+        std::printf("usage: loadgen [--url URL] [--patients N] [--duration SECONDS] [--think-ms MS]\n"
+                    "               [--doctor-skew S] [--date-skew S] [--days N] [--seed N]\n");
+        return 0;
+    }
+
+    Options options;
+    options.url = args.get("--url", options.url);
+    options.patients = static_cast<int>(args.getInt("--patients", options.patients));
+    options.duration_s = static_cast<int>(args.getInt("--duration", options.duration_s));
+    options.think_ms = args.getDouble("--think-ms", options.think_ms);
+    options.doctor_skew = args.getDouble("--doctor-skew", options.doctor_skew);
+    options.date_skew = args.getDouble("--date-skew", options.date_skew);
+    options.days = static_cast<int>(args.getInt("--days", options.days));
+    options.seed = static_cast<unsigned>(args.getInt("--seed", options.seed));
+    if (options.patients <= 0 || options.duration_s <= 0 || options.days <= 0) {
+        std::fprintf(stderr, "--patients, --duration and --days must be positive\n");
+        return 1;
+    }
+
+    std::vector<Doctor> doctors;
+    if (!loadDoctors(options, doctors)) {
+        return 1;
+    }
+    const ZipfSampler pick_doctor(doctors.size(), options.doctor_skew);
+    const ZipfSampler pick_day(static_cast<std::size_t>(options.days), options.date_skew);
+
+    std::atomic<bool> stop{false};
+    std::vector<PatientStats> stats(static_cast<std::size_t>(options.patients));
+    std::vector<std::thread> threads;
+    const auto started = std::chrono::steady_clock::now();
+    for (int i = 0; i < options.patients; ++i) {
+        threads.emplace_back([&, i] {
+            VirtualPatient patient(options, doctors, pick_doctor, pick_day, options.seed * 7919u + i, stop,
+                                   stats[static_cast<std::size_t>(i)]);
+            patient.run();
+        });
+    }
+
+    std::this_thread::sleep_for(std::chrono::seconds(options.duration_s));
+    stop.store(true);
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+    const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count();
+
+    printReport(options, stats, seconds);
+    return 0;
+}
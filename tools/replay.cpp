@@ -0,0 +1,385 @@
+// Replays a traffic capture (TRAFFIC_CAPTURE=<file> on the server, see
+// services/traffic_capture.h) against a server and reports latency per
+// route, so two builds can be compared on the same real request mix.
+//
+//   replay --capture prod.cap --url https://localhost:8443 --speed 1 --json before.json
+//   replay --capture prod.cap --url https://localhost:8443 --speed 1 --baseline before.json
+//
+// --speed 1 keeps the captured arrival times, 4 replays four times faster and
+// 0 sends as fast as the workers can. Requests are grouped by the client's
+// (pseudonymized) public_token cookie; each group stays on one worker, in
+// order, with its own cookie jar, so the context cookies the server sets
+// (category, schedule, booking) flow through the funnel as they did live.
+// Each group opens its own /public_session before its first request (not
+// measured). Requests that arrived without a session cookie are replayed
+// on their own.
+//
+// Personal fields and tokens in the capture are redacted, so routes that
+// need a real secret (the doctor dashboard) replay as 401s. Bookings change
+// the database: replay against a fresh copy of the same snapshot for every
+// build being compared, with RATE_LIMIT_EXEMPT_IPS set for this host.
+
+#include "tool_support.h"
+
+#include "../services/capture_format.h"
+
+#include <atomic>
+#include <cctype>
+#include <cstdio>
+#include <fstream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace {
+
+struct ReplayOptions {
+    std::string capture_path;
+    std::string url = "https://localhost:8443";
+    double speed = 1.0;
+    int workers = 16;
+    long long limit = 0;
+    std::string json_path;
+    std::string baseline_path;
+    std::string label;
+};
+
+struct CapturedRequest {
+    uint64_t at_us; // since the start of the capture
+    std::string method;
+    std::string target;
+    httplib::Headers headers;
+    std::string content_type = "application/json";
+    std::string body;
+    std::string client; // public_token pseudonym, empty if none
+    int route;          // index into the route table
+};
+
+// Requests arriving this much later than scheduled count as late: the
+// workers could not keep up and the replayed load is lighter than captured.
+constexpr auto kLateThreshold = std::chrono::milliseconds(10);
+
+// "/get_slots_status/12/2026-10-19?x=1" -> "GET /get_slots_status/{n}/{date}"
+std::string routeName(const std::string& method, const std::string& target) {
+    std::string route = method + " ";
+    const std::string path = target.substr(0, target.find('?'));
+    std::size_t start = 0;
+    while (start < path.size()) {
+        std::size_t end = path.find('/', start + 1);
+        if (end == std::string::npos) {
+            end = path.size();
+        }
+        const std::string segment = path.substr(start + 1, end - start - 1);
+        const bool digits = !segment.empty() && std::all_of(segment.begin(), segment.end(), [](unsigned char c) {
+            return std::isdigit(c);
+        });
+        const bool date = segment.size() == 10 && segment[4] == '-' && segment[7] == '-';
+        const bool hex = segment.size() >= 16 && std::all_of(segment.begin(), segment.end(), [](unsigned char c) {
+            return std::isxdigit(c);
+        });
+        route += "/";
+        route += digits ? "{n}" : date ? "{date}" : hex ? "{token}" : segment;
+        start = end;
+    }
+    return path.empty() ? route + "/" : route;
+}
+
+// The session cookie's pseudonym, which identifies one browser.
+std::string publicTokenOf(const std::string& cookie_header) {
+    const std::string name = "public_token=";
+    std::size_t pos = cookie_header.find(name);
+    while (pos != std::string::npos && pos > 0 && cookie_header[pos - 1] != ' ' && cookie_header[pos - 1] != ';') {
+        pos = cookie_header.find(name, pos + 1);
+    }
+    if (pos == std::string::npos) {
+        return "";
+    }
+    pos += name.size();
+    return cookie_header.substr(pos, cookie_header.find(';', pos) - pos);
+}
+
+bool loadCapture(const ReplayOptions& options, std::vector<CapturedRequest>& requests,
+                 std::vector<std::string>& routes) {
+    std::ifstream in(options.capture_path, std::ios::binary);
+    std::stringstream text;
+    text << in.rdbuf();
+    const std::string data = text.str();
+    if (!in || data.compare(0, kCaptureMagicSize, kCaptureMagic) != 0) {
+        std::fprintf(stderr, "%s is not a traffic capture\n", options.capture_path.c_str());
+        return false;
+    }
+
+    std::unordered_map<std::string, int> route_ids;
+    std::size_t pos = kCaptureMagicSize;
+    uint64_t at_us = 0;
+    while (pos < data.size() && (options.limit <= 0 || static_cast<long long>(requests.size()) < options.limit)) {
+        CapturedRequest req;
+        uint64_t delta = 0;
+        uint64_t header_count = 0;
+        bool ok = readVarint(data.data(), data.size(), pos, delta) &&
+                  readCaptureString(data.data(), data.size(), pos, req.method) &&
+                  readCaptureString(data.data(), data.size(), pos, req.target) &&
+                  readVarint(data.data(), data.size(), pos, header_count);
+        for (uint64_t h = 0; ok && h < header_count; ++h) {
+            std::string name;
+            std::string value;
+            ok = readCaptureString(data.data(), data.size(), pos, name) &&
+                 readCaptureString(data.data(), data.size(), pos, value);
+            if (name == "Cookie") {
+                req.client = publicTokenOf(value);
+            } else if (name == "Content-Type") {
+                req.content_type = value; // httplib sets it from the body
+            } else {
+                // The jar supplies real cookies; everything else goes as captured.
+                req.headers.emplace(name, value);
+            }
+        }
+        ok = ok && readCaptureString(data.data(), data.size(), pos, req.body);
+        if (!ok) {
+            // A capture cut off by a crash or the size limit ends mid-record.
+            std::fprintf(stderr, "Capture truncated after %zu requests\n", requests.size());
+            break;
+        }
+
+        at_us += delta;
+        req.at_us = at_us;
+        const std::string route = routeName(req.method, req.target);
+        auto [it, added] = route_ids.emplace(route, static_cast<int>(routes.size()));
+        if (added) {
+            routes.push_back(route);
+        }
+        req.route = it->second;
+        requests.push_back(std::move(req));
+    }
+    return !requests.empty();
+}
+
+std::unique_ptr<httplib::Client> makeClient(const std::string& url) {
+    auto client = std::make_unique<httplib::Client>(url);
+    client->set_keep_alive(true);
+    client->set_connection_timeout(5);
+    client->set_read_timeout(30);
+#ifdef CPPHTTPLIB_OPENSSL_SUPPORT
+    client->enable_server_certificate_verification(false);
+#endif
+    return client;
+}
+
+struct WorkerResult {
+    std::vector<LatencyStats> per_route;
+    uint64_t late = 0;
+    uint64_t sessions_failed = 0;
+};
+
+httplib::Result send(httplib::Client& client, const CapturedRequest& req, const httplib::Headers& headers) {
+    const std::string& content_type = req.content_type;
+    if (req.method == "GET") {
+        return client.Get(req.target, headers);
+    }
+    if (req.method == "POST") {
+        return client.Post(req.target, headers, req.body, content_type);
+    }
+    if (req.method == "PUT") {
+        return client.Put(req.target, headers, req.body, content_type);
+    }
+    if (req.method == "DELETE") {
+        return client.Delete(req.target, headers, req.body, content_type);
+    }
+    return client.Options(req.target, headers);
+}
+
+void runWorker(const ReplayOptions& options, const std::vector<const CapturedRequest*>& queue,
+               std::size_t route_count, std::chrono::steady_clock::time_point start, WorkerResult& result) {
+    result.per_route.resize(route_count);
+    auto client = makeClient(options.url);
+    std::unordered_map<std::string, CookieJar> jars;
+
+    for (const CapturedRequest* req : queue) {
+        CookieJar* jar = nullptr;
+        if (!req->client.empty()) {
+            auto [it, added] = jars.try_emplace(req->client);
+            jar = &it->second;
+            if (added) {
+                httplib::Result session = client->Get("/public_session");
+                if (session && session->status < 300) {
+                    jar->absorb(session->headers);
+                } else {
+                    ++result.sessions_failed;
+                }
+            }
+        }
+
+        if (options.speed > 0) {
+            const auto due = start + std::chrono::microseconds(
+                                         static_cast<long long>(static_cast<double>(req->at_us) / options.speed));
+            const auto now = std::chrono::steady_clock::now();
+            if (now < due) {
+                std::this_thread::sleep_until(due);
+            } else if (now - due > kLateThreshold) {
+                ++result.late;
+            }
+        }
+
+        httplib::Headers headers = req->headers;
+        if (jar) {
+            for (auto& cookie : jar->headers()) {
+                headers.insert(cookie);
+            }
+        }
+        const auto sent = std::chrono::steady_clock::now();
+        httplib::Result res = send(*client, *req, headers);
+        result.per_route[req->route].record(std::chrono::steady_clock::now() - sent, res ? res->status : 0);
+        if (res && jar) {
+            jar->absorb(res->headers);
+        }
+    }
+}
+
+// --------------------------------------------------
+// Output
+// --------------------------------------------------
+bool writeJson(const ReplayOptions& options, const std::vector<std::string>& routes,
+               const std::vector<LatencyStats>& stats) {
+    std::ofstream out(options.json_path);
+    if (!out) {
+        std::fprintf(stderr, "Cannot write %s\n", options.json_path.c_str());
+        return false;
+    }
+    out << "{\n  \"label\": \"" << jsonEscape(options.label) << "\",\n  \"speed\": " << options.speed
+        << ",\n  \"routes\": [\n";
+    for (std::size_t i = 0; i < routes.size(); ++i) {
+        const LatencyStats& s = stats[i];
+        out << "    {\"name\": \"" << jsonEscape(routes[i]) << "\", \"count\": " << s.count
+            << ", \"p50_ms\": " << s.quantileMs(0.50) << ", \"p90_ms\": " << s.quantileMs(0.90)
+            << ", \"p99_ms\": " << s.quantileMs(0.99) << ", \"max_ms\": " << static_cast<double>(s.max_us) / 1000.0
+            << ", \"failed\": " << s.failed << ", \"other\": " << s.other << "}"
+            << (i + 1 < routes.size() ? "," : "") << "\n";
+    }
+    out << "  ]\n}\n";
+    return true;
+}
+
+// p50 / p99 change against a file written by --json.
+bool compareBaseline(const ReplayOptions& options, const std::vector<std::string>& routes,
+                     const std::vector<LatencyStats>& stats) {
+    std::ifstream in(options.baseline_path);
+    std::stringstream text;
+    text << in.rdbuf();
+    const std::string body = text.str();
+    const std::size_t list = body.find('[');
+    std::vector<JsonFields> baseline;
+    if (!in || list == std::string::npos || !parseJsonArray(body.substr(list), baseline)) {
+        std::fprintf(stderr, "Cannot read baseline %s\n", options.baseline_path.c_str());
+        return false;
+    }
+
+    auto change = [](double before, double after) { return before > 0 ? 100.0 * (after - before) / before : 0.0; };
+    std::printf("\n%-40s %10s %10s %9s %10s %10s %9s\n", "vs baseline", "p50 before", "p50 after", "change",
+                "p99 before", "p99 after", "change");
+    for (std::size_t i = 0; i < routes.size(); ++i) {
+        for (JsonFields& old : baseline) {
+            if (old["name"] != routes[i]) {
+                continue;
+            }
+            const double p50 = std::strtod(old["p50_ms"].c_str(), nullptr);
+            const double p99 = std::strtod(old["p99_ms"].c_str(), nullptr);
+            std::printf("%-40s %10.2f %10.2f %+8.1f%% %10.2f %10.2f %+8.1f%%\n", routes[i].c_str(), p50,
+                        stats[i].quantileMs(0.50), change(p50, stats[i].quantileMs(0.50)), p99,
+                        stats[i].quantileMs(0.99), change(p99, stats[i].quantileMs(0.99)));
+        }
+    }
+    return true;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    const ToolArgs args(argc, argv);
+    if (args.has("--help") || !args.has("--capture")) {
+        std::printf("usage: replay --capture FILE [--url URL] [--speed X] [--workers N] [--limit N]\n"
+                    "              [--json OUT.json] [--label TEXT] [--baseline OLD.json]\n");
+        return args.has("--help") ? 0 : 1;
+    }
+
+    ReplayOptions options;
+    options.capture_path = args.get("--capture", "");
+    options.url = args.get("--url", options.url);
+    options.speed = std::max(0.0, args.getDouble("--speed", options.speed));
+    options.workers = std::max(1, static_cast<int>(args.getInt("--workers", options.workers)));
+    options.limit = args.getInt("--limit", options.limit);
+    options.json_path = args.get("--json", "");
+    options.baseline_path = args.get("--baseline", "");
+    options.label = args.get("--label", "");
+
+    std::vector<CapturedRequest> requests;
+    std::vector<std::string> routes;
+    if (!loadCapture(options, requests, routes)) {
+        std::fprintf(stderr, "No requests to replay\n");
+        return 1;
+    }
+
+    // One client always lands on the same worker; clientless requests are
+    // spread round-robin.
+    std::vector<std::vector<const CapturedRequest*>> queues(options.workers);
+    std::size_t next = 0;
+    for (const CapturedRequest& req : requests) {
+        const std::size_t worker = req.client.empty() ? next++ : std::hash<std::string>{}(req.client);
+        queues[worker % queues.size()].push_back(&req);
+    }
+
+    const double captured_s = static_cast<double>(requests.back().at_us) / 1e6;
+    std::printf("Replaying %zu requests (%.1f s captured) against %s with %d workers, ", requests.size(), captured_s,
+                options.url.c_str(), options.workers);
+    if (options.speed > 0) {
+        std::printf("%.2fx speed\n", options.speed);
+    } else {
+        std::printf("full speed\n");
+    }
+
+    std::vector<WorkerResult> results(options.workers);
+    std::vector<std::thread> threads;
+    const auto start = std::chrono::steady_clock::now();
+    for (int w = 0; w < options.workers; ++w) {
+        threads.emplace_back(runWorker, std::cref(options), std::cref(queues[w]), routes.size(), start,
+                             std::ref(results[w]));
+    }
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+    const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    std::vector<LatencyStats> stats(routes.size());
+    LatencyStats total;
+    uint64_t late = 0;
+    uint64_t sessions_failed = 0;
+    for (const WorkerResult& result : results) {
+        for (std::size_t r = 0; r < routes.size(); ++r) {
+            stats[r].merge(result.per_route[r]);
+            total.merge(result.per_route[r]);
+        }
+        late += result.late;
+        sessions_failed += result.sessions_failed;
+    }
+
+    std::printf("\n");
+    printStatsHeader();
+    for (std::size_t r = 0; r < routes.size(); ++r) {
+        printStatsRow(routes[r], stats[r], seconds);
+    }
+    printStatsRow("total", total, seconds);
+    std::printf("\n%.1f s wall, %.1f%% of requests sent more than %lld ms late, %llu sessions failed\n", seconds,
+                percentOf(late, total.count), static_cast<long long>(kLateThreshold.count()),
+                static_cast<unsigned long long>(sessions_failed));
+
+    bool ok = true;
+    if (!options.json_path.empty()) {
+        ok = writeJson(options, routes, stats) && ok;
+    }
+    if (!options.baseline_path.empty()) {
+        ok = compareBaseline(options, routes, stats) && ok;
+    }
+    return ok ? 0 : 1;
+}
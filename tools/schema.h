@@ -0,0 +1,72 @@
+#pragma once
+
+// The tables the server expects, for tools that build their own databases
+// (benchmarks, data generator). Matches the columns the models and
+// controllers query; Doctor_Blocked_Slots is the same statement
+// prepareStatements() (services/sql_statements.cpp) runs on every connection.
+
+#include <sqlite3.h>
+
+#include <cstdio>
+
+inline constexpr const char* kSchemaSql =
+    "CREATE TABLE IF NOT EXISTS Category ("
+    "  category_id INTEGER PRIMARY KEY AUTOINCREMENT,"
+    "  category_name TEXT NOT NULL UNIQUE,"
+    "  description TEXT"
+    ");"
+    "CREATE TABLE IF NOT EXISTS Doctor ("
+    "  doctor_id INTEGER PRIMARY KEY AUTOINCREMENT,"
+    "  doctor_name TEXT NOT NULL,"
+    "  phone TEXT,"
+    "  experience_years TEXT,"
+    "  qualification TEXT,"
+    "  ratings REAL,"
+    "  category_id INTEGER NOT NULL,"
+    "  FOREIGN KEY (category_id) REFERENCES Category(category_id) ON DELETE CASCADE"
+    ");"
+    "CREATE TABLE IF NOT EXISTS Doctor_Schedule ("
+    "  schedule_id INTEGER PRIMARY KEY AUTOINCREMENT,"
+    "  time_slot TEXT NOT NULL UNIQUE"
+    ");"
+    "CREATE TABLE IF NOT EXISTS Patient ("
+    "  patient_id INTEGER PRIMARY KEY,"
+    "  name TEXT NOT NULL,"
+    "  age INTEGER,"
+    "  email TEXT NOT NULL,"
+    "  gender TEXT NOT NULL,"
+    "  request TEXT"
+    ");"
+    "CREATE TABLE IF NOT EXISTS Appointment ("
+    "  appointment_id INTEGER PRIMARY KEY,"
+    "  patient_id INTEGER NOT NULL,"
+    "  doctor_id INTEGER NOT NULL,"
+    "  schedule_id INTEGER NOT NULL,"
+    "  appointment_date TEXT NOT NULL,"
+    "  status TEXT NOT NULL DEFAULT 'BOOKED',"
+    "  created_at TEXT NOT NULL DEFAULT (datetime('now','localtime')),"
+    "  UNIQUE (doctor_id, schedule_id, appointment_date),"
+    "  FOREIGN KEY (patient_id) REFERENCES Patient(patient_id),"
+    "  FOREIGN KEY (doctor_id) REFERENCES Doctor(doctor_id) ON DELETE CASCADE,"
+    "  FOREIGN KEY (schedule_id) REFERENCES Doctor_Schedule(schedule_id) ON DELETE CASCADE"
+    ");"
+    "CREATE TABLE IF NOT EXISTS Doctor_Blocked_Slots ("
+    "  doctor_id INTEGER NOT NULL,"
+    "  schedule_id INTEGER NOT NULL,"
+    "  appointment_date TEXT NOT NULL,"
+    "  created_at TEXT NOT NULL DEFAULT (datetime('now','localtime')),"
+    "  PRIMARY KEY (doctor_id, schedule_id, appointment_date),"
+    "  FOREIGN KEY (doctor_id) REFERENCES Doctor(doctor_id) ON DELETE CASCADE,"
+    "  FOREIGN KEY (schedule_id) REFERENCES Doctor_Schedule(schedule_id) ON DELETE CASCADE"
+    ");";
+
+// Runs kSchemaSql on `db`; prints the error and returns false on failure.
+inline bool createSchema(sqlite3* db) {
+    char* err = nullptr;
+    if (sqlite3_exec(db, kSchemaSql, nullptr, nullptr, &err) != SQLITE_OK) {
+        std::fprintf(stderr, "Creating schema failed: %s\n", err ? err : sqlite3_errmsg(db));
+        sqlite3_free(err);
+        return false;
+    }
+    return true;
+}
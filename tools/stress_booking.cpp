@@ -0,0 +1,377 @@
+// Double-booking stress test: many clients race for the same few
+// (doctor, slot, date) keys through the real booking path
+// (POST /booking_context, then POST /book_appointment), at increasing
+// concurrency.
+//
+// For each concurrency level every thread first takes a booking context for
+// the round's key, then all threads are released together onto
+// /book_appointment, so the requests meet in isSlotBlocked /
+// isSlotAlreadyBooked / Appointment::insert / rebookCancelledAppointment at
+// the same moment. A share of the keys is pre-seeded with a Cancelled row so
+// the rebook path races too. Afterwards the database is checked: every key
+// must have exactly one BOOKED row and exactly one client must have been
+// told it succeeded.
+//
+//   stress_booking --url https://localhost:8443 --db ../db/stress.db --levels 1,4,16,64 --keys 32
+//
+// Run the server with RATE_LIMIT_EXEMPT_IPS set for this host. Each level
+// books on its own date (--day-offset days ahead, plus the level index), far
+// from real bookings, and the hot keys on those dates are wiped before each
+// level: point it at a scratch copy of the database.
+
+#include "tool_support.h"
+
+#include <sqlite3.h>
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+struct StressOptions {
+    std::string url = "https://localhost:8443";
+    std::string db_path;
+    std::vector<int> levels = {1, 4, 16, 64};
+    int keys = 32;
+    int day_offset = 400;
+    double cancelled_share = 0.25;
+};
+
+struct Key {
+    int doctor_id;
+    std::string doctor_name;
+    std::string category_name;
+    int schedule_id;
+    std::string time_slot;
+};
+
+// Ids for seeded rows, clear of generateRandomID() and tools/datagen.
+constexpr long long kFirstSeedId = 20000000;
+
+// Releases all threads of a round at once (std::barrier is C++20).
+class Barrier {
+public:
+    explicit Barrier(int count) : count_(count), waiting_(0) {}
+
+    void wait() {
+        std::unique_lock<std::mutex> lock(mutex_);
+        const unsigned generation = generation_;
+        if (++waiting_ == count_) {
+            waiting_ = 0;
+            ++generation_;
+            cv_.notify_all();
+            return;
+        }
+        cv_.wait(lock, [&] { return generation != generation_; });
+    }
+
+private:
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    const int count_;
+    int waiting_;
+    unsigned generation_ = 0;
+};
+
+std::unique_ptr<httplib::Client> makeClient(const std::string& url) {
+    auto client = std::make_unique<httplib::Client>(url);
+    client->set_keep_alive(true);
+    client->set_connection_timeout(5);
+    client->set_read_timeout(30);
+#ifdef CPPHTTPLIB_OPENSSL_SUPPORT
+    client->enable_server_certificate_verification(false);
+#endif
+    return client;
+}
+
+bool startSession(httplib::Client& client, CookieJar& cookies) {
+    httplib::Result session = client.Get("/public_session");
+    if (!session || session->status >= 300) {
+        return false;
+    }
+    cookies.absorb(session->headers);
+    return true;
+}
+
+// Hot keys: the first doctors' slots, `count` of them, with the names
+// /booking_context checks against.
+bool loadKeys(const StressOptions& options, std::vector<Key>& keys) {
+    auto client = makeClient(options.url);
+    CookieJar cookies;
+    if (!client->is_valid() || !startSession(*client, cookies)) {
+        std::fprintf(stderr, "Cannot open a session at %s\n", options.url.c_str());
+        return false;
+    }
+
+    std::vector<JsonFields> categories;
+    std::vector<JsonFields> doctors;
+    httplib::Result res = client->Get("/get_categories", cookies.headers());
+    if (!res || res->status != 200 || !parseJsonArray(res->body, categories)) {
+        std::fprintf(stderr, "GET /get_categories failed\n");
+        return false;
+    }
+    res = client->Get("/get_doctors", cookies.headers());
+    if (!res || res->status != 200 || !parseJsonArray(res->body, doctors) || doctors.empty()) {
+        std::fprintf(stderr, "GET /get_doctors failed\n");
+        return false;
+    }
+
+    for (JsonFields& doctor : doctors) {
+        std::string category_name;
+        for (JsonFields& category : categories) {
+            if (category["category_id"] == doctor["category_id"]) {
+                category_name = category["category_name"];
+            }
+        }
+        std::vector<JsonFields> slots;
+        res = client->Get("/get_slots_status/" + doctor["doctor_id"] + "/" + localDatePlusDays(options.day_offset),
+                          cookies.headers());
+        if (!res || res->status != 200 || !parseJsonArray(res->body, slots)) {
+            std::fprintf(stderr, "GET /get_slots_status failed\n");
+            return false;
+        }
+        for (JsonFields& slot : slots) {
+            keys.push_back({std::atoi(doctor["doctor_id"].c_str()), doctor["doctor_name"], category_name,
+                            std::atoi(slot["schedule_id"].c_str()), slot["time_slot"]});
+            if (static_cast<int>(keys.size()) == options.keys) {
+                return true;
+            }
+        }
+    }
+    std::fprintf(stderr, "Only %zu (doctor, slot) keys available\n", keys.size());
+    return !keys.empty();
+}
+
+bool exec(sqlite3* db, const std::string& sql) {
+    char* err = nullptr;
+    if (sqlite3_exec(db, sql.c_str(), nullptr, nullptr, &err) != SQLITE_OK) {
+        std::fprintf(stderr, "%s: %s\n", sql.c_str(), err ? err : sqlite3_errmsg(db));
+        sqlite3_free(err);
+        return false;
+    }
+    return true;
+}
+
+// Clears the keys on `date` (left over from an earlier run), then puts
+// Cancelled rows on the first share of them so those bookings go through
+// rebookCancelledAppointment().
+bool prepareKeys(sqlite3* db, const StressOptions& options, const std::vector<Key>& keys, const std::string& date,
+                 long long& next_id) {
+    const int seeded = static_cast<int>(options.cancelled_share * static_cast<double>(keys.size()));
+    std::ostringstream sql;
+    sql << "BEGIN;";
+    for (const Key& key : keys) {
+        for (const char* table : {"Appointment", "Doctor_Blocked_Slots"}) {
+            sql << "DELETE FROM " << table << " WHERE doctor_id = " << key.doctor_id
+                << " AND schedule_id = " << key.schedule_id << " AND appointment_date = '" << date << "';";
+        }
+    }
+    for (int k = 0; k < seeded; ++k) {
+        const long long id = next_id++;
+        sql << "INSERT OR IGNORE INTO Patient(patient_id, name, age, email, gender, request) VALUES (" << id
+            << ", 'Stress Seed', 40, 'stress-seed@example.com', 'Female', '');"
+            << "INSERT OR IGNORE INTO Appointment(appointment_id, patient_id, doctor_id, schedule_id, "
+            << "appointment_date, status) VALUES (" << id << ", " << id << ", " << keys[k].doctor_id << ", "
+            << keys[k].schedule_id << ", '" << date << "', 'Cancelled');";
+    }
+    sql << "COMMIT;";
+    return exec(db, sql.str());
+}
+
+int bookedRows(sqlite3* db, const Key& key, const std::string& date) {
+    const char* sql =
+        "SELECT COUNT(*) FROM Appointment "
+        "WHERE doctor_id = ? AND schedule_id = ? AND appointment_date = ? AND status = 'BOOKED';";
+    sqlite3_stmt* stmt = nullptr;
+    if (sqlite3_prepare_v2(db, sql, -1, &stmt, nullptr) != SQLITE_OK) {
+        return -1;
+    }
+    sqlite3_bind_int(stmt, 1, key.doctor_id);
+    sqlite3_bind_int(stmt, 2, key.schedule_id);
+    sqlite3_bind_text(stmt, 3, date.c_str(), -1, SQLITE_TRANSIENT);
+    const int count = sqlite3_step(stmt) == SQLITE_ROW ? sqlite3_column_int(stmt, 0) : -1;
+    sqlite3_finalize(stmt);
+    return count;
+}
+
+struct WorkerStats {
+    LatencyStats book;           // POST /book_appointment
+    uint64_t context_failed = 0; // no booking context, so no attempt
+    std::vector<int> successes;  // 200s per key
+};
+
+void runWorker(const StressOptions& options, const std::vector<Key>& keys, const std::string& date, int worker,
+               Barrier& barrier, WorkerStats& stats) {
+    auto client = makeClient(options.url);
+    CookieJar cookies;
+    const bool session = startSession(*client, cookies);
+    stats.successes.assign(keys.size(), 0);
+
+    for (std::size_t k = 0; k < keys.size(); ++k) {
+        const Key& key = keys[k];
+        bool have_context = false;
+        if (session) {
+            const std::string context = "{\"doctor_id\":" + std::to_string(key.doctor_id) + ",\"doctor_name\":\"" +
+                                        jsonEscape(key.doctor_name) + "\",\"category_name\":\"" +
+                                        jsonEscape(key.category_name) + "\",\"date\":\"" + date +
+                                        "\",\"time_slot\":\"" + jsonEscape(key.time_slot) + "\"}";
+            httplib::Result res = client->Post("/booking_context", cookies.headers(), context, "application/json");
+            have_context = res && res->status == 200;
+            if (have_context) {
+                cookies.absorb(res->headers);
+            }
+        }
+        if (!have_context) {
+            ++stats.context_failed;
+        }
+
+        // Everyone holds a context for this key; go.
+        barrier.wait();
+        if (have_context) {
+            const std::string patient = "{\"name\":\"Stress Patient " + std::to_string(worker) +
+                                        "\",\"age\":30,\"email\":\"stress" + std::to_string(worker) +
+                                        "@example.com\",\"gender\":\"Male\",\"request\":\"\"}";
+            const auto start = std::chrono::steady_clock::now();
+            httplib::Result res = client->Post("/book_appointment", cookies.headers(), patient, "application/json");
+            const int status = res ? res->status : 0;
+            stats.book.record(std::chrono::steady_clock::now() - start, status);
+            if (status == 200) {
+                ++stats.successes[k];
+            }
+        }
+        barrier.wait();
+    }
+}
+
+std::vector<int> parseLevels(const std::string& text) {
+    std::vector<int> levels;
+    std::istringstream list(text);
+    std::string item;
+    while (std::getline(list, item, ',')) {
+        const int level = std::atoi(item.c_str());
+        if (level > 0) {
+            levels.push_back(level);
+        }
+    }
+    return levels;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    const ToolArgs args(argc, argv);
+    if (args.has("--help") || !args.has("--db")) {
+        std::printf("usage: stress_booking --db PATH [--url URL] [--levels 1,4,16,64] [--keys N]\n"
+                    "                      [--day-offset DAYS] [--cancelled-share P]\n"
+                    "--db is the server's database file, read to verify the results.\n");
+        return args.has("--help") ? 0 : 1;
+    }
+
+    StressOptions options;
+    options.url = args.get("--url", options.url);
+    options.db_path = args.get("--db", "");
+    if (args.has("--levels")) {
+        options.levels = parseLevels(args.get("--levels", ""));
+    }
+    options.keys = static_cast<int>(args.getInt("--keys", options.keys));
+    options.day_offset = static_cast<int>(args.getInt("--day-offset", options.day_offset));
+    options.cancelled_share = args.getDouble("--cancelled-share", options.cancelled_share);
+    if (options.levels.empty() || options.keys <= 0) {
+        std::fprintf(stderr, "--levels and --keys must be positive\n");
+        return 1;
+    }
+
+    sqlite3* db = nullptr;
+    if (sqlite3_open_v2(options.db_path.c_str(), &db, SQLITE_OPEN_READWRITE, nullptr) != SQLITE_OK) {
+        std::fprintf(stderr, "Cannot open %s: %s\n", options.db_path.c_str(), sqlite3_errmsg(db));
+        sqlite3_close(db);
+        return 1;
+    }
+    sqlite3_busy_timeout(db, 5000);
+
+    std::vector<Key> keys;
+    if (!loadKeys(options, keys)) {
+        sqlite3_close(db);
+        return 1;
+    }
+
+    std::printf("%zu hot keys per level, %.0f%% pre-seeded as Cancelled\n\n", keys.size(),
+                options.cancelled_share * 100.0);
+    std::printf("%8s %9s %8s %9s %9s %7s %7s %7s %9s %9s %9s %9s %10s\n", "threads", "attempts", "booked",
+                "attempt/s", "booked/s", "409%", "503%", "err%", "p50 ms", "p90 ms", "p99 ms", "max ms", "violations");
+
+    long long next_seed_id = kFirstSeedId;
+    int total_violations = 0;
+    for (std::size_t l = 0; l < options.levels.size(); ++l) {
+        const int threads = options.levels[l];
+        const std::string date = localDatePlusDays(options.day_offset + static_cast<int>(l));
+        if (!prepareKeys(db, options, keys, date, next_seed_id)) {
+            sqlite3_close(db);
+            return 1;
+        }
+
+        Barrier barrier(threads);
+        std::vector<WorkerStats> stats(static_cast<std::size_t>(threads));
+        std::vector<std::thread> workers;
+        const auto started = std::chrono::steady_clock::now();
+        for (int t = 0; t < threads; ++t) {
+            workers.emplace_back([&, t] {
+                runWorker(options, keys, date, t, barrier, stats[static_cast<std::size_t>(t)]);
+            });
+        }
+        for (std::thread& worker : workers) {
+            worker.join();
+        }
+        const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count();
+
+        LatencyStats book;
+        uint64_t context_failed = 0;
+        std::vector<int> successes(keys.size(), 0);
+        for (const WorkerStats& s : stats) {
+            book.merge(s.book);
+            context_failed += s.context_failed;
+            for (std::size_t k = 0; k < keys.size(); ++k) {
+                successes[k] += s.successes[k];
+            }
+        }
+
+        // Exactly one BOOKED row per key, and exactly one client told so.
+        int violations = 0;
+        int booked = 0;
+        for (std::size_t k = 0; k < keys.size(); ++k) {
+            const int rows = bookedRows(db, keys[k], date);
+            booked += rows > 0 ? 1 : 0;
+            if (rows != 1 || successes[k] != 1) {
+                ++violations;
+                std::fprintf(stderr, "  key doctor=%d slot=%d date=%s: %d BOOKED rows, %d clients got 200\n",
+                             keys[k].doctor_id, keys[k].schedule_id, date.c_str(), rows, successes[k]);
+            }
+        }
+        total_violations += violations;
+
+        std::printf("%8d %9llu %8d %9.1f %9.1f %7.2f %7.2f %7.2f %9.2f %9.2f %9.2f %9.2f %10d\n", threads,
+                    static_cast<unsigned long long>(book.count), booked,
+                    seconds > 0 ? static_cast<double>(book.count) / seconds : 0.0,
+                    seconds > 0 ? booked / seconds : 0.0, percentOf(book.conflict, book.count),
+                    percentOf(book.unavailable, book.count),
+                    percentOf(book.failed - book.unavailable + book.other + book.limited, book.count),
+                    book.quantileMs(0.50), book.quantileMs(0.90),
+                    book.quantileMs(0.99), static_cast<double>(book.max_us) / 1000.0, violations);
+        if (context_failed) {
+            std::printf("%8s %llu attempts had no booking context (session or /booking_context failed)\n", "",
+                        static_cast<unsigned long long>(context_failed));
+        }
+    }
+
+    sqlite3_close(db);
+    std::printf("\n%s\n", total_violations ? "FAILED: double bookings or lost confirmations (see above)"
+                                           : "OK: every key booked exactly once");
+    return total_violations ? 2 : 0;
+}
@@ -0,0 +1,327 @@
+#pragma once
+
+// Helpers shared by the command-line tools in tools/ (load generator,
+// benchmarks, data generator). Header-only and independent of Crow so each
+// tool is a single translation unit.
+
+#include <httplib.h>
+
+#include "../services/latency_histogram.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <map>
+#include <random>
+#include <string>
+#include <vector>
+
+// --------------------------------------------------
+// Command line: --name value
+// --------------------------------------------------
+class ToolArgs {
+public:
+    ToolArgs(int argc, char** argv) : args_(argv + 1, argv + argc) {}
+
+    bool has(const std::string& name) const {
+        return std::find(args_.begin(), args_.end(), name) != args_.end();
+    }
+
+    std::string get(const std::string& name, const std::string& fallback) const {
+        auto it = std::find(args_.begin(), args_.end(), name);
+        return (it != args_.end() && it + 1 != args_.end()) ? *(it + 1) : fallback;
+    }
+
+    long long getInt(const std::string& name, long long fallback) const {
+        const std::string value = get(name, "");
+        return value.empty() ? fallback : std::strtoll(value.c_str(), nullptr, 10);
+    }
+
+    double getDouble(const std::string& name, double fallback) const {
+        const std::string value = get(name, "");
+        return value.empty() ? fallback : std::strtod(value.c_str(), nullptr);
+    }
+
+private:
+    std::vector<std::string> args_;
+};
+
+// --------------------------------------------------
+// Cookies: keeps name=value from every Set-Cookie and sends them back, like
+// the browser does for the public flow (attributes are ignored).
+// --------------------------------------------------
+class CookieJar {
+public:
+    void absorb(const httplib::Headers& headers) {
+        auto range = headers.equal_range("Set-Cookie");
+        for (auto it = range.first; it != range.second; ++it) {
+            const std::string& line = it->second;
+            const std::size_t eq = line.find('=');
+            if (eq == std::string::npos) {
+                continue;
+            }
+            const std::size_t end = line.find(';', eq);
+            cookies_[line.substr(0, eq)] = line.substr(eq + 1, end == std::string::npos ? std::string::npos : end - eq - 1);
+        }
+    }
+
+    httplib::Headers headers() const {
+        std::string value;
+        for (const auto& [name, cookie] : cookies_) {
+            if (!value.empty()) {
+                value += "; ";
+            }
+            value += name + "=" + cookie;
+        }
+        return value.empty() ? httplib::Headers{} : httplib::Headers{{"Cookie", value}};
+    }
+
+    void clear() { cookies_.clear(); }
+
+private:
+    std::map<std::string, std::string> cookies_;
+};
+
+// --------------------------------------------------
+// JSON: just enough to read the flat objects (or arrays of them) the API
+// returns. Values come back as their text; strings are unescaped.
+// --------------------------------------------------
+using JsonFields = std::map<std::string, std::string>;
+
+namespace tool_json {
+
+inline void skipSpace(const std::string& s, std::size_t& i) {
+    while (i < s.size() && (s[i] == ' ' || s[i] == '\n' || s[i] == '\r' || s[i] == '\t')) {
+        ++i;
+    }
+}
+
+inline bool readString(const std::string& s, std::size_t& i, std::string& out) {
+    if (i >= s.size() || s[i] != '"') {
+        return false;
+    }
+    out.clear();
+    for (++i; i < s.size(); ++i) {
+        const char c = s[i];
+        if (c == '"') {
+            ++i;
+            return true;
+        }
+        if (c == '\\' && i + 1 < s.size()) {
+            const char e = s[++i];
+            switch (e) {
+            case 'n': out += '\n'; break;
+            case 't': out += '\t'; break;
+            case 'r': out += '\r'; break;
+            case 'u': out += '?'; i += 4; break;
+            default: out += e; break;
+            }
+        } else {
+            out += c;
+        }
+    }
+    return false;
+}
+
+inline bool readObject(const std::string& s, std::size_t& i, JsonFields& out) {
+    skipSpace(s, i);
+    if (i >= s.size() || s[i] != '{') {
+        return false;
+    }
+    ++i;
+    for (;;) {
+        skipSpace(s, i);
+        if (i < s.size() && s[i] == '}') {
+            ++i;
+            return true;
+        }
+        std::string key;
+        if (!readString(s, i, key)) {
+            return false;
+        }
+        skipSpace(s, i);
+        if (i >= s.size() || s[i] != ':') {
+            return false;
+        }
+        ++i;
+        skipSpace(s, i);
+        std::string value;
+        if (i < s.size() && s[i] == '"') {
+            if (!readString(s, i, value)) {
+                return false;
+            }
+        } else {
+            const std::size_t start = i;
+            while (i < s.size() && s[i] != ',' && s[i] != '}') {
+                ++i;
+            }
+            value = s.substr(start, i - start);
+            while (!value.empty() && (value.back() == ' ' || value.back() == '\n')) {
+                value.pop_back();
+            }
+        }
+        out[key] = value;
+        skipSpace(s, i);
+        if (i < s.size() && s[i] == ',') {
+            ++i;
+        }
+    }
+}
+
+} // namespace tool_json
+
+inline bool parseJsonObject(const std::string& body, JsonFields& out) {
+    std::size_t i = 0;
+    return tool_json::readObject(body, i, out);
+}
+
+inline bool parseJsonArray(const std::string& body, std::vector<JsonFields>& out) {
+    std::size_t i = 0;
+    tool_json::skipSpace(body, i);
+    if (i >= body.size() || body[i] != '[') {
+        return false;
+    }
+    ++i;
+    for (;;) {
+        tool_json::skipSpace(body, i);
+        if (i < body.size() && body[i] == ']') {
+            return true;
+        }
+        JsonFields item;
+        if (!tool_json::readObject(body, i, item)) {
+            return false;
+        }
+        out.push_back(std::move(item));
+        tool_json::skipSpace(body, i);
+        if (i < body.size() && body[i] == ',') {
+            ++i;
+        }
+    }
+}
+
+inline std::string jsonEscape(const std::string& value) {
+    std::string out;
+    for (char c : value) {
+        if (c == '"' || c == '\\') {
+            out += '\\';
+        }
+        out += c;
+    }
+    return out;
+}
+
+// --------------------------------------------------
+// Skewed choice: index i of n is picked with weight 1 / (i + 1)^s, so s = 0
+// is uniform and s = 1 is a classic Zipf "few hot items" distribution.
+// --------------------------------------------------
+class ZipfSampler {
+public:
+    ZipfSampler(std::size_t n, double s) : cdf_(n) {
+        double sum = 0.0;
+        for (std::size_t i = 0; i < n; ++i) {
+            sum += 1.0 / std::pow(static_cast<double>(i + 1), s);
+            cdf_[i] = sum;
+        }
+        for (double& value : cdf_) {
+            value /= sum;
+        }
+    }
+
+    template <typename Rng>
+    std::size_t operator()(Rng& rng) const {
+        const double u = std::uniform_real_distribution<double>(0.0, 1.0)(rng);
+        const auto it = std::lower_bound(cdf_.begin(), cdf_.end(), u);
+        return std::min<std::size_t>(static_cast<std::size_t>(it - cdf_.begin()), cdf_.size() - 1);
+    }
+
+private:
+    std::vector<double> cdf_;
+};
+
+// YYYY-MM-DD, `days` after today (local time), as the schedule page sends it.
+inline std::string localDatePlusDays(int days) {
+    const std::time_t t = std::time(nullptr) + static_cast<std::time_t>(days) * 86400;
+    std::tm tm{};
+#ifdef _WIN32
+    localtime_s(&tm, &t);
+#else
+    localtime_r(&t, &tm);
+#endif
+    char buf[16];
+    std::strftime(buf, sizeof(buf), "%Y-%m-%d", &tm);
+    return buf;
+}
+
+// --------------------------------------------------
+// Latency / outcome counters for one kind of operation, on the same buckets
+// as the server's own metrics so the two can be compared directly.
+// --------------------------------------------------
+struct LatencyStats {
+    uint64_t latency[kLatencyBuckets] = {};
+    uint64_t count = 0;
+    uint64_t failed = 0;   // transport error or 5xx
+    uint64_t unavailable = 0; // 503 (shed or database busy), also counted in failed
+    uint64_t conflict = 0; // 409
+    uint64_t limited = 0;  // 429
+    uint64_t other = 0;    // any other non-2xx
+    uint64_t max_us = 0;
+
+    void record(std::chrono::steady_clock::duration elapsed, int status) {
+        const auto us = std::chrono::duration_cast<std::chrono::microseconds>(elapsed).count();
+        const uint64_t value = us > 0 ? static_cast<uint64_t>(us) : 0;
+        ++latency[latencyBucket(value)];
+        ++count;
+        max_us = std::max(max_us, value);
+        if (status <= 0 || status >= 500) {
+            ++failed;
+            unavailable += status == 503 ? 1 : 0;
+        } else if (status == 409) {
+            ++conflict;
+        } else if (status == 429) {
+            ++limited;
+        } else if (status >= 300) {
+            ++other;
+        }
+    }
+
+    void merge(const LatencyStats& from) {
+        for (int i = 0; i < kLatencyBuckets; ++i) {
+            latency[i] += from.latency[i];
+        }
+        count += from.count;
+        failed += from.failed;
+        unavailable += from.unavailable;
+        conflict += from.conflict;
+        limited += from.limited;
+        other += from.other;
+        max_us = std::max(max_us, from.max_us);
+    }
+
+    // Bucket upper bound, so capped at the largest value actually seen.
+    double quantileMs(double q) const {
+        return static_cast<double>(std::min(latencyQuantile(latency, q), max_us)) / 1000.0;
+    }
+};
+
+inline double percentOf(uint64_t part, uint64_t total) {
+    return total ? 100.0 * static_cast<double>(part) / static_cast<double>(total) : 0.0;
+}
+
+// One table row: name, count, rate, p50/p90/p99/max and outcome percentages.
+inline void printStatsHeader() {
+    std::printf("%-28s %9s %9s %9s %9s %9s %9s %7s %7s %7s %7s\n", "step", "requests", "req/s", "p50 ms",
+                "p90 ms", "p99 ms", "max ms", "err%", "409%", "429%", "4xx%");
+}
+
+inline void printStatsRow(const std::string& name, const LatencyStats& stats, double seconds) {
+    std::printf("%-28s %9llu %9.1f %9.2f %9.2f %9.2f %9.2f %7.2f %7.2f %7.2f %7.2f\n", name.c_str(),
+                static_cast<unsigned long long>(stats.count),
+                seconds > 0 ? static_cast<double>(stats.count) / seconds : 0.0, stats.quantileMs(0.50),
+                stats.quantileMs(0.90), stats.quantileMs(0.99), static_cast<double>(stats.max_us) / 1000.0,
+                percentOf(stats.failed, stats.count), percentOf(stats.conflict, stats.count),
+                percentOf(stats.limited, stats.count), percentOf(stats.other, stats.count));
+}